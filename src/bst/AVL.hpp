@@ -0,0 +1,62 @@
+#ifndef AVL_HPP
+#define AVL_HPP
+#include "BST.hpp"
+#include "BSTNode.hpp"
+using namespace std;
+
+/** Self-balancing BST: the heights of the two subtrees of every node
+ *  differ by at most one, so the height stays below 1.44 log2(n) and
+ *  insert, erase and find are O(log n) even for sorted input. Same
+ *  interface as BST, the iterators are the same.
+ */
+template <typename Data>
+class AVL : public BST<Data> {
+  public:
+    /** Default constructor.
+     *  Initialize an empty AVL tree.
+     */
+    AVL() : BST<Data>() {}
+
+    /** Insert a node in the tree and rebalance it
+     *  return false if the node already exists
+     */
+    bool insert(const Data& item) override {
+        BSTNode<Data>* node = this->insertLeaf(item);
+        if (node == nullptr) {
+            return false;
+        }
+        rebalance(node->parent);
+        return true;
+    }
+
+  protected:
+    /** Rebalance from n up to the root after an erase */
+    void rebalanceFrom(BSTNode<Data>* n) override { rebalance(n); }
+
+    /** Return the height of the left subtree of n minus that of the right */
+    static int balance(BSTNode<Data>* n) {
+        return BST<Data>::nodeHeight(n->left) -
+               BST<Data>::nodeHeight(n->right);
+    }
+
+    /** Update the heights and sizes from n up to the root, rotating every
+     *  node whose subtrees differ in height by two
+     */
+    void rebalance(BSTNode<Data>* n) {
+        while (n != nullptr) {
+            this->update(n);
+            if (balance(n) > 1) {
+                // left-right case: first lift the inner grandchild
+                if (balance(n->left) < 0) this->rotateLeft(n->left);
+                n = this->rotateRight(n);
+            } else if (balance(n) < -1) {
+                if (balance(n->right) > 0) this->rotateRight(n->right);
+                n = this->rotateLeft(n);
+            }
+            n = n->parent;
+        }
+        this->iheight = BST<Data>::nodeHeight(this->root);
+    }
+};
+
+#endif  // AVL_HPP
@@ -1,9 +1,18 @@
 #ifndef BST_HPP
 #define BST_HPP
+#include <string.h>
+#include <algorithm>
 #include <iostream>
+#include <iterator>
+#include <new>
+#include <thread>
+#include <utility>
 #include <vector>
 #include "BSTIterator.hpp"
 #include "BSTNode.hpp"
+#include "BloomFilter.hpp"
+#include "HashIndex.hpp"
+#include "KeyPrefix.hpp"
 using namespace std;
 
 template <typename Data>
@@ -18,6 +27,21 @@ class BST {
     // height of this BST.
     int iheight;
 
+    // storage of erased nodes, reused by later inserts; the first bytes of
+    // each hold the next one
+    void* freeNodes;
+
+    // filter of the items in front of find, nullptr if not used; it may
+    // still hold erased items
+    BloomFilter* filter;
+
+    // hash table from the items to their nodes, nullptr if not used
+    HashIndex<Data>* index;
+
+    // whether Data has a KeyHash; if not, every use of the filter and the
+    // index is compiled out and Data only needs operator<
+    static const bool hashed = KeyHash<Data>::enabled;
+
   public:
     /** Define iterator as an aliased typename for BSTIterator<Data>. */
     typedef BSTIterator<Data> iterator;
@@ -25,13 +49,26 @@ class BST {
     /** Default constructor.
      *  Initialize an empty BST.
      */
-    BST() : root(0), isize(0), iheight(-1) {}
+    BST()
+        : root(0),
+          isize(0),
+          iheight(-1),
+          freeNodes(nullptr),
+          filter(nullptr),
+          index(nullptr) {}
 
     /** Destructor */
     virtual ~BST() {
         deleteAll(root);
         iheight = -1;
         isize = 0;
+        while (freeNodes != nullptr) {
+            void* next = *(void**)freeNodes;
+            ::operator delete(freeNodes);
+            freeNodes = next;
+        }
+        delete filter;
+        delete index;
     }
 
     /** Insert a node in BST
@@ -40,65 +77,333 @@ class BST {
      *  virtual: member function defined on the base class
      */
     virtual bool insert(const Data& item) {
-        BSTNode<Data>* node = new BSTNode<Data>(item);
+        BSTNode<Data>* node = insertLeaf(item);
         if (node == nullptr) {
             return false;
         }
-        // If the tree is empty
-        if (root == nullptr) {
-            root = node;
-            iheight++;
-            isize++;
-            return true;
+        updatePath(node->parent);
+        return true;
+    }
+
+    /** Erase item from BST
+     *  return false if it is not in the BST
+     */
+    bool erase(const Data& item) {
+        BSTNode<Data>* node = findNode(SearchKey<Data>(item));
+        if (node == nullptr) {
+            return false;
         }
-        BSTNode<Data>* curr = root;
-        while ((item < curr->data) || (curr->data < item)) {
-            if (item < curr->data) {
-                if (curr->left == nullptr) {
-                    curr->left = node;
-                    (curr->left)->parent = curr;
-                    iheight = height();
-                    isize++;
-                    return true;
-                } else {
-                    curr = curr->left;
-                }
-            } else if (curr->data < item) {
-                if (curr->right == nullptr) {
-                    curr->right = node;
-                    (curr->right)->parent = curr;
-                    iheight = height();
-                    isize++;
-                    return true;
-                } else {
-                    curr = curr->right;
-                }
-            }
+        erase(iterator(node, &root));
+        return true;
+    }
+
+    /** Erase the item at pos, which must not be end(). Return an iterator
+     *  at the next item. Other iterators stay valid. The node is kept for
+     *  reuse by a later insert instead of being freed.
+     */
+    iterator erase(iterator pos) {
+        BSTNode<Data>* node = pos.curr;
+        BSTNode<Data>* next = node->successor();
+        if (hashed && index != nullptr) index->erase(node);
+        rebalanceFrom(unlink(node));
+        recycle(node);
+        return iterator(next, &root);
+    }
+
+    /** Keep the items less than item in BST and move the items greater
+     *  than item into greater, replacing its content. Return true if item
+     *  was in BST; it is in neither tree after the split. O(height).
+     */
+    bool split(const Data& item, BST<Data>& greater) {
+        if (&greater == this) return false;
+        greater.clear();
+        BSTNode<Data>* less;
+        BSTNode<Data>* found;
+        BSTNode<Data>* more;
+        splitNode(root, SearchKey<Data>(item), less, found, more);
+        setRoot(less);
+        greater.setRoot(more);
+        greater.refillFilter();
+        refillIndex();
+        greater.refillIndex();
+        if (found == nullptr) return false;
+        recycle(found);
+        return true;
+    }
+
+    /** Move the items of greater, which must all be greater than every
+     *  item of BST, to the end of BST, leaving greater empty.
+     *  O(height difference) when both trees are balanced.
+     */
+    void join(BST<Data>& greater) {
+        if (&greater == this) return;
+        filterAll(greater.root);
+        setRoot(join2(root, greater.root));
+        greater.setRoot(nullptr);
+        refillIndex();
+        greater.refillIndex();
+    }
+
+    /** Make BST the union of itself and other, moving the nodes of other
+     *  and leaving it empty. Built on split and join: for balanced trees
+     *  of sizes m <= n this takes O(m log(n/m + 1)) instead of the
+     *  O(m log n) of m inserts, and the result is balanced. Large trees
+     *  are combined on numThreads threads (0: one per core).
+     */
+    void setUnion(BST<Data>& other, unsigned int numThreads = 0) {
+        if (&other == this) return;
+        filterAll(other.root);
+        setRoot(unionOf(root, other.root, threadCount(numThreads)));
+        other.setRoot(nullptr);
+        refillIndex();
+        other.refillIndex();
+    }
+
+    /** Make BST the intersection of itself and other, leaving other empty.
+     *  Same cost as setUnion().
+     */
+    void setIntersection(BST<Data>& other, unsigned int numThreads = 0) {
+        if (&other == this) return;
+        setRoot(intersectionOf(root, other.root, threadCount(numThreads)));
+        other.setRoot(nullptr);
+        refillIndex();
+        other.refillIndex();
+    }
+
+    /** Remove the items of other from BST, leaving other empty. Same cost
+     *  as setUnion().
+     */
+    void setDifference(BST<Data>& other, unsigned int numThreads = 0) {
+        if (&other == this) {
+            clear();
+            return;
         }
-        delete node;
-        return false;
+        setRoot(differenceOf(root, other.root, threadCount(numThreads)));
+        other.setRoot(nullptr);
+        refillIndex();
+        other.refillIndex();
+    }
+
+    /** Erase every item */
+    void clear() {
+        deleteAll(root);
+        setRoot(nullptr);
+        if (filter != nullptr) filter->clear();
+        if (index != nullptr) index->clear();
+    }
+
+    /** Keep a blocked Bloom filter of the items, so that find answers
+     *  most misses from one cache line without searching the tree; about
+     *  falsePositiveRate of the misses are still searched. The filter
+     *  follows inserts and grows with the BST. Erased items stay in it
+     *  until it is rebuilt. A rate of 0 removes the filter. Data needs a
+     *  KeyHash.
+     */
+    void useFilter(double falsePositiveRate) {
+        static_assert(hashed, "the filter needs a KeyHash for Data");
+        delete filter;
+        filter = nullptr;
+        if (falsePositiveRate <= 0 || falsePositiveRate >= 1) return;
+        // small filters would be rebuilt often while the BST grows
+        filter = new BloomFilter(1024, falsePositiveRate);
+        refillFilter();
+    }
+
+    /** Replace the content of BST with the items in [first, last), which
+     *  may be in any order and hold duplicates, and build a perfectly
+     *  balanced tree from them in O(n) after sorting. Input that is already
+     *  sorted is not sorted again; large inputs are sorted on numThreads
+     *  threads (0: one per core).
+     */
+    template <typename InputIterator>
+    void build(InputIterator first, InputIterator last,
+               unsigned int numThreads = 0) {
+        vector<Data> items(first, last);
+        if (!is_sorted(items.begin(), items.end())) {
+            parallelSort(items, numThreads);
+        }
+        // items are sorted, equal items are next to each other
+        items.erase(unique(items.begin(), items.end(),
+                           [](const Data& a, const Data& b) {
+                               return !(a < b);
+                           }),
+                    items.end());
+        deleteAll(root);
+        root = buildBalanced(items, 0, items.size(), nullptr);
+        isize = items.size();
+        iheight = nodeHeight(root);
+        refillFilter();
+        refillIndex();
+    }
+
+    /** Keep a hash index from the items to their nodes, or remove it if
+     *  on is false. find then takes O(1) expected instead of O(height) and
+     *  returns the same iterators. The index follows inserts and erases;
+     *  split, join and the set operations rebuild it in O(n). It takes 9
+     *  bytes per slot, kept between 0.35 and 0.7 full: 13 to 26 bytes per
+     *  item. Data needs a KeyHash.
+     */
+    void useHashIndex(bool on) {
+        static_assert(hashed, "the hash index needs a KeyHash for Data");
+        delete index;
+        index = nullptr;
+        if (!on) return;
+        index = new HashIndex<Data>(isize);
+        refillIndex();
+    }
+
+    /** Return the bytes taken by the hash index, 0 without one */
+    size_t hashIndexBytes() const {
+        return index == nullptr ? 0 : index->bytes();
     }
 
     /** Find a data item in BST */
     virtual iterator find(const Data& item) const {
+        return iterator(lookupNode(item), &root);
+    }
+
+    /** Find a string in BST<string> without constructing a string */
+    iterator find(const char* item) const { return find(item, strlen(item)); }
+
+    /** Find the string of len characters at item in BST<string> without
+     *  constructing a string
+     */
+    iterator find(const char* item, size_t len) const {
+        return iterator(lookupNode(item, len), &root);
+    }
+
+    /** Return the first item that is not less than item, or end() */
+    iterator lower_bound(const Data& item) const {
+        return iterator(boundNode(SearchKey<Data>(item), false), &root);
+    }
+
+    /** Return the first item that is greater than item, or end() */
+    iterator upper_bound(const Data& item) const {
+        return iterator(boundNode(SearchKey<Data>(item), true), &root);
+    }
+
+    /** Return the range of items equal to item: empty, or item alone */
+    pair<iterator, iterator> equal_range(const Data& item) const {
+        iterator first = lower_bound(item);
+        iterator last = first;
+        if (first != end() && !(item < *first)) ++last;
+        return make_pair(first, last);
+    }
+
+    /** Call visit with every item from lo up to but not including hi, in
+     *  order. Only the O(log n + k) nodes on the way to lo and in the range
+     *  are visited.
+     */
+    template <typename Visitor>
+    void scan(const Data& lo, const Data& hi, Visitor visit) const {
+        SearchKey<Data> last(hi);
+        for (BSTNode<Data>* n = boundNode(SearchKey<Data>(lo), false);
+             n != nullptr && last.compare(n->data, *n) > 0;
+             n = n->successor()) {
+            visit(n->data);
+        }
+    }
+
+    /** Return, in order, the first limit strings of BST<string> that start
+     *  with prefix. The first match is found in O(height) and each further
+     *  one is its successor, so a call costs O(height + limit).
+     */
+    vector<Data> prefixSearch(const string& prefix, unsigned int limit) const {
+        return prefixSearch(prefix.data(), prefix.size(), limit);
+    }
+
+    /** Return the first limit strings that start with the len characters
+     *  at prefix, without constructing a string
+     */
+    vector<Data> prefixSearch(const char* prefix, size_t len,
+                              unsigned int limit) const {
+        vector<Data> matches;
+        for (BSTNode<Data>* n = boundNode(SearchKey<Data>(prefix, len), false);
+             n != nullptr && matches.size() < limit &&
+             n->data.size() >= len &&
+             memcmp(n->data.data(), prefix, len) == 0;
+             n = n->successor()) {
+            matches.push_back(n->data);
+        }
+        return matches;
+    }
+
+    /** Find every item of queries, setting results[i] to what find would
+     *  return for queries[i]. The lookups advance in groups, one level at a
+     *  time each, and the next node of every lookup is prefetched so that
+     *  the cache misses of a group overlap. Large batches are split across
+     *  numThreads threads (0: one per core).
+     */
+    void findBatch(const vector<Data>& queries, vector<iterator>& results,
+                   unsigned int numThreads = 0) const {
+        // lookups smaller than this are not worth a thread
+        const size_t MIN_PER_THREAD = 1 << 14;
+
+        results.assign(queries.size(), end());
+        if (numThreads == 0) {
+            numThreads = max(1u, thread::hardware_concurrency());
+        }
+        size_t numChunks =
+            min<size_t>(numThreads, queries.size() / MIN_PER_THREAD);
+        if (numChunks <= 1) {
+            findGroups(queries, results, 0, queries.size());
+            return;
+        }
+        vector<thread> workers;
+        for (size_t i = 0; i < numChunks; i++) {
+            size_t start = queries.size() * i / numChunks;
+            size_t stop = queries.size() * (i + 1) / numChunks;
+            workers.emplace_back([this, &queries, &results, start, stop] {
+                findGroups(queries, results, start, stop);
+            });
+        }
+        for (thread& worker : workers) worker.join();
+    }
+
+    /** Return the number of items less than item, which is the position
+     *  of item if it is in the BST. O(height) using the subtree sizes.
+     */
+    unsigned int rank(const Data& item) const {
+        SearchKey<Data> key(item);
+        unsigned int less = 0;
         BSTNode<Data>* curr = root;
-        // avoid segfault by change the sequence of boolean expression
-        while ((curr != nullptr) &&
-               ((item < curr->data) || (curr->data < item))) {
-            if (item < curr->data) {
+        while (curr != nullptr) {
+            int order = key.compare(curr->data, *curr);
+            if (order <= 0) {
                 curr = curr->left;
-            } else if (curr->data < item) {
+            } else {
+                less += nodeSize(curr->left) + 1;
                 curr = curr->right;
             }
         }
-        return BST<Data>::iterator(curr);
+        return less;
+    }
+
+    /** Return an iterator at the item with position i in order, counting
+     *  from 0, or end() if i is not less than size(). O(height) using the
+     *  subtree sizes; iterating on from it lists items i, i + 1, ...
+     */
+    iterator select(unsigned int i) const {
+        BSTNode<Data>* curr = root;
+        while (curr != nullptr) {
+            unsigned int leftSize = nodeSize(curr->left);
+            if (i < leftSize) {
+                curr = curr->left;
+            } else if (i == leftSize) {
+                break;
+            } else {
+                i -= leftSize + 1;
+                curr = curr->right;
+            }
+        }
+        return iterator(curr, &root);
     }
 
     /** Return the size of BST */
     unsigned int size() const { return isize; }
 
-    /** Return the size of BST */
-    int height() const { return height_helper(root); }
+    /** Return the height of BST, kept up to date by insert */
+    int height() const { return iheight; }
 
     /** Return true if BST is empty */
     bool empty() const {
@@ -109,11 +414,11 @@ class BST {
     }
 
     /** Return the first node of BST */
-    iterator begin() const { return BST::iterator(first(root)); }
+    iterator begin() const { return BST::iterator(first(root), &root); }
 
     /** Return an iterator pointing past the last item in the BST.
      */
-    iterator end() const { return typename BST<Data>::iterator(0); }
+    iterator end() const { return typename BST<Data>::iterator(0, &root); }
 
     /** Inorder traversal tree to an vector
      * for debugging
@@ -124,7 +429,586 @@ class BST {
         return vec;
     }
 
+  protected:
+    /** Link a new leaf holding item below the node where the search for it
+     *  ends. Return the new leaf, or nullptr if item is already in the BST.
+     *  Heights and sizes above the leaf are not updated, see updatePath().
+     */
+    BSTNode<Data>* insertLeaf(const Data& item) {
+        SearchKey<Data> key(item);
+        BSTNode<Data>* parent = nullptr;
+        BSTNode<Data>* curr = root;
+        int order = 0;
+        while (curr != nullptr) {
+            parent = curr;
+            order = key.compare(curr->data, *curr);
+            if (order == 0) return nullptr;
+            curr = order < 0 ? curr->left : curr->right;
+        }
+        BSTNode<Data>* node = newNode(item);
+        node->parent = parent;
+        if (parent == nullptr) {
+            root = node;
+        } else if (order < 0) {
+            parent->left = node;
+        } else {
+            parent->right = node;
+        }
+        isize++;
+        if (hashed && filter != nullptr) addToFilter(node->data);
+        if (hashed && index != nullptr) index->insert(node);
+        return node;
+    }
+
+    /** Return the node holding item, or nullptr, through the hash index or
+     *  the filter if there are any
+     */
+    BSTNode<Data>* lookupNode(const Data& item) const {
+        if (hashed && index != nullptr) {
+            return index->find(SearchKey<Data>(item), KeyHash<Data>()(item));
+        }
+        if (hashed && filter != nullptr &&
+            !filter->mayContain(KeyHash<Data>()(item))) {
+            return nullptr;
+        }
+        return findNode(SearchKey<Data>(item));
+    }
+
+    /** Return the node holding the string of len characters at item, or
+     *  nullptr, through the hash index or the filter if there are any
+     */
+    BSTNode<Data>* lookupNode(const char* item, size_t len) const {
+        if (hashed && index != nullptr) {
+            return index->find(SearchKey<Data>(item, len),
+                               hashBytes(item, len));
+        }
+        if (hashed && filter != nullptr &&
+            !filter->mayContain(hashBytes(item, len))) {
+            return nullptr;
+        }
+        return findNode(SearchKey<Data>(item, len));
+    }
+
+    /** Return the node holding key, or nullptr */
+    BSTNode<Data>* findNode(const SearchKey<Data>& key) const {
+        BSTNode<Data>* curr = root;
+        while (curr != nullptr) {
+            int order = key.compare(curr->data, *curr);
+            if (order == 0) break;
+            curr = order < 0 ? curr->left : curr->right;
+        }
+        return curr;
+    }
+
+    /** Return the first node not less than key, or greater than key if
+     *  upper is true. Return nullptr if there is none.
+     */
+    BSTNode<Data>* boundNode(const SearchKey<Data>& key, bool upper) const {
+        BSTNode<Data>* bound = nullptr;
+        BSTNode<Data>* curr = root;
+        while (curr != nullptr) {
+            int order = key.compare(curr->data, *curr);
+            if (order < 0 || (order == 0 && !upper)) {
+                bound = curr;
+                curr = curr->left;
+            } else {
+                curr = curr->right;
+            }
+        }
+        return bound;
+    }
+
+    /** Return the height of the subtree rooted at n, -1 if n is null */
+    static int nodeHeight(BSTNode<Data>* n) {
+        return n == nullptr ? -1 : n->height;
+    }
+
+    /** Return the number of nodes in the subtree rooted at n */
+    static unsigned int nodeSize(BSTNode<Data>* n) {
+        return n == nullptr ? 0 : n->size;
+    }
+
+    /** Recompute the height and size of n from its children */
+    static void update(BSTNode<Data>* n) {
+        n->height = max(nodeHeight(n->left), nodeHeight(n->right)) + 1;
+        n->size = nodeSize(n->left) + nodeSize(n->right) + 1;
+    }
+
+    /** Update every node from n up to the root, and the BST height */
+    void updatePath(BSTNode<Data>* n) {
+        for (; n != nullptr; n = n->parent) {
+            update(n);
+        }
+        iheight = nodeHeight(root);
+    }
+
+    /** Update the nodes from n up to the root after a change below n.
+     *  Balanced variants rotate on the way.
+     */
+    virtual void rebalanceFrom(BSTNode<Data>* n) { updatePath(n); }
+
+    /** Take node out of the tree, keeping the order of the others: a node
+     *  with two children is replaced by its successor. Return the lowest
+     *  node whose subtree changed, nullptr if that is the whole tree.
+     */
+    BSTNode<Data>* unlink(BSTNode<Data>* node) {
+        BSTNode<Data>* start;
+        if (node->left == nullptr || node->right == nullptr) {
+            BSTNode<Data>* child =
+                node->left != nullptr ? node->left : node->right;
+            start = node->parent;
+            replaceChild(node->parent, node, child);
+        } else {
+            // the successor has no left child, move it into node's place
+            BSTNode<Data>* next = node->right;
+            while (next->left != nullptr) next = next->left;
+            if (next->parent != node) {
+                start = next->parent;
+                replaceChild(next->parent, next, next->right);
+                next->right = node->right;
+                next->right->parent = next;
+            } else {
+                start = next;
+            }
+            next->left = node->left;
+            next->left->parent = next;
+            replaceChild(node->parent, node, next);
+        }
+        isize--;
+        return start;
+    }
+
+    /** Return a new node holding item, in the storage of an erased node if
+     *  there is one
+     */
+    BSTNode<Data>* newNode(const Data& item) {
+        if (freeNodes == nullptr) return new BSTNode<Data>(item);
+        void* storage = freeNodes;
+        void* next = *(void**)storage;
+        BSTNode<Data>* node = new (storage) BSTNode<Data>(item);
+        freeNodes = next;
+        return node;
+    }
+
+    /** Destroy node and keep its storage for newNode() */
+    void recycle(BSTNode<Data>* node) {
+        node->~BSTNode<Data>();
+        void* storage = node;
+        *(void**)storage = freeNodes;
+        freeNodes = storage;
+    }
+
+    /** Put child in the place of oldChild below parent, or at the root if
+     *  parent is null
+     */
+    void replaceChild(BSTNode<Data>* parent, BSTNode<Data>* oldChild,
+                      BSTNode<Data>* child) {
+        if (parent == nullptr) {
+            root = child;
+        } else if (parent->left == oldChild) {
+            parent->left = child;
+        } else {
+            parent->right = child;
+        }
+        if (child != nullptr) child->parent = parent;
+    }
+
+    /** Rotate the subtree rooted at n to the left, lifting its right child
+     *  into its place. Return the new root of the subtree.
+     */
+    BSTNode<Data>* rotateLeft(BSTNode<Data>* n) {
+        BSTNode<Data>* r = n->right;
+        n->right = r->left;
+        if (r->left != nullptr) r->left->parent = n;
+        replaceChild(n->parent, n, r);
+        r->left = n;
+        n->parent = r;
+        update(n);
+        update(r);
+        return r;
+    }
+
+    /** Rotate the subtree rooted at n to the right, lifting its left child
+     *  into its place. Return the new root of the subtree.
+     */
+    BSTNode<Data>* rotateRight(BSTNode<Data>* n) {
+        BSTNode<Data>* l = n->left;
+        n->left = l->right;
+        if (l->right != nullptr) l->right->parent = n;
+        replaceChild(n->parent, n, l);
+        l->right = n;
+        n->parent = l;
+        update(n);
+        update(l);
+        return l;
+    }
+
   private:
+    /** Find queries[start, stop) for findBatch(), in groups of lookups
+     *  that take turns descending one level
+     */
+    void findGroups(const vector<Data>& queries, vector<iterator>& results,
+                    size_t start, size_t stop) const {
+        // enough lookups in flight to keep the memory system busy
+        const size_t GROUP = 16;
+
+        BSTNode<Data>* curr[GROUP];
+        // keys of the group, made once for all the levels
+        vector<SearchKey<Data>> keys;
+        keys.reserve(GROUP);
+        for (size_t first = start; first < stop; first += GROUP) {
+            size_t count = min(GROUP, stop - first);
+            keys.clear();
+            for (size_t i = 0; i < count; i++) {
+                keys.emplace_back(queries[first + i]);
+                curr[i] = root;
+            }
+            bool active = root != nullptr;
+            while (active) {
+                active = false;
+                for (size_t i = 0; i < count; i++) {
+                    BSTNode<Data>* n = curr[i];
+                    if (n == nullptr) continue;
+                    int order = keys[i].compare(n->data, *n);
+                    if (order == 0) {
+                        results[first + i] = iterator(n, &root);
+                        n = nullptr;
+                    } else {
+                        n = order < 0 ? n->left : n->right;
+                    }
+                    if (n != nullptr) {
+#ifdef __GNUC__
+                        __builtin_prefetch(n);
+#endif
+                        active = true;
+                    }
+                    curr[i] = n;
+                }
+            }
+        }
+    }
+
+    /** Sort items, in chunks on numThreads threads (0: one per core) that
+     *  are then merged pairwise, if there are enough of them
+     */
+    static void parallelSort(vector<Data>& items, unsigned int numThreads) {
+        // chunks smaller than this are not worth a thread
+        const size_t MIN_CHUNK = 1 << 14;
+
+        if (numThreads == 0) {
+            numThreads = max(1u, thread::hardware_concurrency());
+        }
+        size_t numChunks = min<size_t>(numThreads, items.size() / MIN_CHUNK);
+        if (numChunks <= 1) {
+            sort(items.begin(), items.end());
+            return;
+        }
+        vector<size_t> bounds;
+        for (size_t i = 0; i <= numChunks; i++) {
+            bounds.push_back(items.size() * i / numChunks);
+        }
+        vector<thread> workers;
+        for (size_t i = 0; i < numChunks; i++) {
+            workers.emplace_back([&items, &bounds, i] {
+                sort(items.begin() + bounds[i], items.begin() + bounds[i + 1]);
+            });
+        }
+        for (thread& worker : workers) worker.join();
+        // merge neighbouring runs until one is left
+        for (size_t width = 1; width < numChunks; width *= 2) {
+            workers.clear();
+            for (size_t i = 0; i + width < numChunks; i += 2 * width) {
+                size_t mid = bounds[i + width];
+                size_t end = bounds[min(i + 2 * width, numChunks)];
+                workers.emplace_back([&items, &bounds, i, mid, end] {
+                    inplace_merge(items.begin() + bounds[i],
+                                  items.begin() + mid, items.begin() + end);
+                });
+            }
+            for (thread& worker : workers) worker.join();
+        }
+    }
+
+    /** Build a perfectly balanced subtree of the sorted items in
+     *  [start, end) below parent, moving the items into the nodes. Return
+     *  its root.
+     */
+    static BSTNode<Data>* buildBalanced(vector<Data>& items,
+                                        size_t start, size_t end,
+                                        BSTNode<Data>* parent) {
+        if (start == end) return nullptr;
+        size_t mid = start + (end - start) / 2;
+        BSTNode<Data>* node = new BSTNode<Data>(move(items[mid]));
+        node->parent = parent;
+        node->left = buildBalanced(items, start, mid, node);
+        node->right = buildBalanced(items, mid + 1, end, node);
+        update(node);
+        return node;
+    }
+
+    /** Add item to the filter, first rebuilding it for twice the items
+     *  once it is full
+     */
+    void addToFilter(const Data& item) {
+        // full of added items, some of them maybe erased since
+        if (filter->size() >= filter->capacity()) {
+            rebuildFilter(2 * isize);
+        } else {
+            filter->add(KeyHash<Data>()(item));
+        }
+    }
+
+    /** Add every item of the tree rooted at n to the filter */
+    void filterAll(BSTNode<Data>* n) {
+        if (!hashed || filter == nullptr) return;
+        size_t count = nodeSize(n);
+        if (filter->size() + count > filter->capacity()) {
+            rebuildFilter(2 * (isize + count));
+        }
+        for (BSTNode<Data>* curr = first(n); curr != nullptr;
+             curr = curr->successor()) {
+            filter->add(KeyHash<Data>()(curr->data));
+        }
+    }
+
+    /** Refill the filter with the items, if there is one, dropping erased
+     *  items and growing it if the items do not fit
+     */
+    void refillFilter() {
+        if (!hashed || filter == nullptr) return;
+        rebuildFilter(max<size_t>(filter->capacity(), 2 * isize));
+    }
+
+    /** Refill the hash index with the items, if there is one */
+    void refillIndex() {
+        if (!hashed || index == nullptr) return;
+        index->clear();
+        for (BSTNode<Data>* n = first(root); n != nullptr; n = n->successor()) {
+            index->insert(n);
+        }
+    }
+
+    /** Replace the filter with one for capacity items holding the items */
+    void rebuildFilter(size_t capacity) {
+        double rate = filter->falsePositiveRate();
+        delete filter;
+        filter = new BloomFilter(capacity, rate);
+        for (BSTNode<Data>* n = first(root); n != nullptr; n = n->successor()) {
+            filter->add(KeyHash<Data>()(n->data));
+        }
+    }
+
+    /** Make n, a detached subtree, the whole tree */
+    void setRoot(BSTNode<Data>* n) {
+        root = n;
+        if (n != nullptr) n->parent = nullptr;
+        isize = nodeSize(n);
+        iheight = nodeHeight(n);
+    }
+
+    /** Return numThreads, or the number of cores if it is 0 */
+    static unsigned int threadCount(unsigned int numThreads) {
+        return numThreads != 0 ? numThreads
+                               : max(1u, thread::hardware_concurrency());
+    }
+
+    /** Make left and right the subtrees of node, which becomes the root
+     *  of a detached subtree, and return node
+     */
+    static BSTNode<Data>* attach(BSTNode<Data>* left, BSTNode<Data>* node,
+                                 BSTNode<Data>* right) {
+        node->left = left;
+        node->right = right;
+        node->parent = nullptr;
+        if (left != nullptr) left->parent = node;
+        if (right != nullptr) right->parent = node;
+        update(node);
+        return node;
+    }
+
+    /** Rotate the detached subtree rooted at n to the left */
+    static BSTNode<Data>* liftRight(BSTNode<Data>* n) {
+        BSTNode<Data>* r = n->right;
+        return attach(attach(n->left, n, r->left), r, r->right);
+    }
+
+    /** Rotate the detached subtree rooted at n to the right */
+    static BSTNode<Data>* liftLeft(BSTNode<Data>* n) {
+        BSTNode<Data>* l = n->left;
+        return attach(l->left, l, attach(l->right, n, n->right));
+    }
+
+    /** Join left, node and right, where left holds the smaller items and
+     *  right the greater ones, into one subtree. node goes down the spine of
+     *  the taller tree to where the heights meet, and rotations on the way
+     *  back up keep every node AVL balanced if left and right are.
+     */
+    static BSTNode<Data>* join(BSTNode<Data>* left, BSTNode<Data>* node,
+                               BSTNode<Data>* right) {
+        int leftHeight = nodeHeight(left);
+        int rightHeight = nodeHeight(right);
+        if (leftHeight > rightHeight + 1) {
+            BSTNode<Data>* joined = join(left->right, node, right);
+            if (nodeHeight(joined) > nodeHeight(left->left) + 1 &&
+                nodeHeight(joined->left) > nodeHeight(joined->right)) {
+                joined = liftLeft(joined);
+            }
+            joined = attach(left->left, left, joined);
+            return balance(joined) < -1 ? liftRight(joined) : joined;
+        }
+        if (rightHeight > leftHeight + 1) {
+            BSTNode<Data>* joined = join(left, node, right->left);
+            if (nodeHeight(joined) > nodeHeight(right->right) + 1 &&
+                nodeHeight(joined->right) > nodeHeight(joined->left)) {
+                joined = liftRight(joined);
+            }
+            joined = attach(joined, right, right->right);
+            return balance(joined) > 1 ? liftLeft(joined) : joined;
+        }
+        return attach(left, node, right);
+    }
+
+    /** Join left and right without a node between them */
+    static BSTNode<Data>* join2(BSTNode<Data>* left, BSTNode<Data>* right) {
+        if (left == nullptr) return right;
+        if (right == nullptr) return left;
+        BSTNode<Data>* last;
+        BSTNode<Data>* rest = splitLast(left, last);
+        return join(rest, last, right);
+    }
+
+    /** Take the last node out of the detached subtree n, setting last to
+     *  it, and return the rest
+     */
+    static BSTNode<Data>* splitLast(BSTNode<Data>* n, BSTNode<Data>*& last) {
+        if (n->right == nullptr) {
+            last = n;
+            if (n->left != nullptr) n->left->parent = nullptr;
+            return n->left;
+        }
+        BSTNode<Data>* rest = splitLast(n->right, last);
+        return join(n->left, n, rest);
+    }
+
+    /** Split the detached subtree n into the subtrees less and greater of
+     *  the items less and greater than key, and the node found holding key
+     *  or nullptr
+     */
+    static void splitNode(BSTNode<Data>* n, const SearchKey<Data>& key,
+                          BSTNode<Data>*& less, BSTNode<Data>*& found,
+                          BSTNode<Data>*& greater) {
+        if (n == nullptr) {
+            less = found = greater = nullptr;
+            return;
+        }
+        BSTNode<Data>* left = n->left;
+        BSTNode<Data>* right = n->right;
+        if (left != nullptr) left->parent = nullptr;
+        if (right != nullptr) right->parent = nullptr;
+        int order = key.compare(n->data, *n);
+        if (order == 0) {
+            less = left;
+            found = n;
+            greater = right;
+        } else if (order < 0) {
+            splitNode(left, key, less, found, greater);
+            greater = join(greater, n, right);
+        } else {
+            splitNode(right, key, less, found, greater);
+            less = join(left, n, less);
+        }
+    }
+
+    /** Return the height of the left subtree of n minus that of the right */
+    static int balance(BSTNode<Data>* n) {
+        return nodeHeight(n->left) - nodeHeight(n->right);
+    }
+
+    /** Split b by the item of the root of a, then call combine on the
+     *  left subtree of a with the smaller part of b and on the right
+     *  subtree with the greater part, on two threads if the trees are large
+     *  and numThreads allows. Return the node of b equal to the root of a,
+     *  or nullptr.
+     */
+    template <typename Combine>
+    static BSTNode<Data>* divide(BSTNode<Data>* a, BSTNode<Data>* b,
+                                 unsigned int numThreads, Combine combine,
+                                 BSTNode<Data>*& left, BSTNode<Data>*& right) {
+        // subtrees smaller than this are not worth a thread
+        const unsigned int MIN_PER_THREAD = 1 << 14;
+
+        BSTNode<Data>* bLess;
+        BSTNode<Data>* found;
+        BSTNode<Data>* bGreater;
+        splitNode(b, SearchKey<Data>(a->data), bLess, found, bGreater);
+        BSTNode<Data>* aLeft = a->left;
+        BSTNode<Data>* aRight = a->right;
+        if (aLeft != nullptr) aLeft->parent = nullptr;
+        if (aRight != nullptr) aRight->parent = nullptr;
+        if (numThreads > 1 &&
+            nodeSize(aLeft) + nodeSize(bLess) >= MIN_PER_THREAD &&
+            nodeSize(aRight) + nodeSize(bGreater) >= MIN_PER_THREAD) {
+            unsigned int leftThreads = numThreads / 2;
+            thread worker([&] {
+                left = combine(aLeft, bLess, leftThreads);
+            });
+            right = combine(aRight, bGreater, numThreads - leftThreads);
+            worker.join();
+        } else {
+            left = combine(aLeft, bLess, 1);
+            right = combine(aRight, bGreater, 1);
+        }
+        return found;
+    }
+
+    /** Return the union of the detached subtrees a and b */
+    static BSTNode<Data>* unionOf(BSTNode<Data>* a, BSTNode<Data>* b,
+                                  unsigned int numThreads) {
+        if (a == nullptr) return b;
+        if (b == nullptr) return a;
+        BSTNode<Data>* left;
+        BSTNode<Data>* right;
+        delete divide(a, b, numThreads, unionOf, left, right);
+        return join(left, a, right);
+    }
+
+    /** Return the intersection of the detached subtrees a and b */
+    static BSTNode<Data>* intersectionOf(BSTNode<Data>* a, BSTNode<Data>* b,
+                                         unsigned int numThreads) {
+        if (a == nullptr || b == nullptr) {
+            deleteAll(a);
+            deleteAll(b);
+            return nullptr;
+        }
+        BSTNode<Data>* left;
+        BSTNode<Data>* right;
+        BSTNode<Data>* found =
+            divide(a, b, numThreads, intersectionOf, left, right);
+        if (found == nullptr) {
+            delete a;
+            return join2(left, right);
+        }
+        delete found;
+        return join(left, a, right);
+    }
+
+    /** Return the items of the detached subtree a that are not in b */
+    static BSTNode<Data>* differenceOf(BSTNode<Data>* a, BSTNode<Data>* b,
+                                       unsigned int numThreads) {
+        if (a == nullptr || b == nullptr) {
+            deleteAll(b);
+            return a;
+        }
+        BSTNode<Data>* left;
+        BSTNode<Data>* right;
+        BSTNode<Data>* found =
+            divide(a, b, numThreads, differenceOf, left, right);
+        if (found == nullptr) return join(left, a, right);
+        delete found;
+        delete a;
+        return join2(left, right);
+    }
+
     /** Find the first item of BST */
     static BSTNode<Data>* first(BSTNode<Data>* root) {
         // root is nullptr
@@ -160,17 +1044,6 @@ class BST {
         vec.push_back(n->data);
         inorder_helper(n->right, vec);
     }
-
-    /** Helper method for height() */
-    static int height_helper(BSTNode<Data>* n) {
-        if (n == nullptr) return -1;
-        int left_height = height_helper(n->left);
-        int right_height = height_helper(n->right);
-        if (left_height > right_height)
-            return left_height + 1;
-        else
-            return right_height + 1;
-    }
 };
 
 #endif  // BST_HPP
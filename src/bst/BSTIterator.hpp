@@ -1,23 +1,38 @@
 #ifndef BSTITERATOR_HPP
 #define BSTITERATOR_HPP
+#include <cstddef>
 #include <iterator>
 #include <list>
 #include "BSTNode.hpp"
 using namespace std;
 
 template <typename Data>
-class BSTIterator : public iterator<input_iterator_tag, Data> {
+class BST;
+
+template <typename Data>
+class BSTIterator : public iterator<bidirectional_iterator_tag, Data,
+                                   ptrdiff_t, const Data*, const Data&> {
   private:
     BSTNode<Data>* curr;
 
+    // root of the tree, to step back from the end; may be null
+    BSTNode<Data>* const* root;
+
+    friend class BST<Data>;
+
   public:
     /** Constructor that initialize the current BSTNode
-     *  in this BSTIterator.
+     *  in this BSTIterator. Decrementing the end iterator needs the
+     *  location of the root of the tree.
      */
-    BSTIterator(BSTNode<Data>* curr) : curr(curr) {}
+    BSTIterator(BSTNode<Data>* curr, BSTNode<Data>* const* root = nullptr)
+        : curr(curr), root(root) {}
+
+    /** Dereference operator, the data is not copied. */
+    const Data& operator*() const { return curr->data; }
 
-    /** Dereference operator. */
-    Data operator*() const { return curr->data; }
+    /** Member access operator. */
+    const Data* operator->() const { return &curr->data; }
 
     /** Pre-increment operator. */
     BSTIterator<Data>& operator++() {
@@ -27,11 +42,31 @@ class BSTIterator : public iterator<input_iterator_tag, Data> {
 
     /** Post-increment operator. */
     BSTIterator<Data> operator++(int) {
-        BSTIterator before = BSTIterator(curr);
+        BSTIterator before = *this;
         ++(*this);
         return before;
     }
 
+    /** Pre-decrement operator. Decrementing the end iterator gives the
+     *  last item.
+     */
+    BSTIterator<Data>& operator--() {
+        if (curr != nullptr) {
+            curr = curr->predecessor();
+        } else if (root != nullptr && *root != nullptr) {
+            curr = *root;
+            while (curr->right != nullptr) curr = curr->right;
+        }
+        return *this;
+    }
+
+    /** Post-decrement operator. */
+    BSTIterator<Data> operator--(int) {
+        BSTIterator before = *this;
+        --(*this);
+        return before;
+    }
+
     /** Compare two iterators
      *  true: if two iterators both hold a pointer to the same BSTNode
      *  false: not the same pointer
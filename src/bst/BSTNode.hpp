@@ -2,15 +2,19 @@
 #define BSTNODE_HPP
 #include <iomanip>
 #include <iostream>
+#include <utility>
+#include "KeyPrefix.hpp"
 using namespace std;
 
 template <typename Data>
 
-class BSTNode {
+class BSTNode : public NodeKey<Data> {
   public:
     BSTNode<Data>* left;
     BSTNode<Data>* right;
     BSTNode<Data>* parent;
+    int height;       // height of the subtree rooted at this node.
+    unsigned int size;  // number of nodes in the subtree rooted here.
     Data const data;  // the const Data in this node.
 
     /** Initialize BSTNode with data, no children and parent
@@ -20,6 +24,19 @@ class BSTNode {
         left = nullptr;
         right = nullptr;
         parent = nullptr;
+        height = 0;
+        size = 1;
+        this->setKey(data);
+    }
+
+    /** Initialize BSTNode with data moved from d */
+    BSTNode(Data&& d) : data(move(d)) {
+        left = nullptr;
+        right = nullptr;
+        parent = nullptr;
+        height = 0;
+        size = 1;
+        this->setKey(data);
     }
 
     /** Return successor of the current node
@@ -49,6 +66,25 @@ class BSTNode {
             return nullptr;
         }
     }
+
+    /** Return predecessor of the current node, the mirror image of
+     *  successor(): the rightmost node of the left subtree if there is
+     *  one, otherwise the first ancestor reached from its right subtree
+     */
+    BSTNode<Data>* predecessor() {
+        BSTNode<Data>* curr = nullptr;
+        if (this->left != nullptr) {
+            curr = this->left;
+            while (curr->right != nullptr) curr = curr->right;
+            return curr;
+        }
+        curr = this;
+        while (curr->parent != nullptr) {
+            if (curr == (curr->parent)->right) return curr->parent;
+            curr = curr->parent;
+        }
+        return nullptr;
+    }
 };
 
 /** DO NOT CHANGE THIS METHOD
@@ -0,0 +1,353 @@
+/**
+ * Read-only binary image of a BST<string>, searched in place through a
+ * read-only mapping of the file, so opening one costs no parsing and no
+ * inserts however many strings it holds, only one pass over the tables
+ * to check that every string lies inside the file.
+ *
+ * The file holds, in little-endian byte order like the binary point files
+ * (big-endian hosts keep a swapped copy of the nodes and offsets):
+ *   SnapshotHeader
+ *   nodes    count {uint64 prefix, uint64 rank}, the balanced tree in
+ *            Eytzinger order like FrozenBST: the root first and the
+ *            children of the k-th node (from 1) at 2k and 2k + 1. prefix
+ *            is stringPrefix() of the string of sorted position rank.
+ *   offsets  count + 1 uint64, string i is blob[offsets[i], offsets[i + 1])
+ *   blob     the strings in sorted order, without separators
+ *
+ * A search walks the nodes and decides most levels on the prefixes alone,
+ * reading the blob only for ties, like SearchKey<string>.
+ */
+
+#ifndef BSTSNAPSHOT_HPP
+#define BSTSNAPSHOT_HPP
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "BST.hpp"
+#include "KeyPrefix.hpp"
+
+using namespace std;
+
+const char SNAPSHOT_MAGIC[8] = {'B', 'S', 'T', 'S', 'N', 'A', 'P', '\0'};
+const uint32_t SNAPSHOT_VERSION = 1;
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t count;
+    uint64_t blobBytes;
+};
+
+static_assert(sizeof(SnapshotHeader) == 32, "header must be packed");
+
+class BSTSnapshot {
+  private:
+    /** Node of the tree: the first bytes of its string and where the
+     *  string is in sorted order
+     */
+    struct Node {
+        uint64_t prefix;
+        uint64_t rank;
+    };
+
+    // mapped file
+    void* mapped;
+    size_t mappedLength;
+
+    // number of strings
+    size_t n;
+
+    // sections of the mapped file
+    const Node* nodes;
+    const uint64_t* offsets;
+    const char* blob;
+
+    // on big-endian hosts, the nodes then the offsets in host byte order
+    vector<uint64_t> swapped;
+
+  public:
+    /** Constructor of an empty snapshot, see open() */
+    BSTSnapshot()
+        : mapped(nullptr),
+          mappedLength(0),
+          n(0),
+          nodes(nullptr),
+          offsets(nullptr),
+          blob(nullptr) {}
+
+    /** Destructor, unmaps the file */
+    ~BSTSnapshot() { close(); }
+
+    BSTSnapshot(const BSTSnapshot&) = delete;
+    BSTSnapshot& operator=(const BSTSnapshot&) = delete;
+
+    /** Write the strings in [first, last), which must be sorted and
+     *  distinct like the items of a BST, to fileName. Return false on I/O
+     *  error.
+     */
+    template <typename InputIterator>
+    static bool save(const char* fileName, InputIterator first,
+                     InputIterator last) {
+        vector<const string*> items;
+        for (; first != last; ++first) items.push_back(&*first);
+        SnapshotHeader header = {};
+        memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+        header.version = SNAPSHOT_VERSION;
+        header.count = items.size();
+        vector<uint64_t> starts(items.size() + 1, 0);
+        for (size_t i = 0; i < items.size(); i++) {
+            starts[i + 1] = starts[i] + items[i]->size();
+        }
+        header.blobBytes = starts.back();
+        vector<Node> tree(items.size());
+        size_t rank = 0;
+        fillNodes(items, tree, 1, rank);
+
+        swapWords(&header.version, 2, sizeof(uint32_t));
+        swapWords(&header.count, 2, sizeof(uint64_t));
+        swapWords(tree.data(), 2 * tree.size(), sizeof(uint64_t));
+        swapWords(starts.data(), starts.size(), sizeof(uint64_t));
+
+        ofstream out(fileName, ios::binary | ios::trunc);
+        if (!out.is_open()) return false;
+        out.write((const char*)&header, sizeof(header));
+        out.write((const char*)tree.data(), tree.size() * sizeof(Node));
+        out.write((const char*)starts.data(), starts.size() * sizeof(uint64_t));
+        for (const string* item : items) out.write(item->data(), item->size());
+        out.close();
+        return !out.fail();
+    }
+
+    /** Return true if fileName starts like a snapshot */
+    static bool isSnapshot(const char* fileName) {
+        ifstream in(fileName, ios::binary);
+        char magic[sizeof(SNAPSHOT_MAGIC)];
+        in.read(magic, sizeof(magic));
+        return in.gcount() == sizeof(magic) &&
+               memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) == 0;
+    }
+
+    /** Map the snapshot in fileName. Return false if it cannot be read or
+     *  is not a whole snapshot: every string must lie in the blob, after
+     *  the one before it, and every node must name a string.
+     */
+    bool open(const char* fileName) {
+        close();
+        int fd = ::open(fileName, O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info;
+        if (fstat(fd, &info) < 0 ||
+            (size_t)info.st_size < sizeof(SnapshotHeader)) {
+            ::close(fd);
+            return false;
+        }
+        mappedLength = info.st_size;
+        mapped = mmap(nullptr, mappedLength, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            mapped = nullptr;
+            return false;
+        }
+        SnapshotHeader header;
+        memcpy(&header, mapped, sizeof(header));
+        swapWords(&header.version, 2, sizeof(uint32_t));
+        swapWords(&header.count, 2, sizeof(uint64_t));
+        size_t tableBytes = sizeof(header) + header.count * sizeof(Node) +
+                            (header.count + 1) * sizeof(uint64_t);
+        if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 ||
+            header.version != SNAPSHOT_VERSION ||
+            header.count > mappedLength / sizeof(Node) ||
+            header.blobBytes > mappedLength ||
+            tableBytes + header.blobBytes != mappedLength) {
+            close();
+            return false;
+        }
+        const char* p = (const char*)mapped + sizeof(header);
+        nodes = (const Node*)p;
+        offsets = (const uint64_t*)(p + header.count * sizeof(Node));
+        blob = (const char*)mapped + tableBytes;
+        n = header.count;
+        if (!hostIsLittleEndian()) {
+            const uint64_t* words = (const uint64_t*)nodes;
+            swapped.assign(words, words + 2 * n + n + 1);
+            swapWords(swapped.data(), swapped.size(), sizeof(uint64_t));
+            nodes = (const Node*)swapped.data();
+            offsets = swapped.data() + 2 * n;
+        }
+        bool valid = offsets[0] == 0 && offsets[n] == header.blobBytes;
+        for (size_t i = 0; valid && i < n; i++) {
+            valid = offsets[i] <= offsets[i + 1] && nodes[i].rank < n;
+        }
+        if (!valid) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    /** Unmap the file */
+    void close() {
+        if (mapped != nullptr) munmap(mapped, mappedLength);
+        mapped = nullptr;
+        mappedLength = 0;
+        n = 0;
+        nodes = nullptr;
+        offsets = nullptr;
+        blob = nullptr;
+        swapped.clear();
+    }
+
+    /** Return the number of strings */
+    size_t size() const { return n; }
+
+    /** Return true if there are no strings */
+    bool empty() const { return n == 0; }
+
+    /** Return the height of the tree, -1 if it is empty */
+    int height() const {
+        int h = -1;
+        for (size_t k = n; k > 0; k /= 2) h++;
+        return h;
+    }
+
+    /** Return the string at position i in sorted order */
+    string at(size_t i) const {
+        return string(blob + offsets[i], offsets[i + 1] - offsets[i]);
+    }
+
+    /** Return true if item is in the snapshot */
+    bool contains(const string& item) const {
+        return contains(item.data(), item.size());
+    }
+
+    /** Return true if the string of len characters at item is in the
+     *  snapshot
+     */
+    bool contains(const char* item, size_t len) const {
+        size_t i = rank(item, len);
+        return i < n && compare(item, len, i) == 0;
+    }
+
+    /** Return the number of strings less than the string of len characters
+     *  at item, which is the position of the first one not less than it
+     */
+    size_t rank(const char* item, size_t len) const {
+        uint64_t prefix = stringPrefix(item, len);
+        size_t k = 1;
+        size_t bound = n;
+        while (k <= n) {
+            const Node& node = nodes[k - 1];
+            if (prefix < node.prefix ||
+                (prefix == node.prefix &&
+                 compare(item, len, node.rank) <= 0)) {
+                bound = node.rank;
+                k = 2 * k;
+            } else {
+                k = 2 * k + 1;
+            }
+        }
+        return bound;
+    }
+
+    /** Return, in order, the first limit strings that start with prefix.
+     *  They lie next to each other in the blob.
+     */
+    vector<string> prefixSearch(const string& prefix,
+                                unsigned int limit) const {
+        vector<string> matches;
+        for (size_t i = rank(prefix.data(), prefix.size());
+             i < n && matches.size() < limit &&
+             offsets[i + 1] - offsets[i] >= prefix.size() &&
+             memcmp(blob + offsets[i], prefix.data(), prefix.size()) == 0;
+             i++) {
+            matches.push_back(at(i));
+        }
+        return matches;
+    }
+
+    /** Return the strings in order */
+    vector<string> inorder() const {
+        vector<string> vec;
+        vec.reserve(n);
+        for (size_t i = 0; i < n; i++) vec.push_back(at(i));
+        return vec;
+    }
+
+  private:
+    /** True if this machine stores numbers little-endian */
+    static bool hostIsLittleEndian() {
+        const uint32_t one = 1;
+        unsigned char first;
+        memcpy(&first, &one, 1);
+        return first == 1;
+    }
+
+    /** Reverse the bytes of each of the count values of size bytes at
+     *  data on big-endian hosts, converting between little-endian and the
+     *  host order
+     */
+    static void swapWords(void* data, size_t count, size_t size) {
+        if (hostIsLittleEndian()) return;
+        unsigned char* bytes = (unsigned char*)data;
+        for (size_t i = 0; i < count; i++) {
+            reverse(bytes + i * size, bytes + (i + 1) * size);
+        }
+    }
+
+    /** Return <0, 0 or >0 as the string of len characters at item is
+     *  before, equal to or after the string at position i
+     */
+    int compare(const char* item, size_t len, size_t i) const {
+        size_t dataLen = offsets[i + 1] - offsets[i];
+        const char* data = blob + offsets[i];
+        int order = memcmp(item, data, min(len, dataLen));
+        if (order != 0) return order;
+        return len < dataLen ? -1 : (len > dataLen ? 1 : 0);
+    }
+
+    /** Put the items into the subtree of tree at index k, in order,
+     *  counting their ranks from rank
+     */
+    static void fillNodes(const vector<const string*>& items,
+                          vector<Node>& tree, size_t k, size_t& rank) {
+        if (k > tree.size()) return;
+        fillNodes(items, tree, 2 * k, rank);
+        const string& item = *items[rank];
+        tree[k - 1].prefix = stringPrefix(item.data(), item.size());
+        tree[k - 1].rank = rank;
+        rank++;
+        fillNodes(items, tree, 2 * k + 1, rank);
+    }
+};
+
+/** Write the items of tree to fileName as a BSTSnapshot. Return false on
+ *  I/O error.
+ */
+inline bool saveSnapshot(const BST<string>& tree, const char* fileName) {
+    return BSTSnapshot::save(fileName, tree.begin(), tree.end());
+}
+
+/** Replace the content of tree with the snapshot in fileName, built into a
+ *  balanced tree in O(n) without sorting or parsing. This copies every
+ *  string; to only search the snapshot, map it with BSTSnapshot::open.
+ *  Return false, leaving tree as it was, if it cannot be read.
+ */
+inline bool loadSnapshot(BST<string>& tree, const char* fileName) {
+    BSTSnapshot snapshot;
+    if (!snapshot.open(fileName)) return false;
+    vector<string> items = snapshot.inorder();
+    tree.build(make_move_iterator(items.begin()),
+               make_move_iterator(items.end()));
+    return true;
+}
+
+#endif  // BSTSNAPSHOT_HPP
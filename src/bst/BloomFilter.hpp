@@ -0,0 +1,102 @@
+#ifndef BLOOMFILTER_HPP
+#define BLOOMFILTER_HPP
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "KeyHash.hpp"
+using namespace std;
+
+/** Blocked Bloom filter: a set of hashes that may answer yes for a hash
+ *  it does not hold, with the given false positive rate, but never answers
+ *  no for one it holds. All the bits of a hash are in one block of 64
+ *  bytes, so a lookup reads one or two cache lines.
+ */
+class BloomFilter {
+  private:
+    // 64 bit words per block
+    static const size_t BLOCK_WORDS = 8;
+
+    // bits, BLOCK_WORDS words per block
+    vector<uint64_t> words;
+
+    // number of blocks
+    uint64_t numBlocks;
+
+    // bits set per hash
+    int numBits;
+
+    // number of hashes added
+    size_t isize;
+
+    // number of hashes the filter was sized for
+    size_t icapacity;
+
+    // false positive rate at capacity
+    double rate;
+
+  public:
+    /** Make an empty filter for capacity hashes with the false positive
+     *  rate falsePositiveRate once it holds them
+     */
+    BloomFilter(size_t capacity, double falsePositiveRate)
+        : isize(0),
+          icapacity(max<size_t>(capacity, 1)),
+          rate(falsePositiveRate) {
+        // bits per hash of a plain Bloom filter, plus some because blocks
+        // fill unevenly
+        double bitsPerHash = -log(rate) / (log(2) * log(2)) * 1.2;
+        numBlocks = (uint64_t)(icapacity * bitsPerHash / 512) + 1;
+        numBits = max(1, min(16, (int)lround(-log2(rate))));
+        words.assign(numBlocks * BLOCK_WORDS, 0);
+    }
+
+    /** Add hash to the filter */
+    void add(uint64_t hash) {
+        uint64_t* block = &words[blockOf(hash) * BLOCK_WORDS];
+        for (int i = 0; i < numBits; i++) {
+            unsigned int bit = nextBit(hash);
+            block[bit / 64] |= 1ull << (bit % 64);
+        }
+        isize++;
+    }
+
+    /** Return false if hash was never added, true if it may have been */
+    bool mayContain(uint64_t hash) const {
+        const uint64_t* block = &words[blockOf(hash) * BLOCK_WORDS];
+        for (int i = 0; i < numBits; i++) {
+            unsigned int bit = nextBit(hash);
+            if ((block[bit / 64] & (1ull << (bit % 64))) == 0) return false;
+        }
+        return true;
+    }
+
+    /** Remove every hash */
+    void clear() {
+        fill(words.begin(), words.end(), 0);
+        isize = 0;
+    }
+
+    /** Return the number of hashes added, counting repeats */
+    size_t size() const { return isize; }
+
+    /** Return the number of hashes the filter was sized for */
+    size_t capacity() const { return icapacity; }
+
+    /** Return the false positive rate at capacity */
+    double falsePositiveRate() const { return rate; }
+
+  private:
+    /** Return the block of hash, from its high bits */
+    uint64_t blockOf(uint64_t hash) const {
+        return ((hash >> 32) * numBlocks) >> 32;
+    }
+
+    /** Step hash to the next bit to set, return a bit index in a block */
+    static unsigned int nextBit(uint64_t& hash) {
+        hash = hash * 0x9e3779b97f4a7c15ull + 0x632be59bd9b4e019ull;
+        return hash >> 55;
+    }
+};
+
+#endif  // BLOOMFILTER_HPP
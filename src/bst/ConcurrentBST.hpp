@@ -0,0 +1,236 @@
+#ifndef CONCURRENTBST_HPP
+#define CONCURRENTBST_HPP
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <mutex>
+#include <vector>
+#include "KeyPrefix.hpp"
+using namespace std;
+
+/** BST that any number of threads can search and iterate while one
+ *  thread at a time inserts. Readers take no lock: a new node is fully
+ *  built before a release store links it into the tree, and nodes are
+ *  never moved or freed until the tree is destroyed, so a reader always
+ *  sees a valid tree. Inserts are serialized by a mutex. Like BST the tree
+ *  is not rebalanced by insert (a rotation would move nodes under the
+ *  readers); build() loads a balanced tree to start from.
+ */
+template <typename Data>
+class ConcurrentBST {
+  private:
+    /** Node whose children may be read while they are being linked */
+    class Node : public NodeKey<Data> {
+      public:
+        atomic<Node*> left;
+        atomic<Node*> right;
+        // set before the node is linked, never changed
+        Node* const parent;
+        Data const data;
+
+        Node(const Data& d, Node* parent)
+            : left(nullptr), right(nullptr), parent(parent), data(d) {
+            this->setKey(data);
+        }
+
+        /** Return the node after this one in order, nullptr if none */
+        Node* successor() const {
+            Node* curr = right.load(memory_order_acquire);
+            if (curr != nullptr) {
+                Node* next;
+                while ((next = curr->left.load(memory_order_acquire))) {
+                    curr = next;
+                }
+                return curr;
+            }
+            const Node* child = this;
+            curr = parent;
+            while (curr != nullptr &&
+                   curr->right.load(memory_order_acquire) == child) {
+                child = curr;
+                curr = curr->parent;
+            }
+            return curr;
+        }
+    };
+
+    // root of the tree, nullptr if empty
+    atomic<Node*> root;
+
+    // number of items
+    atomic<unsigned int> isize;
+
+    // height of the tree
+    atomic<int> iheight;
+
+    // held by insert
+    mutex writeLock;
+
+  public:
+    /** Iterator over the items in order, with the interface of
+     *  BSTIterator. Items inserted during the iteration may be skipped.
+     */
+    class iterator : public std::iterator<input_iterator_tag, Data> {
+      private:
+        const Node* curr;
+
+      public:
+        explicit iterator(const Node* curr) : curr(curr) {}
+
+        /** Dereference operator. */
+        const Data& operator*() const { return curr->data; }
+
+        /** Pre-increment operator. */
+        iterator& operator++() {
+            curr = curr->successor();
+            return *this;
+        }
+
+        /** Post-increment operator. */
+        iterator operator++(int) {
+            iterator before = *this;
+            ++(*this);
+            return before;
+        }
+
+        /** Compare two iterators */
+        bool operator==(const iterator& other) const {
+            return curr == other.curr;
+        }
+
+        /** Compare two iterators */
+        bool operator!=(const iterator& other) const {
+            return curr != other.curr;
+        }
+    };
+
+    /** Default constructor.
+     *  Initialize an empty tree.
+     */
+    ConcurrentBST() : root(nullptr), isize(0), iheight(-1) {}
+
+    ConcurrentBST(const ConcurrentBST&) = delete;
+    ConcurrentBST& operator=(const ConcurrentBST&) = delete;
+
+    /** Destructor, no reader may be left */
+    ~ConcurrentBST() { deleteAll(root.load()); }
+
+    /** Insert item, return false if it is already in the tree. Safe to
+     *  call while other threads read or insert.
+     */
+    bool insert(const Data& item) {
+        lock_guard<mutex> guard(writeLock);
+        SearchKey<Data> key(item);
+        Node* parent = nullptr;
+        atomic<Node*>* link = &root;
+        int depth = 0;
+        // only this thread changes links, relaxed loads see its own stores
+        Node* curr;
+        while ((curr = link->load(memory_order_relaxed)) != nullptr) {
+            int order = key.compare(curr->data, *curr);
+            if (order == 0) return false;
+            parent = curr;
+            link = order < 0 ? &curr->left : &curr->right;
+            depth++;
+        }
+        // publish the node only once it is complete
+        link->store(new Node(item, parent), memory_order_release);
+        isize.fetch_add(1, memory_order_relaxed);
+        if (depth > iheight.load(memory_order_relaxed)) {
+            iheight.store(depth, memory_order_relaxed);
+        }
+        return true;
+    }
+
+    /** Insert the items in [first, last) so that, into an empty tree, the
+     *  result is balanced: the median of every range goes in first
+     */
+    template <typename InputIterator>
+    void build(InputIterator first, InputIterator last) {
+        vector<Data> items(first, last);
+        sort(items.begin(), items.end());
+        items.erase(unique(items.begin(), items.end(),
+                           [](const Data& a, const Data& b) {
+                               return !(a < b);
+                           }),
+                    items.end());
+        insertMedians(items, 0, items.size());
+    }
+
+    /** Find a data item. Lock-free, safe to call while inserting. */
+    iterator find(const Data& item) const {
+        return iterator(findNode(SearchKey<Data>(item)));
+    }
+
+    /** Find a string in ConcurrentBST<string> without constructing one */
+    iterator find(const char* item) const { return find(item, strlen(item)); }
+
+    /** Find the string of len characters at item in ConcurrentBST<string>
+     *  without constructing a string
+     */
+    iterator find(const char* item, size_t len) const {
+        return iterator(findNode(SearchKey<Data>(item, len)));
+    }
+
+    /** Return the number of items */
+    unsigned int size() const { return isize.load(memory_order_relaxed); }
+
+    /** Return the height of the tree, -1 if empty */
+    int height() const { return iheight.load(memory_order_relaxed); }
+
+    /** Return true if the tree is empty */
+    bool empty() const { return root.load(memory_order_acquire) == nullptr; }
+
+    /** Return the first item. Lock-free, safe to call while inserting. */
+    iterator begin() const {
+        Node* curr = root.load(memory_order_acquire);
+        if (curr == nullptr) return end();
+        Node* next;
+        while ((next = curr->left.load(memory_order_acquire))) curr = next;
+        return iterator(curr);
+    }
+
+    /** Return an iterator pointing past the last item */
+    iterator end() const { return iterator(nullptr); }
+
+    /** Return the items in order */
+    vector<Data> inorder() const {
+        vector<Data> vec;
+        for (iterator it = begin(); it != end(); ++it) vec.push_back(*it);
+        return vec;
+    }
+
+  private:
+    /** Return the node holding key, or nullptr */
+    Node* findNode(const SearchKey<Data>& key) const {
+        Node* curr = root.load(memory_order_acquire);
+        while (curr != nullptr) {
+            int order = key.compare(curr->data, *curr);
+            if (order == 0) break;
+            curr = (order < 0 ? curr->left : curr->right)
+                       .load(memory_order_acquire);
+        }
+        return curr;
+    }
+
+    /** Insert the sorted items[start, end), medians first */
+    void insertMedians(const vector<Data>& items, size_t start, size_t end) {
+        if (start == end) return;
+        size_t mid = start + (end - start) / 2;
+        insert(items[mid]);
+        insertMedians(items, start, mid);
+        insertMedians(items, mid + 1, end);
+    }
+
+    /** Helper method for ~ConcurrentBST() */
+    static void deleteAll(Node* n) {
+        if (n) {
+            deleteAll(n->left.load());
+            deleteAll(n->right.load());
+            delete n;
+        }
+    }
+};
+
+#endif  // CONCURRENTBST_HPP
@@ -0,0 +1,158 @@
+#ifndef FROZENBST_HPP
+#define FROZENBST_HPP
+#include <iterator>
+#include <vector>
+#include "BST.hpp"
+using namespace std;
+
+/** Read-only snapshot of a BST for lookup-heavy use. The items are stored
+ *  in one array in Eytzinger order: the root at index 1 and the children
+ *  of index k at 2k and 2k + 1, so the first levels of every search share
+ *  the same cache lines and the next levels can be prefetched. Searches do
+ *  not branch on comparisons. Iteration visits the items in the same
+ *  sorted order as BST. Data must be default constructible.
+ */
+template <typename Data>
+class FrozenBST {
+  private:
+    // items in Eytzinger order, index 0 is unused
+    vector<Data> keys;
+
+    // number of items
+    size_t n;
+
+  public:
+    /** Iterator over the items in sorted order, with the interface of
+     *  BSTIterator
+     */
+    class iterator : public std::iterator<input_iterator_tag, Data> {
+      private:
+        const FrozenBST<Data>* tree;
+        // index in keys, 0 past the last item
+        size_t k;
+
+      public:
+        iterator(const FrozenBST<Data>* tree, size_t k) : tree(tree), k(k) {}
+
+        /** Dereference operator. */
+        const Data& operator*() const { return tree->keys[k]; }
+
+        /** Pre-increment operator. */
+        iterator& operator++() {
+            k = tree->successor(k);
+            return *this;
+        }
+
+        /** Post-increment operator. */
+        iterator operator++(int) {
+            iterator before = *this;
+            ++(*this);
+            return before;
+        }
+
+        /** Compare two iterators */
+        bool operator==(const iterator& other) const {
+            return tree == other.tree && k == other.k;
+        }
+
+        /** Compare two iterators */
+        bool operator!=(const iterator& other) const {
+            return !(*this == other);
+        }
+    };
+
+    /** Take a snapshot of the items of tree */
+    explicit FrozenBST(const BST<Data>& tree) : n(tree.size()) {
+        keys.resize(n + 1);
+        typename BST<Data>::iterator it = tree.begin();
+        fill(it, 1);
+    }
+
+    /** Find a data item, return end() if it is not there */
+    iterator find(const Data& item) const {
+        size_t k = search(item);
+        if (k != 0 && item < keys[k]) k = 0;
+        return iterator(this, k);
+    }
+
+    /** Return the first item that is not less than item, or end() */
+    iterator lower_bound(const Data& item) const {
+        return iterator(this, search(item));
+    }
+
+    /** Return the number of items */
+    size_t size() const { return n; }
+
+    /** Return true if there are no items */
+    bool empty() const { return n == 0; }
+
+    /** Return the smallest item */
+    iterator begin() const {
+        if (n == 0) return end();
+        size_t k = 1;
+        while (2 * k <= n) k = 2 * k;
+        return iterator(this, k);
+    }
+
+    /** Return an iterator pointing past the last item */
+    iterator end() const { return iterator(this, 0); }
+
+  private:
+    /** Copy the items from it into the subtree at index k, in order */
+    void fill(typename BST<Data>::iterator& it, size_t k) {
+        if (k > n) return;
+        fill(it, 2 * k);
+        keys[k] = *it;
+        ++it;
+        fill(it, 2 * k + 1);
+    }
+
+    /** Return the index of the first item not less than item, 0 if there
+     *  is none
+     */
+    size_t search(const Data& item) const {
+        // items per cache line, the items that many levels down share one
+        const size_t PREFETCH_STRIDE =
+            sizeof(Data) >= 64 ? 1 : 64 / sizeof(Data);
+        const Data* base = keys.data();
+        size_t k = 1;
+        while (k <= n) {
+#ifdef __GNUC__
+            __builtin_prefetch(base + PREFETCH_STRIDE * k);
+#endif
+            // go right if keys[k] < item, without a branch
+            k = 2 * k + (base[k] < item);
+        }
+        // undo the right turns after the last left turn, and that left turn
+        k >>= countTrailingOnes(k) + 1;
+        return k;
+    }
+
+    /** Return the number of trailing one bits of k */
+    static int countTrailingOnes(size_t k) {
+#ifdef __GNUC__
+        if (~k != 0) return __builtin_ctzll(~(unsigned long long)k);
+#endif
+        int count = 0;
+        while (k & 1) {
+            k >>= 1;
+            count++;
+        }
+        return count;
+    }
+
+    /** Return the index after k in sorted order, 0 after the last */
+    size_t successor(size_t k) const {
+        if (2 * k + 1 <= n) {
+            // leftmost item of the right subtree
+            k = 2 * k + 1;
+            while (2 * k <= n) k = 2 * k;
+            return k;
+        }
+        // go up until coming from a left child
+        k >>= countTrailingOnes(k) + 1;
+        return k;
+    }
+};
+
+#endif  // FROZENBST_HPP
@@ -0,0 +1,127 @@
+#ifndef HASHINDEX_HPP
+#define HASHINDEX_HPP
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "BSTNode.hpp"
+#include "KeyHash.hpp"
+#include "KeyPrefix.hpp"
+using namespace std;
+
+/** Open addressing hash table from the items of a BST to their nodes,
+ *  with linear probing. Next to every slot a one byte tag holds 7 bits of
+ *  the hash of its item, or 0 if the slot is empty, so most slots of other
+ *  items are skipped without reading their nodes. Data needs a KeyHash.
+ */
+template <typename Data>
+class HashIndex {
+  private:
+    // most items per slot before the table grows
+    static constexpr double MAX_LOAD = 0.7;
+
+    // nodes, nullptr in empty slots
+    vector<BSTNode<Data>*> slots;
+
+    // tags of the slots, 0 in empty slots
+    vector<uint8_t> tags;
+
+    // number of slots minus one, a power of two minus one
+    size_t mask;
+
+    // number of items
+    size_t isize;
+
+  public:
+    /** Make an empty index for about capacity items */
+    explicit HashIndex(size_t capacity = 0) : isize(0) {
+        resize(capacity / MAX_LOAD + 1);
+    }
+
+    /** Add node, whose item must not be in the index yet */
+    void insert(BSTNode<Data>* node) {
+        if (isize + 1 > slots.size() * MAX_LOAD) resize(2 * slots.size());
+        place(node, KeyHash<Data>()(node->data));
+        isize++;
+    }
+
+    /** Remove node, which must be in the index. The items after it in its
+     *  run of slots move back, so no run is broken.
+     */
+    void erase(BSTNode<Data>* node) {
+        size_t i = KeyHash<Data>()(node->data) & mask;
+        while (slots[i] != node) i = (i + 1) & mask;
+        size_t hole = i;
+        while (true) {
+            i = (i + 1) & mask;
+            if (tags[i] == 0) break;
+            size_t home = KeyHash<Data>()(slots[i]->data) & mask;
+            // move the item back if its home is not after the hole, going
+            // around the end of the table
+            if (((i - home) & mask) >= ((i - hole) & mask)) {
+                slots[hole] = slots[i];
+                tags[hole] = tags[i];
+                hole = i;
+            }
+        }
+        slots[hole] = nullptr;
+        tags[hole] = 0;
+        isize--;
+    }
+
+    /** Return the node of the item matching key, whose hash is hash, or
+     *  nullptr. O(1) expected.
+     */
+    BSTNode<Data>* find(const SearchKey<Data>& key, uint64_t hash) const {
+        uint8_t tag = tagOf(hash);
+        for (size_t i = hash & mask; tags[i] != 0; i = (i + 1) & mask) {
+            if (tags[i] != tag) continue;
+            if (key.compare(slots[i]->data, *slots[i]) == 0) return slots[i];
+        }
+        return nullptr;
+    }
+
+    /** Remove every item */
+    void clear() {
+        fill(slots.begin(), slots.end(), nullptr);
+        fill(tags.begin(), tags.end(), 0);
+        isize = 0;
+    }
+
+    /** Return the number of items */
+    size_t size() const { return isize; }
+
+    /** Return the bytes taken by the table */
+    size_t bytes() const {
+        return slots.size() * (sizeof(BSTNode<Data>*) + sizeof(uint8_t));
+    }
+
+  private:
+    /** Return the tag of hash: its top 7 bits, with the 8th bit set so
+     *  that it is never 0
+     */
+    static uint8_t tagOf(uint64_t hash) { return (hash >> 57) | 0x80; }
+
+    /** Put node in the first empty slot from its home */
+    void place(BSTNode<Data>* node, uint64_t hash) {
+        size_t i = hash & mask;
+        while (tags[i] != 0) i = (i + 1) & mask;
+        slots[i] = node;
+        tags[i] = tagOf(hash);
+    }
+
+    /** Move the items to a table of at least numSlots slots */
+    void resize(size_t numSlots) {
+        size_t size = 16;
+        while (size < numSlots) size *= 2;
+        vector<BSTNode<Data>*> old;
+        old.swap(slots);
+        slots.assign(size, nullptr);
+        tags.assign(size, 0);
+        mask = size - 1;
+        for (BSTNode<Data>* node : old) {
+            if (node != nullptr) place(node, KeyHash<Data>()(node->data));
+        }
+    }
+};
+
+#endif  // HASHINDEX_HPP
@@ -0,0 +1,74 @@
+#ifndef KEYHASH_HPP
+#define KEYHASH_HPP
+#include <string.h>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <type_traits>
+using namespace std;
+
+/** Return a 64 bit hash of the len bytes at s */
+inline uint64_t hashBytes(const char* s, size_t len) {
+    const uint64_t MULTIPLIER = 0x9e3779b97f4a7c15ull;
+    uint64_t hash = len * MULTIPLIER;
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t word;
+        memcpy(&word, s + i, 8);
+        hash = (hash ^ word) * MULTIPLIER;
+        hash ^= hash >> 29;
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, s + i, len - i);
+    hash = (hash ^ tail) * MULTIPLIER;
+    return hash ^ (hash >> 32);
+}
+
+/** Hash of the items of a BST, which its Bloom filter and hash index are
+ *  built on. A BST of any other type only needs operator<: enabled is
+ *  false and the filter and the index are compiled out of it. Specialize
+ *  KeyHash for a type to use them with it.
+ */
+template <typename Data, typename Enable = void>
+struct KeyHash {
+    static const bool enabled = false;
+
+    /** Only there so that the compiled out code compiles, never called */
+    uint64_t operator()(const Data&) const { return 0; }
+};
+
+/** Numbers, enums and pointers go through std::hash, with the bits of its
+ *  result well mixed since it is often the identity
+ */
+template <typename Data>
+struct KeyHash<Data, typename enable_if<is_arithmetic<Data>::value ||
+                                        is_enum<Data>::value ||
+                                        is_pointer<Data>::value>::type> {
+    static const bool enabled = true;
+
+    uint64_t operator()(const Data& item) const {
+        uint64_t hash = std::hash<Data>()(item);
+        hash = (hash ^ (hash >> 33)) * 0xff51afd7ed558ccdull;
+        hash = (hash ^ (hash >> 33)) * 0xc4ceb9fe1a85ec53ull;
+        return hash ^ (hash >> 33);
+    }
+};
+
+/** Strings hash their characters, like a char buffer of the same text */
+template <>
+struct KeyHash<string> {
+    static const bool enabled = true;
+
+    uint64_t operator()(const string& item) const {
+        return hashBytes(item.data(), item.size());
+    }
+};
+
+/** Return a 64 bit hash of item, which must have a KeyHash */
+template <typename Data>
+uint64_t keyHash(const Data& item) {
+    static_assert(KeyHash<Data>::enabled, "no KeyHash for this type");
+    return KeyHash<Data>()(item);
+}
+
+#endif  // KEYHASH_HPP
@@ -0,0 +1,93 @@
+#ifndef KEYPREFIX_HPP
+#define KEYPREFIX_HPP
+#include <string.h>
+#include <cstdint>
+#include <string>
+using namespace std;
+
+/** Extra key data kept in every BSTNode to speed up comparisons. Nothing
+ *  for most types, which are compared with operator< alone.
+ */
+template <typename Data>
+class NodeKey {
+  protected:
+    /** Cache what is needed from the data of the node */
+    void setKey(const Data&) {}
+};
+
+/** Key being searched for, compared three ways against node data */
+template <typename Data>
+class SearchKey {
+  private:
+    const Data& item;
+
+  public:
+    explicit SearchKey(const Data& item) : item(item) {}
+
+    /** Return <0, 0 or >0 as the key is before, equal to or after data */
+    int compare(const Data& data, const NodeKey<Data>&) const {
+        if (item < data) return -1;
+        return data < item ? 1 : 0;
+    }
+};
+
+/** Return the first 8 bytes of the string at s of length len as a big
+ *  endian number, padded with zero bytes, so that numbers compare like the
+ *  strings they start
+ */
+inline uint64_t stringPrefix(const char* s, size_t len) {
+    unsigned char bytes[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    memcpy(bytes, s, len < 8 ? len : 8);
+    uint64_t prefix = 0;
+    for (int i = 0; i < 8; i++) prefix = (prefix << 8) | bytes[i];
+    return prefix;
+}
+
+/** String nodes keep the first 8 bytes of their string inline, so most
+ *  levels of a search are decided without reading the string itself
+ */
+template <>
+class NodeKey<string> {
+  protected:
+    uint64_t prefix;
+
+    void setKey(const string& data) {
+        prefix = stringPrefix(data.data(), data.size());
+    }
+
+    friend class SearchKey<string>;
+};
+
+/** String key that may point into any character buffer, so that looking
+ *  up a const char* does not construct a string
+ */
+template <>
+class SearchKey<string> {
+  private:
+    const char* chars;
+    size_t len;
+    uint64_t prefix;
+
+  public:
+    explicit SearchKey(const string& item)
+        : SearchKey(item.data(), item.size()) {}
+
+    SearchKey(const char* chars, size_t len)
+        : chars(chars), len(len), prefix(stringPrefix(chars, len)) {}
+
+    /** Return <0, 0 or >0 as the key is before, equal to or after data,
+     *  with one string comparison at most
+     */
+    int compare(const string& data, const NodeKey<string>& key) const {
+        if (prefix != key.prefix) return prefix < key.prefix ? -1 : 1;
+        // the first min(8, length) bytes are known to be equal
+        size_t shorter = len < data.size() ? len : data.size();
+        size_t skip = shorter < 8 ? shorter : 8;
+        int result = memcmp(chars + skip, data.data() + skip, shorter - skip);
+        if (result != 0) return result;
+        if (len == data.size()) return 0;
+        return len < data.size() ? -1 : 1;
+    }
+};
+
+#endif  // KEYPREFIX_HPP
@@ -0,0 +1,118 @@
+#ifndef SPLAYBST_HPP
+#define SPLAYBST_HPP
+#include <string.h>
+#include <algorithm>
+#include "BST.hpp"
+#include "BSTNode.hpp"
+using namespace std;
+
+/** Self-adjusting BST: every insert and every find through a non-const
+ *  SplayBST rotates the node it reaches up to the root, so that items
+ *  looked up often stay near the top. Any sequence of m operations takes
+ *  O(m log n), and a skewed stream of lookups costs about the entropy of
+ *  its distribution per lookup instead of the full depth.
+ *
+ *  Restructuring is a write, so only the non-const find splays. find on a
+ *  const SplayBST, or through a BST reference, is the plain read-only
+ *  search of BST and may run on several threads at once. Rotations keep
+ *  the nodes, so iterators stay valid. The height is not bounded: sorted
+ *  inserts make a path, which the next finds shorten.
+ *
+ *  Splaying writes every node on the path, which often costs more than
+ *  the shorter searches save. Finds may splay only once every splayPeriod
+ *  finds instead, which keeps hot items near the top for less writing but
+ *  gives up the amortized bound.
+ */
+template <typename Data>
+class SplayBST : public BST<Data> {
+  private:
+    // finds that splay: one in splayPeriod
+    unsigned int splayPeriod;
+
+    // finds left until the next splay
+    unsigned int countdown;
+
+  public:
+    typedef typename BST<Data>::iterator iterator;
+
+    /** Default constructor.
+     *  Initialize an empty splay tree whose finds splay the found node
+     *  once every splayPeriod finds
+     */
+    explicit SplayBST(unsigned int splayPeriod = 1)
+        : BST<Data>(),
+          splayPeriod(max(splayPeriod, 1u)),
+          countdown(this->splayPeriod) {}
+
+    /** Insert a node in the tree and splay it to the root
+     *  return false if the node already exists
+     */
+    bool insert(const Data& item) override {
+        BSTNode<Data>* node = this->insertLeaf(item);
+        if (node == nullptr) {
+            return false;
+        }
+        splay(node);
+        return true;
+    }
+
+    using BST<Data>::find;
+
+    /** Find a data item and splay it to the root */
+    iterator find(const Data& item) { return splayTo(this->lookupNode(item)); }
+
+    /** Find a string in SplayBST<string> and splay it to the root */
+    iterator find(const char* item) { return find(item, strlen(item)); }
+
+    /** Find the string of len characters at item in SplayBST<string> and
+     *  splay it to the root
+     */
+    iterator find(const char* item, size_t len) {
+        return splayTo(this->lookupNode(item, len));
+    }
+
+  protected:
+    /** Splay node to the root if it is not null and this find is due to
+     *  splay, return an iterator at it
+     */
+    iterator splayTo(BSTNode<Data>* node) {
+        if (node != nullptr && --countdown == 0) {
+            countdown = splayPeriod;
+            splay(node);
+        }
+        return iterator(node, &this->root);
+    }
+
+    /** Rotate x up to the root, two levels at a time. The rotations
+     *  update the heights and sizes of every node that was above x.
+     */
+    void splay(BSTNode<Data>* x) {
+        while (x->parent != nullptr) {
+            BSTNode<Data>* p = x->parent;
+            BSTNode<Data>* g = p->parent;
+            if (g == nullptr) {
+                rotateUp(x);
+            } else if ((g->left == p) == (p->left == x)) {
+                // zig-zig: x, p and g in a line, lift p first
+                rotateUp(p);
+                rotateUp(x);
+            } else {
+                // zig-zag
+                rotateUp(x);
+                rotateUp(x);
+            }
+        }
+        this->iheight = BST<Data>::nodeHeight(this->root);
+    }
+
+    /** Rotate x above its parent */
+    void rotateUp(BSTNode<Data>* x) {
+        if (x->parent->left == x) {
+            this->rotateRight(x->parent);
+        } else {
+            this->rotateLeft(x->parent);
+        }
+    }
+};
+
+#endif  // SPLAYBST_HPP
@@ -0,0 +1,348 @@
+#ifndef THREADEDBST_HPP
+#define THREADEDBST_HPP
+#include <string.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <new>
+#include <utility>
+#include <vector>
+#include "KeyPrefix.hpp"
+using namespace std;
+
+/** BST with compact nodes: a node holds its data and two links and
+ *  nothing else, no parent pointer or cached height and size. A link that
+ *  would be null is a thread instead, to the previous item for a left link
+ *  and to the next item for a right link, so the iterators step through
+ *  the items without a stack or a climb up the tree: every link is followed
+ *  at most twice in a full iteration. Same iterator semantics as BST.
+ *  Like ConcurrentBST the tree is not rebalanced and has no erase; build()
+ *  loads a balanced tree.
+ */
+template <typename Data>
+class ThreadedBST {
+  private:
+    /** Node whose links are tagged with THREAD when they are threads */
+    class Node : public NodeKey<Data> {
+      public:
+        uintptr_t left;
+        uintptr_t right;
+        Data const data;
+
+        Node(const Data& d, uintptr_t left, uintptr_t right)
+            : left(left), right(right), data(d) {
+            this->setKey(data);
+        }
+
+        Node(Data&& d, uintptr_t left, uintptr_t right)
+            : left(left), right(right), data(move(d)) {
+            this->setKey(data);
+        }
+
+        /** Return the node after this one in order, nullptr if none */
+        Node* successor() const {
+            if (isThread(right)) return target(right);
+            Node* curr = target(right);
+            while (!isThread(curr->left)) curr = target(curr->left);
+            return curr;
+        }
+
+        /** Return the node before this one in order, nullptr if none */
+        Node* predecessor() const {
+            if (isThread(left)) return target(left);
+            Node* curr = target(left);
+            while (!isThread(curr->right)) curr = target(curr->right);
+            return curr;
+        }
+    };
+
+    // tag bit of a link that is a thread, not a child; nodes are aligned
+    // to more than 1 byte so the bit is free
+    static const uintptr_t THREAD = 1;
+
+    // root of the tree, nullptr if empty
+    Node* root;
+
+    // number of items
+    unsigned int isize;
+
+    // height of the tree
+    int iheight;
+
+  public:
+    /** Iterator over the items in order, with the interface of
+     *  BSTIterator
+     */
+    class iterator : public std::iterator<bidirectional_iterator_tag, Data,
+                                          ptrdiff_t, const Data*,
+                                          const Data&> {
+      private:
+        Node* curr;
+
+        // root of the tree, to step back from the end
+        Node* const* root;
+
+      public:
+        iterator(Node* curr, Node* const* root) : curr(curr), root(root) {}
+
+        /** Dereference operator, the data is not copied. */
+        const Data& operator*() const { return curr->data; }
+
+        /** Member access operator. */
+        const Data* operator->() const { return &curr->data; }
+
+        /** Pre-increment operator. */
+        iterator& operator++() {
+            curr = curr->successor();
+            return *this;
+        }
+
+        /** Post-increment operator. */
+        iterator operator++(int) {
+            iterator before = *this;
+            ++(*this);
+            return before;
+        }
+
+        /** Pre-decrement operator. Decrementing the end iterator gives the
+         *  last item.
+         */
+        iterator& operator--() {
+            if (curr != nullptr) {
+                curr = curr->predecessor();
+            } else if (*root != nullptr) {
+                curr = *root;
+                while (!isThread(curr->right)) curr = target(curr->right);
+            }
+            return *this;
+        }
+
+        /** Post-decrement operator. */
+        iterator operator--(int) {
+            iterator before = *this;
+            --(*this);
+            return before;
+        }
+
+        /** Compare two iterators */
+        bool operator==(const iterator& other) const {
+            return curr == other.curr;
+        }
+
+        /** Compare two iterators */
+        bool operator!=(const iterator& other) const {
+            return curr != other.curr;
+        }
+    };
+
+    /** Default constructor.
+     *  Initialize an empty tree.
+     */
+    ThreadedBST() : root(nullptr), isize(0), iheight(-1) {}
+
+    ThreadedBST(const ThreadedBST&) = delete;
+    ThreadedBST& operator=(const ThreadedBST&) = delete;
+
+    /** Destructor */
+    ~ThreadedBST() { deleteAll(); }
+
+    /** Insert item, return false if it is already in the tree. The new
+     *  leaf takes over the thread its parent had on that side.
+     */
+    bool insert(const Data& item) {
+        SearchKey<Data> key(item);
+        if (root == nullptr) {
+            root = new Node(item, THREAD, THREAD);
+            isize = 1;
+            iheight = 0;
+            return true;
+        }
+        Node* curr = root;
+        int depth = 1;
+        while (true) {
+            int order = key.compare(curr->data, *curr);
+            if (order == 0) return false;
+            uintptr_t& link = order < 0 ? curr->left : curr->right;
+            if (isThread(link)) {
+                Node* node = order < 0 ? new Node(item, link, threadTo(curr))
+                                       : new Node(item, threadTo(curr), link);
+                link = reinterpret_cast<uintptr_t>(node);
+                break;
+            }
+            curr = target(link);
+            depth++;
+        }
+        isize++;
+        iheight = max(iheight, depth);
+        return true;
+    }
+
+    /** Replace the content of the tree with the items in [first, last),
+     *  which may be in any order and hold duplicates, in a perfectly
+     *  balanced tree
+     */
+    template <typename InputIterator>
+    void build(InputIterator first, InputIterator last) {
+        vector<Data> items(first, last);
+        if (!is_sorted(items.begin(), items.end())) {
+            sort(items.begin(), items.end());
+        }
+        items.erase(unique(items.begin(), items.end(),
+                           [](const Data& a, const Data& b) {
+                               return !(a < b);
+                           }),
+                    items.end());
+        deleteAll();
+        // allocate the nodes in order, so that they tend to lie in memory
+        // in the order iteration visits them
+        vector<void*> storage(items.size());
+        for (void*& node : storage) node = ::operator new(sizeof(Node));
+        isize = items.size();
+        iheight = -1;
+        for (size_t n = items.size(); n > 0; n /= 2) iheight++;
+        root = target(buildBalanced(items, storage, 0, items.size(), THREAD,
+                                    THREAD));
+    }
+
+    /** Find a data item, return end() if it is not there */
+    iterator find(const Data& item) const {
+        return iterator(findNode(SearchKey<Data>(item)), &root);
+    }
+
+    /** Find a string in ThreadedBST<string> without constructing one */
+    iterator find(const char* item) const { return find(item, strlen(item)); }
+
+    /** Find the string of len characters at item in ThreadedBST<string>
+     *  without constructing a string
+     */
+    iterator find(const char* item, size_t len) const {
+        return iterator(findNode(SearchKey<Data>(item, len)), &root);
+    }
+
+    /** Return the first item that is not less than item, or end() */
+    iterator lower_bound(const Data& item) const {
+        return iterator(boundNode(SearchKey<Data>(item), false), &root);
+    }
+
+    /** Return the first item that is greater than item, or end() */
+    iterator upper_bound(const Data& item) const {
+        return iterator(boundNode(SearchKey<Data>(item), true), &root);
+    }
+
+    /** Return the number of items */
+    unsigned int size() const { return isize; }
+
+    /** Return the height of the tree, -1 if empty */
+    int height() const { return iheight; }
+
+    /** Return true if the tree is empty */
+    bool empty() const { return root == nullptr; }
+
+    /** Return the first item */
+    iterator begin() const {
+        Node* curr = root;
+        if (curr != nullptr) {
+            while (!isThread(curr->left)) curr = target(curr->left);
+        }
+        return iterator(curr, &root);
+    }
+
+    /** Return an iterator pointing past the last item */
+    iterator end() const { return iterator(nullptr, &root); }
+
+    /** Return the items in order */
+    vector<Data> inorder() const {
+        vector<Data> vec;
+        for (iterator it = begin(); it != end(); ++it) vec.push_back(*it);
+        return vec;
+    }
+
+  private:
+    /** Return true if link is a thread, not a child */
+    static bool isThread(uintptr_t link) { return (link & THREAD) != 0; }
+
+    /** Return the node link points to, nullptr for a thread past either
+     *  end
+     */
+    static Node* target(uintptr_t link) {
+        return reinterpret_cast<Node*>(link & ~THREAD);
+    }
+
+    /** Return a thread to node */
+    static uintptr_t threadTo(Node* node) {
+        return reinterpret_cast<uintptr_t>(node) | THREAD;
+    }
+
+    /** Return the node holding key, or nullptr */
+    Node* findNode(const SearchKey<Data>& key) const {
+        Node* curr = root;
+        while (curr != nullptr) {
+            int order = key.compare(curr->data, *curr);
+            if (order == 0) return curr;
+            uintptr_t link = order < 0 ? curr->left : curr->right;
+            if (isThread(link)) return nullptr;
+            curr = target(link);
+        }
+        return nullptr;
+    }
+
+    /** Return the first node not less than key, or greater than key if
+     *  upper is true. Return nullptr if there is none.
+     */
+    Node* boundNode(const SearchKey<Data>& key, bool upper) const {
+        Node* bound = nullptr;
+        Node* curr = root;
+        while (curr != nullptr) {
+            int order = key.compare(curr->data, *curr);
+            uintptr_t link;
+            if (order < 0 || (order == 0 && !upper)) {
+                bound = curr;
+                link = curr->left;
+            } else {
+                link = curr->right;
+            }
+            curr = isThread(link) ? nullptr : target(link);
+        }
+        return bound;
+    }
+
+    /** Build a balanced subtree of the sorted items[start, end) in
+     *  storage[start, end), whose items come after the thread before and
+     *  before the thread after. Return the link to the subtree, or before
+     *  if it is empty.
+     */
+    static uintptr_t buildBalanced(vector<Data>& items,
+                                   const vector<void*>& storage, size_t start,
+                                   size_t end, uintptr_t before,
+                                   uintptr_t after) {
+        if (start == end) return before;
+        size_t mid = start + (end - start) / 2;
+        Node* node = new (storage[mid]) Node(move(items[mid]), before, after);
+        node->left =
+            buildBalanced(items, storage, start, mid, before, threadTo(node));
+        if (mid + 1 < end) {
+            node->right = buildBalanced(items, storage, mid + 1, end,
+                                        threadTo(node), after);
+        }
+        return reinterpret_cast<uintptr_t>(node);
+    }
+
+    /** Delete every node in order, without recursion: the successor of a
+     *  node is found before the node is deleted and never goes back to it
+     */
+    void deleteAll() {
+        Node* curr = root;
+        if (curr != nullptr) {
+            while (!isThread(curr->left)) curr = target(curr->left);
+        }
+        while (curr != nullptr) {
+            Node* next = curr->successor();
+            delete curr;
+            curr = next;
+        }
+        root = nullptr;
+    }
+};
+
+#endif  // THREADEDBST_HPP
@@ -0,0 +1,239 @@
+/**
+ * Brute force nearest neighbor and range search over a flat copy of the
+ * points, the right choice for few points or many dimensions, where a KD
+ * tree visits most of its nodes anyway.
+ *
+ * The coordinates are stored a dimension at a time (all the values of
+ * dimension 0, then of dimension 1, ...), so the distances to a block of
+ * points are computed by loops over contiguous arrays. The loops are
+ * written with GCC vector extensions, four values at a time, so that they
+ * use SIMD instructions even in the default debug build, where the
+ * compiler vectorizes nothing; other compilers run the scalar loops. Only
+ * the few distances below the current k-th best reach the heap.
+ *
+ * Unlike NaiveSearch nothing is written into the points, so a built
+ * BruteForce may be searched from several threads, and batches of queries
+ * are spread over threads.
+ */
+
+#ifndef BruteForce_hpp
+#define BruteForce_hpp
+
+#include <algorithm>
+#include <limits>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "Point.hpp"
+#include "PointReader.hpp"
+
+using namespace std;
+
+#ifdef __GNUC__
+/** Four doubles computed on at once, loaded from any double in memory */
+typedef double Lanes
+    __attribute__((vector_size(32), aligned(8), may_alias));
+
+/** Result of comparing Lanes: all ones where true, 0 where false */
+typedef long long LaneMask
+    __attribute__((vector_size(32), aligned(8), may_alias));
+#endif
+
+/** Call work(first, last) on consecutive ranges that cover [0, count),
+ *  one range per thread on numThreads threads (0: one per core), and
+ *  return when all are done. Ranges of fewer than minPerThread items are
+ *  not worth a thread.
+ */
+template <typename Work>
+void parallelRanges(size_t count, unsigned int numThreads, size_t minPerThread,
+                    Work work) {
+    if (numThreads == 0) numThreads = max(1u, thread::hardware_concurrency());
+    size_t maxThreads = max<size_t>(1, count / max<size_t>(1, minPerThread));
+    numThreads = (unsigned int)min<size_t>(numThreads, maxThreads);
+    if (numThreads <= 1) {
+        work(0, count);
+        return;
+    }
+    vector<thread> workers;
+    for (unsigned int t = 1; t < numThreads; t++) {
+        workers.emplace_back(work, count * t / numThreads,
+                             count * (t + 1) / numThreads);
+    }
+    work(0, count / numThreads);
+    for (thread& worker : workers) worker.join();
+}
+
+class BruteForce {
+  private:
+    // distances computed at a time, kept on the stack
+    static const size_t BLOCK = 256;
+
+    // values in Lanes
+    static const size_t LANES = 4;
+
+    // number of features of every point
+    unsigned int numDim;
+
+    // number of points
+    size_t n;
+
+    // value d of point i at columns[d * n + i]
+    vector<double> columns;
+
+  public:
+    /** Constructor of an empty search, see build() */
+    BruteForce() : numDim(0), n(0) {}
+
+    /** Copy points, which must all have the same number of dimensions */
+    void build(const vector<Point>& points) {
+        n = points.size();
+        numDim = n == 0 ? 0 : points[0].numDim;
+        columns.resize(n * numDim);
+        for (size_t i = 0; i < n; i++) {
+            for (unsigned int d = 0; d < numDim; d++) {
+                columns[d * n + i] = points[i].features[d];
+            }
+        }
+    }
+
+    /** Copy the points of a point set */
+    void build(const PointSet& points) {
+        n = points.size();
+        numDim = points.numDim;
+        columns.resize(n * numDim);
+        for (size_t i = 0; i < n; i++) {
+            for (unsigned int d = 0; d < numDim; d++) {
+                columns[d * n + i] = points.valueAt(i, d);
+            }
+        }
+    }
+
+    /** Return the number of points */
+    size_t size() const { return n; }
+
+    /** Return the number of dimensions of the points */
+    unsigned int dimension() const { return numDim; }
+
+    /** Return point i, in the order the points were given to build() */
+    Point pointAt(size_t i) const {
+        vector<double> features(numDim);
+        for (unsigned int d = 0; d < numDim; d++) {
+            features[d] = columns[d * n + i];
+        }
+        return Point(features);
+    }
+
+    /** Return the k points closest to queryPoint, nearest first, with
+     *  distToQuery set. Safe to call concurrently.
+     */
+    vector<Point> findKNearestNeighbors(const Point& queryPoint,
+                                        unsigned int k) const {
+        vector<Point> result;
+        if (n == 0 || k == 0 || queryPoint.numDim != numDim) return result;
+        vector<pair<double, size_t>> best;
+        nearest(queryPoint.features.data(), k, best);
+        for (pair<double, size_t>& neighbor : best) {
+            result.push_back(pointAt(neighbor.second));
+            result.back().distToQuery = neighbor.first;
+        }
+        return result;
+    }
+
+    /** Return the k nearest neighbors of every query, like the single
+     *  query version, searching on numThreads threads (0: one per core)
+     */
+    vector<vector<Point>> findKNearestNeighbors(const vector<Point>& queries,
+                                                unsigned int k,
+                                                unsigned int numThreads = 0)
+        const {
+        vector<vector<Point>> results(queries.size());
+        // points scanned that make a query worth a thread
+        const size_t MIN_WORK = 1 << 16;
+        size_t minQueries = max<size_t>(1, MIN_WORK / max<size_t>(1, n));
+        parallelRanges(queries.size(), numThreads, minQueries,
+                       [&](size_t first, size_t last) {
+                           for (size_t i = first; i < last; i++) {
+                               results[i] =
+                                   findKNearestNeighbors(queries[i], k);
+                           }
+                       });
+        return results;
+    }
+
+    /** Return all points inside queryRegion, one inclusive [min, max] pair
+     *  per dimension. Safe to call concurrently.
+     */
+    vector<Point> rangeSearch(
+        const vector<pair<double, double>>& queryRegion) const {
+        vector<Point> result;
+        if (n == 0 || queryRegion.size() != numDim) return result;
+        // all ones for the points inside the region so far, 0 for the others
+        long long inside[BLOCK];
+        for (size_t start = 0; start < n; start += BLOCK) {
+            size_t len = n - start < BLOCK ? n - start : BLOCK;
+            for (size_t j = 0; j < len; j++) inside[j] = -1;
+            for (unsigned int d = 0; d < numDim; d++) {
+                const double* column = columns.data() + d * n + start;
+                double lo = queryRegion[d].first;
+                double hi = queryRegion[d].second;
+                size_t j = 0;
+#ifdef __GNUC__
+                for (; j + LANES <= len; j += LANES) {
+                    Lanes values = *(const Lanes*)(column + j);
+                    *(LaneMask*)(inside + j) &= (values >= lo) & (values <= hi);
+                }
+#endif
+                for (; j < len; j++) {
+                    inside[j] &= -(long long)((column[j] >= lo) &
+                                              (column[j] <= hi));
+                }
+            }
+            for (size_t j = 0; j < len; j++) {
+                if (inside[j]) result.push_back(pointAt(start + j));
+            }
+        }
+        return result;
+    }
+
+  private:
+    /** Set best to the k (squared distance, index) pairs closest to query,
+     *  nearest first
+     */
+    void nearest(const double* query, unsigned int k,
+                 vector<pair<double, size_t>>& best) const {
+        double dist[BLOCK];
+        double threshold = numeric_limits<double>::max();
+        for (size_t start = 0; start < n; start += BLOCK) {
+            size_t len = n - start < BLOCK ? n - start : BLOCK;
+            for (size_t j = 0; j < len; j++) dist[j] = 0;
+            for (unsigned int d = 0; d < numDim; d++) {
+                const double* column = columns.data() + d * n + start;
+                double q = query[d];
+                size_t j = 0;
+#ifdef __GNUC__
+                for (; j + LANES <= len; j += LANES) {
+                    Lanes diff = *(const Lanes*)(column + j) - q;
+                    *(Lanes*)(dist + j) += diff * diff;
+                }
+#endif
+                for (; j < len; j++) {
+                    double diff = column[j] - q;
+                    dist[j] += diff * diff;
+                }
+            }
+            for (size_t j = 0; j < len; j++) {
+                if (dist[j] >= threshold) continue;
+                if (best.size() == k) {
+                    pop_heap(best.begin(), best.end());
+                    best.pop_back();
+                }
+                best.emplace_back(dist[j], start + j);
+                push_heap(best.begin(), best.end());
+                if (best.size() == k) threshold = best.front().first;
+            }
+        }
+        sort_heap(best.begin(), best.end());
+    }
+};
+
+#endif /* BruteForce_hpp */
@@ -0,0 +1,985 @@
+/**
+ * Disk-resident KD tree for point sets larger than memory.
+ *
+ * buildIndex() bulk-loads an index from a text or binary point file in
+ * external memory, keeping to a memory budget:
+ *   1. one sequential pass counts the points, finds their box and draws a
+ *      random sample that fits in half the budget,
+ *   2. a top tree is built from the sample, splitting on the dimension
+ *      where the sample is widest, until each leaf is expected to hold at
+ *      most half a bucket; dimensions on which all the points are equal
+ *      are never split on,
+ *   3. a second sequential pass routes every point through the top into
+ *      an on-disk part file,
+ *   4. a part that fits the budget is loaded, arranged in place into a
+ *      subtree and appended to the index as a bucket. A part that does
+ *      not, because the sample missed its points, is split again the same
+ *      way, at the middle of its box if its sample cannot split it, and in
+ *      runs of equal points if all its points are equal.
+ *
+ * The index file holds, in little-endian byte order like the binary point
+ * files:
+ *   DiskIndexHeader
+ *   points      the points of every bucket, numDim doubles each
+ *   nodes       numNodes top nodes {double split, uint32 dim, uint32
+ *               numBuckets, uint64 next}, the root first
+ *   buckets     numBuckets {uint64 first point, uint64 point count}
+ *   boxes       numBuckets bounding boxes of numDim [min, max] doubles
+ *
+ * The top holds every split of the build, the splits of parts that were
+ * split again below the leaves they came from. An inner node sends the
+ * points less than split on dim to node next and the others to next + 1;
+ * a leaf holds the numBuckets buckets from bucket next on, more than one
+ * only for runs of equal points.
+ *
+ * The points of a bucket are stored as an implicit KD tree: the root of
+ * the points [start, end] is the median at (start + end) / 2, splitting on
+ * dimension depth % numDim from dimension 0, like KDT::buildSubtree().
+ * open() keeps the top, the bucket table and the boxes in memory and maps
+ * the points. A query descends the top and reads only the buckets it
+ * reaches whose boxes can still hold an answer.
+ */
+
+#ifndef DiskKDT_hpp
+#define DiskKDT_hpp
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Point.hpp"
+#include "PointFile.hpp"
+#include "QueryStream.hpp"
+
+using namespace std;
+
+const char DISK_INDEX_MAGIC[8] = {'K', 'D', 'T', 'I', 'N', 'D', 'E', 'X'};
+const uint32_t DISK_INDEX_VERSION = 3;
+
+struct DiskIndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t numDim;
+    uint64_t count;
+    uint32_t numBuckets;
+    uint32_t numNodes;
+};
+
+static_assert(sizeof(DiskIndexHeader) == 32, "header must be packed");
+
+class DiskKDT {
+  private:
+    /** Position of a bucket in the points section */
+    struct Bucket {
+        uint64_t first;
+        uint64_t count;
+    };
+
+    /** Node of the top: an inner node sends the points whose value on dim
+     *  is less than split to node next, the others to next + 1; a leaf,
+     *  with dim LEAF, holds the numBuckets buckets from bucket next on.
+     *  While the build routes points through a split, next of a leaf is
+     *  the part its points go to.
+     */
+    struct IndexNode {
+        double split;
+        uint32_t dim;
+        uint32_t numBuckets;
+        uint64_t next;
+    };
+
+    static_assert(sizeof(IndexNode) == 24, "node must be packed");
+
+    static const unsigned int LEAF = numeric_limits<unsigned int>::max();
+
+    /** State of one buildIndex() */
+    struct Builder {
+        unsigned int numDim;
+        size_t memoryBudget;
+        size_t sampleSize;
+        // most points in a bucket, which is loaded whole
+        uint64_t capacity;
+        // points read per block
+        size_t blockPoints;
+        int out;
+        string partPrefix;
+        unsigned int numParts;
+        vector<IndexNode> nodes;
+        vector<Bucket> table;
+        vector<pair<double, double>> boxes;
+        mt19937_64 random;
+    };
+
+    DiskIndexHeader header;
+
+    // in-memory top, bucket table and boxes
+    vector<IndexNode> nodes;
+    vector<Bucket> buckets;
+    vector<pair<double, double>> boxes;
+
+    // mapped index file and its points section
+    void* mapped;
+    size_t mappedLength;
+    const double* points;
+
+  public:
+    /** Constructor of an empty index, see open() */
+    DiskKDT() : mapped(nullptr), mappedLength(0), points(nullptr) {
+        header = {};
+    }
+
+    /** Destructor, unmaps the index */
+    ~DiskKDT() { close(); }
+
+    DiskKDT(const DiskKDT&) = delete;
+    DiskKDT& operator=(const DiskKDT&) = delete;
+
+    /** Build an index of the points in inputFile (text or binary) into
+     *  indexFile, using about memoryBudget bytes of memory and a sample of
+     *  at most sampleSize points to pick the top splits. Part files are
+     *  written next to indexFile and removed afterwards. Return false on
+     *  I/O error or if inputFile holds a value that is not a number.
+     */
+    static bool buildIndex(const char* inputFile, const char* indexFile,
+                           size_t memoryBudget = (size_t)256 << 20,
+                           size_t sampleSize = 1 << 16) {
+        Builder build;
+        build.numDim = pointFileDimension(inputFile);
+        if (build.numDim == 0) return false;
+        size_t pointBytes = build.numDim * sizeof(double);
+        build.memoryBudget = memoryBudget;
+        // the sample and the order the top is built in take half the budget
+        build.sampleSize = max<size_t>(
+            2, min(sampleSize,
+                   memoryBudget / 2 / (pointBytes + sizeof(uint32_t))));
+        build.capacity = max<size_t>(1, memoryBudget / pointBytes);
+        build.blockPoints = max<size_t>(
+            1, min<size_t>(1 << 14, memoryBudget / 8 / pointBytes));
+        build.partPrefix = string(indexFile) + ".bucket.";
+        build.numParts = 0;
+        build.random.seed(42);
+
+        build.out = ::open(indexFile, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (build.out < 0) return false;
+        // the header is written last, once the buckets are known
+        DiskIndexHeader newHeader = {};
+        bool ok = writeAll(build.out, &newHeader, sizeof(newHeader));
+
+        uint64_t count;
+        vector<pair<double, double>> box;
+        vector<double> sample;
+        build.nodes.resize(1);
+        ok = ok && scan(build, inputFile, false, count, box, sample) &&
+             place(build, inputFile, false, count, box, sample, 0);
+
+        memcpy(newHeader.magic, DISK_INDEX_MAGIC, sizeof(newHeader.magic));
+        newHeader.version = DISK_INDEX_VERSION;
+        newHeader.numDim = build.numDim;
+        newHeader.count = ok ? count : 0;
+        newHeader.numBuckets = build.table.size();
+        newHeader.numNodes = build.nodes.size();
+        ok = ok && build.table.size() <= numeric_limits<uint32_t>::max() &&
+             build.nodes.size() <= numeric_limits<uint32_t>::max();
+        // the tables are converted in place, they are not used after this
+        swapNodes(build.nodes);
+        swapToLittleEndian(build.table.data(), 2 * build.table.size(),
+                           sizeof(uint64_t));
+        swapToLittleEndian(build.boxes.data(), 2 * build.boxes.size(),
+                           sizeof(double));
+        swapHeader(newHeader);
+        ok = ok &&
+             writeAll(build.out, build.nodes.data(),
+                      build.nodes.size() * sizeof(IndexNode)) &&
+             writeAll(build.out, build.table.data(),
+                      build.table.size() * sizeof(Bucket)) &&
+             writeAll(build.out, build.boxes.data(),
+                      build.boxes.size() * sizeof(pair<double, double>)) &&
+             lseek(build.out, 0, SEEK_SET) == 0 &&
+             writeAll(build.out, &newHeader, sizeof(newHeader));
+        if (::close(build.out) != 0) ok = false;
+        return ok;
+    }
+
+    /** Open the index in indexFile. Return false if it cannot be read */
+    bool open(const char* indexFile) {
+        close();
+        int fd = ::open(indexFile, O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info;
+        if (fstat(fd, &info) < 0 || (size_t)info.st_size < sizeof(header)) {
+            ::close(fd);
+            return false;
+        }
+        mappedLength = info.st_size;
+        mapped = mmap(nullptr, mappedLength, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            mapped = nullptr;
+            return false;
+        }
+        const char* data = (const char*)mapped;
+        memcpy(&header, data, sizeof(header));
+        swapHeader(header);
+        size_t numBuckets = header.numBuckets;
+        size_t numNodes = header.numNodes;
+        size_t pointsBytes = header.count * header.numDim * sizeof(double);
+        if (memcmp(header.magic, DISK_INDEX_MAGIC, sizeof(header.magic)) !=
+                0 ||
+            header.version != DISK_INDEX_VERSION || header.numDim == 0 ||
+            numNodes == 0 || header.count > mappedLength / sizeof(double) ||
+            sizeof(header) + pointsBytes + numNodes * sizeof(IndexNode) +
+                    numBuckets * sizeof(Bucket) +
+                    numBuckets * header.numDim * 2 * sizeof(double) !=
+                mappedLength) {
+            close();
+            return false;
+        }
+        points = (const double*)(data + sizeof(header));
+        // copy the top, the bucket table and the boxes out of the mapping
+        // so they stay in memory
+        const char* p = data + sizeof(header) + pointsBytes;
+        nodes.assign((const IndexNode*)p, (const IndexNode*)p + numNodes);
+        p += numNodes * sizeof(IndexNode);
+        buckets.assign((const Bucket*)p, (const Bucket*)p + numBuckets);
+        p += numBuckets * sizeof(Bucket);
+        boxes.assign((const pair<double, double>*)p,
+                     (const pair<double, double>*)p +
+                         numBuckets * header.numDim);
+        swapNodes(nodes);
+        swapToLittleEndian(buckets.data(), 2 * buckets.size(),
+                           sizeof(uint64_t));
+        swapToLittleEndian(boxes.data(), 2 * boxes.size(), sizeof(double));
+        if (!tablesValid()) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    /** Unmap the index */
+    void close() {
+        if (mapped != nullptr) munmap(mapped, mappedLength);
+        mapped = nullptr;
+        mappedLength = 0;
+        points = nullptr;
+        nodes.clear();
+        buckets.clear();
+        boxes.clear();
+        header = {};
+    }
+
+    /** Return the number of points in the index */
+    uint64_t size() const { return header.count; }
+
+    /** Return the number of dimensions of the points */
+    unsigned int dimension() const { return header.numDim; }
+
+    /** Return the number of buckets */
+    unsigned int numBuckets() const { return header.numBuckets; }
+
+    /** Return the number of points in the largest bucket */
+    uint64_t largestBucket() const {
+        uint64_t largest = 0;
+        for (const Bucket& bucket : buckets) {
+            largest = max(largest, bucket.count);
+        }
+        return largest;
+    }
+
+    /** Return the k points closest to queryPoint, nearest first, with
+     *  distToQuery set. If visited is given, the number of buckets searched
+     *  is added to it. Safe to call concurrently.
+     */
+    vector<Point> findKNearestNeighbors(
+        const Point& queryPoint, unsigned int k,
+        unsigned long long* visited = nullptr) const {
+        vector<Point> result;
+        if (points == nullptr || k == 0 || header.count == 0 ||
+            queryPoint.numDim != header.numDim) {
+            return result;
+        }
+        Search search(queryPoint.features.data(), header.numDim, k);
+        searchTop(0, search);
+        sort_heap(search.best.begin(), search.best.end());
+        for (pair<double, uint64_t>& neighbor : search.best) {
+            const double* p = pointAt(neighbor.second, search.scratch.data());
+            result.emplace_back(vector<double>(p, p + header.numDim));
+            result.back().distToQuery = neighbor.first;
+        }
+        if (visited != nullptr) *visited += search.visited;
+        return result;
+    }
+
+    /** Return all points inside queryRegion, one inclusive [min, max] pair
+     *  per dimension. Safe to call concurrently.
+     */
+    vector<Point> rangeSearch(
+        const vector<pair<double, double>>& queryRegion) const {
+        vector<Point> result;
+        if (points == nullptr || queryRegion.size() != header.numDim) {
+            return result;
+        }
+        vector<double> scratch(header.numDim);
+        rangeTop(0, queryRegion, scratch.data(), result);
+        return result;
+    }
+
+  private:
+    /** Read the points of fileName in blocks of build.blockPoints and pass
+     *  each to visit. A raw file holds bare doubles, as the part files do;
+     *  any other is a point file. Return false if the file cannot be read
+     *  to its end.
+     */
+    template <typename Visitor>
+    static bool forEachBlock(const Builder& build, const string& fileName,
+                             bool raw, Visitor visit) {
+        unsigned int numDim = build.numDim;
+        size_t pointBytes = numDim * sizeof(double);
+        int fd = ::open(fileName.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        vector<double> block(build.blockPoints * numDim);
+        bool ok = true;
+        if (raw) {
+            char* bytes = (char*)block.data();
+            size_t blockBytes = block.size() * sizeof(double);
+            size_t filled = 0;
+            while (true) {
+                ssize_t got = read(fd, bytes + filled, blockBytes - filled);
+                if (got < 0 && errno == EINTR) continue;
+                if (got < 0) {
+                    ok = false;
+                    break;
+                }
+                filled += got;
+                if (filled == blockBytes || got == 0) {
+                    if (filled >= pointBytes) {
+                        visit(block.data(), filled / pointBytes);
+                    }
+                    // a part file ends on a whole point
+                    if (got == 0) {
+                        ok = filled % pointBytes == 0;
+                        break;
+                    }
+                    filled = 0;
+                }
+            }
+        } else {
+            QueryReader reader(fd, numDim,
+                               max<size_t>(1 << 12, min<size_t>(
+                                   1 << 20, build.memoryBudget / 8)));
+            size_t n;
+            while ((n = reader.readPoints(block.data(), build.blockPoints)) >
+                   0) {
+                visit(block.data(), n);
+            }
+            ok = !reader.failed();
+        }
+        ::close(fd);
+        return ok;
+    }
+
+    /** Count the points of fileName, find their box and draw a uniform
+     *  sample of at most build.sampleSize of them
+     */
+    static bool scan(Builder& build, const string& fileName, bool raw,
+                     uint64_t& count, vector<pair<double, double>>& box,
+                     vector<double>& sample) {
+        unsigned int numDim = build.numDim;
+        count = 0;
+        box.assign(numDim, make_pair(numeric_limits<double>::max(),
+                                     -numeric_limits<double>::max()));
+        sample.clear();
+        return forEachBlock(build, fileName, raw, [&](const double* block,
+                                                      size_t n) {
+            for (size_t i = 0; i < n; i++, count++) {
+                const double* p = block + i * numDim;
+                extend(box, p);
+                if (count < build.sampleSize) {
+                    sample.insert(sample.end(), p, p + numDim);
+                    continue;
+                }
+                uint64_t slot = build.random() % (count + 1);
+                if (slot < build.sampleSize) {
+                    copy(p, p + numDim, sample.begin() + slot * numDim);
+                }
+            }
+        });
+    }
+
+    /** Grow box to hold point p */
+    static void extend(vector<pair<double, double>>& box, const double* p) {
+        for (size_t d = 0; d < box.size(); d++) {
+            box[d].first = min(box[d].first, p[d]);
+            box[d].second = max(box[d].second, p[d]);
+        }
+    }
+
+    /** Append the count points of fileName, whose box is box, to the index
+     *  in buckets of at most build.capacity points, splitting them through
+     *  a top built from sample if they do not fit in one. The top and the
+     *  buckets go below build.nodes[node].
+     */
+    static bool place(Builder& build, const string& fileName, bool raw,
+                      uint64_t count, const vector<pair<double, double>>& box,
+                      vector<double>& sample, size_t node) {
+        unsigned int numDim = build.numDim;
+        uint64_t firstBucket = build.table.size();
+        if (count == 0) {
+            build.nodes[node] = {0, LEAF, 0, firstBucket};
+            return true;
+        }
+        if (count <= build.capacity) {
+            build.nodes[node] = {0, LEAF, 1, firstBucket};
+            return writeBucket(build, fileName, raw, count, box);
+        }
+        unsigned int widest = widestDimension(box);
+        if (box[widest].first == box[widest].second) {
+            bool ok = writeEqualRuns(build, fileName, raw, count, box);
+            build.nodes[node] = {
+                0, LEAF, (uint32_t)(build.table.size() - firstBucket),
+                firstBucket};
+            return ok;
+        }
+
+        // the parts each get a buffer of at least 4 KB in half the budget
+        size_t maxParts = max<size_t>(2, build.memoryBudget / 2 / 4096);
+        vector<IndexNode> top(1);
+        vector<uint32_t> order(sample.size() / numDim);
+        for (uint32_t i = 0; i < order.size(); i++) order[i] = i;
+        size_t numParts = 0;
+        buildTop(build, sample, order, 0, order.size(), (double)count,
+                 maxParts, top, 0, numParts);
+        if (numParts < 2) {
+            // the sample holds too few distinct points, split the box in
+            // the middle, which leaves points on both sides
+            double lo = box[widest].first;
+            double hi = box[widest].second;
+            double middle = lo + (hi - lo) / 2;
+            top.assign(3, {0, LEAF, 0, 0});
+            top[0] = {middle > lo ? middle : hi, widest, 0, 1};
+            top[2].next = 1;
+            numParts = 2;
+        }
+        vector<size_t> partNodes(numParts);
+        graft(build, top, 0, node, partNodes);
+        sample.clear();
+        sample.shrink_to_fit();
+        order.clear();
+        order.shrink_to_fit();
+
+        // route the points to part files, tracking their sizes and boxes
+        vector<string> partFiles;
+        for (size_t i = 0; i < numParts; i++) {
+            partFiles.push_back(build.partPrefix +
+                                to_string(build.numParts++));
+            unlink(partFiles.back().c_str());
+        }
+        vector<uint64_t> counts(numParts, 0);
+        vector<vector<pair<double, double>>> partBoxes(
+            numParts, vector<pair<double, double>>(
+                          numDim, make_pair(numeric_limits<double>::max(),
+                                            -numeric_limits<double>::max())));
+        size_t bufferValues = max<size_t>(
+            numDim, build.memoryBudget / 2 / numParts / sizeof(double));
+        vector<vector<double>> pending(numParts);
+        bool ok = true;
+        ok = forEachBlock(build, fileName, raw, [&](const double* block,
+                                                    size_t n) {
+            for (size_t i = 0; ok && i < n; i++) {
+                const double* p = block + i * numDim;
+                size_t part = route(top, p);
+                counts[part]++;
+                extend(partBoxes[part], p);
+                pending[part].insert(pending[part].end(), p, p + numDim);
+                if (pending[part].size() >= bufferValues) {
+                    ok = appendToFile(partFiles[part], pending[part]);
+                }
+            }
+        }) && ok;
+        for (size_t i = 0; ok && i < numParts; i++) {
+            ok = appendToFile(partFiles[i], pending[i]);
+        }
+        pending.clear();
+        pending.shrink_to_fit();
+
+        // a part the sample misjudged is scanned to split it again
+        for (size_t i = 0; i < numParts; i++) {
+            if (ok && counts[i] > build.capacity) {
+                ok = scan(build, partFiles[i], true, counts[i], partBoxes[i],
+                          sample);
+            }
+            ok = ok && place(build, partFiles[i], true, counts[i],
+                             partBoxes[i], sample, partNodes[i]);
+            unlink(partFiles[i].c_str());
+        }
+        return ok;
+    }
+
+    /** Build top node `node` from the sample points order[start, end),
+     *  which stand for estimate points, into at most maxParts parts.
+     *  numParts counts the parts made so far.
+     */
+    static void buildTop(const Builder& build, const vector<double>& sample,
+                         vector<uint32_t>& order, size_t start, size_t end,
+                         double estimate, size_t maxParts,
+                         vector<IndexNode>& top, size_t node,
+                         size_t& numParts) {
+        unsigned int numDim = build.numDim;
+        // leaves aim at half a bucket, so that most parts fit one even
+        // though the sample misjudges their size
+        bool split = maxParts >= 2 && end - start >= 2 &&
+                     estimate > build.capacity / 2.0;
+        unsigned int dim = 0;
+        double lo = 0;
+        double hi = 0;
+        if (split) {
+            vector<pair<double, double>> box(
+                numDim, make_pair(numeric_limits<double>::max(),
+                                  -numeric_limits<double>::max()));
+            for (size_t i = start; i < end; i++) {
+                extend(box, &sample[order[i] * numDim]);
+            }
+            dim = widestDimension(box);
+            lo = box[dim].first;
+            hi = box[dim].second;
+            split = lo < hi;
+        }
+        if (!split) {
+            top[node] = {0, LEAF, 0, numParts++};
+            return;
+        }
+        auto value = [&](uint32_t i) { return sample[i * numDim + dim]; };
+        size_t medi = start + (end - start) / 2;
+        nth_element(order.begin() + start, order.begin() + medi,
+                    order.begin() + end,
+                    [&](uint32_t a, uint32_t b) { return value(a) < value(b); });
+        double median = value(order[medi]);
+        if (median == lo) {
+            // points equal to the split go right: split above the lowest
+            // value instead, so that the left side is not empty
+            median = hi;
+            for (size_t i = start; i < end; i++) {
+                if (value(order[i]) > lo) median = min(median, value(order[i]));
+            }
+        }
+        size_t mid = partition(order.begin() + start, order.begin() + end,
+                               [&](uint32_t a) { return value(a) < median; }) -
+                     order.begin();
+        size_t left = top.size();
+        top.resize(top.size() + 2);
+        top[node] = {median, dim, 0, left};
+        buildTop(build, sample, order, start, mid,
+                 estimate * (mid - start) / (end - start), maxParts / 2, top,
+                 left, numParts);
+        buildTop(build, sample, order, mid, end,
+                 estimate * (end - mid) / (end - start),
+                 maxParts - maxParts / 2, top, left + 1, numParts);
+    }
+
+    /** Return the dimension in which box is widest */
+    static unsigned int widestDimension(
+        const vector<pair<double, double>>& box) {
+        unsigned int widest = 0;
+        for (unsigned int d = 1; d < box.size(); d++) {
+            if (box[d].second - box[d].first >
+                box[widest].second - box[widest].first) {
+                widest = d;
+            }
+        }
+        return widest;
+    }
+
+    /** Copy the subtree at local of the top of a split into build.nodes at
+     *  node, recording the index node of every part in partNodes
+     */
+    static void graft(Builder& build, const vector<IndexNode>& top,
+                      size_t local, size_t node, vector<size_t>& partNodes) {
+        const IndexNode& from = top[local];
+        if (from.dim == LEAF) {
+            partNodes[from.next] = node;
+            return;
+        }
+        size_t left = build.nodes.size();
+        build.nodes.resize(left + 2);
+        build.nodes[node] = {from.split, from.dim, 0, left};
+        graft(build, top, from.next, left, partNodes);
+        graft(build, top, from.next + 1, left + 1, partNodes);
+    }
+
+    /** Return the part of point p */
+    static size_t route(const vector<IndexNode>& top, const double* p) {
+        const IndexNode* node = &top[0];
+        while (node->dim != LEAF) {
+            node = &top[p[node->dim] < node->split ? node->next
+                                                   : node->next + 1];
+        }
+        return node->next;
+    }
+
+    /** Write len bytes to fd. Return false on error */
+    static bool writeAll(int fd, const void* src, size_t len) {
+        const char* in = (const char*)src;
+        while (len > 0) {
+            ssize_t written = write(fd, in, len);
+            if (written < 0 && errno == EINTR) continue;
+            if (written <= 0) return false;
+            in += written;
+            len -= written;
+        }
+        return true;
+    }
+
+    /** Append values to fileName and clear them. Return false on error */
+    static bool appendToFile(const string& fileName, vector<double>& values) {
+        if (values.empty()) return true;
+        int fd = ::open(fileName.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (fd < 0) return false;
+        bool ok = writeAll(fd, values.data(), values.size() * sizeof(double));
+        ok = ::close(fd) == 0 && ok;
+        values.clear();
+        return ok;
+    }
+
+    /** Add a bucket of count points with box box to the table */
+    static void addBucket(Builder& build, uint64_t count,
+                          const vector<pair<double, double>>& box) {
+        uint64_t first = build.table.empty()
+                             ? 0
+                             : build.table.back().first +
+                                   build.table.back().count;
+        build.table.push_back({first, count});
+        build.boxes.insert(build.boxes.end(), box.begin(), box.end());
+    }
+
+    /** Load the count points of fileName, arrange them in place as an
+     *  implicit KD tree and append them to the index as one bucket
+     */
+    static bool writeBucket(Builder& build, const string& fileName, bool raw,
+                            uint64_t count,
+                            const vector<pair<double, double>>& box) {
+        unsigned int numDim = build.numDim;
+        vector<double> coords;
+        coords.reserve(count * numDim);
+        bool ok = forEachBlock(build, fileName, raw, [&](const double* block,
+                                                         size_t n) {
+            coords.insert(coords.end(), block, block + n * numDim);
+        });
+        if (!ok || coords.size() != count * numDim) return false;
+        arrangeSubtree(coords.data(), numDim, 0, count, 0);
+        addBucket(build, count, box);
+        swapToLittleEndian(coords.data(), coords.size(), sizeof(double));
+        return writeAll(build.out, coords.data(),
+                        coords.size() * sizeof(double));
+    }
+
+    /** Append the count points of fileName, which are all equal, to the
+     *  index in buckets of build.capacity points. They cannot be told apart
+     *  by any split, and in any order they form a KD tree.
+     */
+    static bool writeEqualRuns(Builder& build, const string& fileName,
+                               bool raw, uint64_t count,
+                               const vector<pair<double, double>>& box) {
+        uint64_t copied = 0;
+        bool ok = true;
+        // a copy of each block on big-endian hosts, to swap
+        vector<double> swapped;
+        ok = forEachBlock(build, fileName, raw, [&](const double* block,
+                                                    size_t n) {
+            size_t numValues = n * build.numDim;
+            if (!hostIsLittleEndian()) {
+                swapped.assign(block, block + numValues);
+                swapToLittleEndian(swapped.data(), numValues, sizeof(double));
+                block = swapped.data();
+            }
+            ok = ok && writeAll(build.out, block, numValues * sizeof(double));
+            copied += n;
+        }) && ok;
+        if (!ok || copied != count) return false;
+        for (uint64_t first = 0; first < count; first += build.capacity) {
+            addBucket(build, min(build.capacity, count - first), box);
+        }
+        return true;
+    }
+
+    /** Arrange the points [start, end) of coords as an implicit KD tree
+     *  whose root splits on dimension curDim: the median on curDim goes in
+     *  the middle, recursively for both halves
+     */
+    static void arrangeSubtree(double* coords, unsigned int numDim,
+                               size_t start, size_t end, unsigned int curDim) {
+        if (end - start <= 1) return;
+        size_t medi = start + (end - 1 - start) / 2;
+        selectPoint(coords, numDim, start, end, medi, curDim);
+        unsigned int nextDim = (curDim + 1) % numDim;
+        arrangeSubtree(coords, numDim, start, medi, nextDim);
+        arrangeSubtree(coords, numDim, medi + 1, end, nextDim);
+    }
+
+    /** Move the points [start, end) of coords so that point k is the one
+     *  that belongs there in order of dimension dim, with no greater point
+     *  before it and no smaller one after. Runs of equal values are
+     *  partitioned three ways so that they take linear time.
+     */
+    static void selectPoint(double* coords, unsigned int numDim, size_t start,
+                            size_t end, size_t k, unsigned int dim) {
+        auto value = [&](size_t i) { return coords[i * numDim + dim]; };
+        auto swapPoints = [&](size_t a, size_t b) {
+            swap_ranges(coords + a * numDim, coords + (a + 1) * numDim,
+                        coords + b * numDim);
+        };
+        while (end - start > 1) {
+            // median of three as the pivot
+            double a = value(start);
+            double b = value(start + (end - start) / 2);
+            double c = value(end - 1);
+            double pivot = max(min(a, b), min(max(a, b), c));
+            // [start, less) < pivot, [less, i) == pivot, [more, end) > pivot
+            size_t less = start;
+            size_t i = start;
+            size_t more = end;
+            while (i < more) {
+                if (value(i) < pivot) {
+                    swapPoints(less++, i++);
+                } else if (value(i) > pivot) {
+                    swapPoints(i, --more);
+                } else {
+                    i++;
+                }
+            }
+            if (k < less) {
+                end = less;
+            } else if (k >= more) {
+                start = more;
+            } else {
+                return;
+            }
+        }
+    }
+
+    /** Convert the fields of header between little-endian and host order */
+    static void swapHeader(DiskIndexHeader& header) {
+        swapToLittleEndian(&header.version, 2, sizeof(uint32_t));
+        swapToLittleEndian(&header.count, 1, sizeof(uint64_t));
+        swapToLittleEndian(&header.numBuckets, 2, sizeof(uint32_t));
+    }
+
+    /** Convert the fields of nodes between little-endian and host order */
+    static void swapNodes(vector<IndexNode>& nodes) {
+        for (IndexNode& node : nodes) {
+            swapToLittleEndian(&node.split, 1, sizeof(double));
+            swapToLittleEndian(&node.dim, 2, sizeof(uint32_t));
+            swapToLittleEndian(&node.next, 1, sizeof(uint64_t));
+        }
+    }
+
+    /** Return true if the buckets cover the points in order, and every
+     *  node of the top names children after it or buckets in the table
+     */
+    bool tablesValid() const {
+        uint64_t first = 0;
+        for (const Bucket& bucket : buckets) {
+            if (bucket.first != first || bucket.count > header.count - first) {
+                return false;
+            }
+            first += bucket.count;
+        }
+        if (first != header.count) return false;
+        for (size_t i = 0; i < nodes.size(); i++) {
+            const IndexNode& node = nodes[i];
+            if (node.dim == LEAF) {
+                if (node.next > buckets.size() ||
+                    node.numBuckets > buckets.size() - node.next) {
+                    return false;
+                }
+            } else if (node.dim >= header.numDim || node.next <= i ||
+                       node.next >= nodes.size() - 1) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /** Return point i, straight from the mapping, or on big-endian hosts
+     *  swapped into scratch, which holds numDim values
+     */
+    const double* pointAt(uint64_t i, double* scratch) const {
+        const double* p = points + i * header.numDim;
+        if (hostIsLittleEndian()) return p;
+        memcpy(scratch, p, header.numDim * sizeof(double));
+        swapToLittleEndian(scratch, header.numDim, sizeof(double));
+        return scratch;
+    }
+
+    /** State of one nearest neighbor search */
+    struct Search {
+        const double* q;
+        unsigned int k;
+        // the k closest so far as {squared distance, point}, a max-heap
+        vector<pair<double, uint64_t>> best;
+        // room for one point read on a big-endian host
+        vector<double> scratch;
+        // buckets searched
+        unsigned long long visited;
+
+        Search(const double* q, unsigned int numDim, unsigned int k)
+            : q(q), k(k), scratch(numDim), visited(0) {}
+
+        /** Return true if a point at squared distance dist may be kept */
+        bool mayKeep(double dist) const {
+            return best.size() < k || dist < best.front().first;
+        }
+    };
+
+    /** Search the top below node, the query's side of a split first and
+     *  the other side if it may hold a closer point, and in the leaves the
+     *  buckets whose boxes may
+     */
+    void searchTop(uint64_t node, Search& search) const {
+        const IndexNode& n = nodes[node];
+        if (n.dim == LEAF) {
+            for (uint64_t b = n.next; b < n.next + n.numBuckets; b++) {
+                const Bucket& bucket = buckets[b];
+                if (bucket.count == 0 ||
+                    !search.mayKeep(boxDistance(b, search.q))) {
+                    continue;
+                }
+                search.visited++;
+                searchSubtree(bucket.first, bucket.first + bucket.count - 1,
+                              0, search);
+            }
+            return;
+        }
+        double diff = search.q[n.dim] - n.split;
+        // points equal to the split are on the right
+        uint64_t near = diff < 0 ? n.next : n.next + 1;
+        searchTop(near, search);
+        if (search.mayKeep(diff * diff)) {
+            searchTop(near == n.next ? n.next + 1 : n.next, search);
+        }
+    }
+
+    /** Collect the points below node of the top that lie in queryRegion,
+     *  from the buckets whose boxes overlap it
+     */
+    void rangeTop(uint64_t node,
+                  const vector<pair<double, double>>& queryRegion,
+                  double* scratch, vector<Point>& result) const {
+        const IndexNode& n = nodes[node];
+        if (n.dim != LEAF) {
+            if (queryRegion[n.dim].first < n.split) {
+                rangeTop(n.next, queryRegion, scratch, result);
+            }
+            if (queryRegion[n.dim].second >= n.split) {
+                rangeTop(n.next + 1, queryRegion, scratch, result);
+            }
+            return;
+        }
+        for (uint64_t b = n.next; b < n.next + n.numBuckets; b++) {
+            const Bucket& bucket = buckets[b];
+            bool overlaps = bucket.count > 0;
+            for (unsigned int d = 0; overlaps && d < header.numDim; d++) {
+                const pair<double, double>& range =
+                    boxes[b * header.numDim + d];
+                overlaps = range.first <= queryRegion[d].second &&
+                           range.second >= queryRegion[d].first;
+            }
+            if (overlaps) {
+                rangeSubtree(bucket.first, bucket.first + bucket.count - 1, 0,
+                             queryRegion, scratch, result);
+            }
+        }
+    }
+
+    /** Return the squared distance from q to the box of bucket b */
+    double boxDistance(uint64_t b, const double* q) const {
+        double dist = 0;
+        for (unsigned int d = 0; d < header.numDim; d++) {
+            const pair<double, double>& range = boxes[b * header.numDim + d];
+            double gap = max(0.0, max(range.first - q[d], q[d] - range.second));
+            dist += gap * gap;
+        }
+        return dist;
+    }
+
+    /** Search the implicit subtree of the points [start, end] (inclusive,
+     *  signed so that empty ranges end before they start) at depth,
+     *  keeping the k closest in search.best
+     */
+    void searchSubtree(int64_t start, int64_t end, uint32_t depth,
+                       Search& search) const {
+        if (start > end) return;
+        unsigned int numDim = header.numDim;
+        const double* q = search.q;
+        vector<pair<double, uint64_t>>& best = search.best;
+        int64_t medi = start + (end - start) / 2;
+        const double* p = pointAt(medi, search.scratch.data());
+        double dist = 0;
+        for (unsigned int d = 0; d < numDim; d++) {
+            dist += (p[d] - q[d]) * (p[d] - q[d]);
+        }
+        if (search.mayKeep(dist)) {
+            if (best.size() == search.k) {
+                pop_heap(best.begin(), best.end());
+                best.pop_back();
+            }
+            best.emplace_back(dist, medi);
+            push_heap(best.begin(), best.end());
+        }
+        unsigned int dim = depth % numDim;
+        double diff = q[dim] - p[dim];
+        // the query's side first, the other side if it may hold a closer
+        // point
+        if (diff < 0) {
+            searchSubtree(start, medi - 1, depth + 1, search);
+            if (search.mayKeep(diff * diff)) {
+                searchSubtree(medi + 1, end, depth + 1, search);
+            }
+        } else {
+            searchSubtree(medi + 1, end, depth + 1, search);
+            if (search.mayKeep(diff * diff)) {
+                searchSubtree(start, medi - 1, depth + 1, search);
+            }
+        }
+    }
+
+    /** Collect the points of the implicit subtree [start, end] at depth
+     *  that lie in queryRegion
+     */
+    void rangeSubtree(int64_t start, int64_t end, uint32_t depth,
+                      const vector<pair<double, double>>& queryRegion,
+                      double* scratch, vector<Point>& result) const {
+        if (start > end) return;
+        unsigned int numDim = header.numDim;
+        int64_t medi = start + (end - start) / 2;
+        const double* p = pointAt(medi, scratch);
+        bool inside = true;
+        for (unsigned int d = 0; inside && d < numDim; d++) {
+            inside = p[d] >= queryRegion[d].first &&
+                     p[d] <= queryRegion[d].second;
+        }
+        if (inside) result.emplace_back(vector<double>(p, p + numDim));
+        // scratch is reused below, so decide on both sides now
+        unsigned int dim = depth % numDim;
+        bool left = queryRegion[dim].first <= p[dim];
+        bool right = queryRegion[dim].second >= p[dim];
+        if (left) {
+            rangeSubtree(start, medi - 1, depth + 1, queryRegion, scratch,
+                         result);
+        }
+        if (right) {
+            rangeSubtree(medi + 1, end, depth + 1, queryRegion, scratch,
+                         result);
+        }
+    }
+};
+
+#endif /* DiskKDT_hpp */
@@ -2,15 +2,13 @@
 #define KDT_HPP
 
 #include <math.h>     // pow, abs
-#include <algorithm>  // sort, max, min
+#include <algorithm>  // sort, max, min, push_heap, pop_heap, sort_heap
 #include <limits>     // numeric_limits<type>::max()
 #include <vector>     // vector<typename>
 #include "Point.hpp"
 
 using namespace std;
 
-const double SQ = 2;
-
 class KDT {
   private:
     /** Inner class which defines a KD tree node */
@@ -23,36 +21,74 @@ class KDT {
         KDNode(Point point) : point(point) {}
     };
 
+    /** State of a single k nearest neighbor search. Kept outside of the
+     *  tree so that searches on a built tree can run concurrently.
+     */
+    struct KNNSearch {
+        const Point& queryPoint;
+        unsigned int k;
+        // max-heap of the k closest (squared distance, node) found so far
+        vector<pair<double, KDNode*>> best;
+        // number of nodes visited by this search
+        unsigned long long visited;
+
+        KNNSearch(const Point& queryPoint, unsigned int k)
+            : queryPoint(queryPoint), k(k), visited(0) {}
+
+        /** Squared distance a point must beat to enter the result */
+        double threshold() const {
+            if (best.size() < k) return numeric_limits<double>::max();
+            return best.front().first;
+        }
+
+        /** Keep node if it is closer than the current k-th neighbor */
+        void offer(double dist, KDNode* node) {
+            if (dist >= threshold()) return;
+            if (best.size() == k) {
+                pop_heap(best.begin(), best.end());
+                best.pop_back();
+            }
+            best.emplace_back(dist, node);
+            push_heap(best.begin(), best.end());
+        }
+    };
+
     // root of KD tree
     KDNode* root;
 
     // number of dimension of data points
     unsigned int numDim;
 
-    // smallest squared distance to query point so far
-    double threshold;
-
     unsigned int isize;
     int iheight;
 
+    // true if the bounding box of every subtree is kept and backtracking
+    // prunes with the point-to-box distance
+    bool boxPruning;
+
+    // in box pruning mode, the smallest box containing every point of the
+    // subtree of each node, numDim [min, max] pairs per node; the node
+    // built from points[i] has the boxes from i * numDim. Empty otherwise.
+    vector<pair<double, double>> nodeBoxes;
+
     // current nearest neighbor
     Point nearestNeighbor;
 
     // Extra Credit: smallest bounding box containing all points
     vector<pair<double, double>> boundingBox;
 
-    // Extra Credit: result container
-    // (Set during searching, and clear before another search)
-    vector<Point> pointsInRange;
-
   public:
-    /** Constructor of KD tree */
-    KDT()
+    /** Constructor of KD tree
+     *  boxPruning: store the bounding box of every subtree and prune
+     *              the nearest neighbor search with the distance to it
+     *              instead of the distance to the splitting plane only
+     */
+    KDT(bool boxPruning = false)
         : root(0),
           numDim(0),
-          threshold(numeric_limits<double>::max()),
           isize(0),
-          iheight(-1) {}
+          iheight(-1),
+          boxPruning(boxPruning) {}
 
     /** Destructor of KD tree */
     virtual ~KDT() {
@@ -71,30 +107,79 @@ class KDT {
         if (points.empty()) return;
         // initial call when building a kd tree
         numDim = points.begin()->numDim;
+        // smallest bounding box containing all points
+        boundingBox.assign(numDim, make_pair(numeric_limits<double>::max(),
+                                             -numeric_limits<double>::max()));
+        for (Point& p : points) extend_box(boundingBox, p);
+        if (boxPruning) {
+            nodeBoxes.assign(points.size() * numDim, pair<double, double>());
+        }
         // Builds subtree using the points
         root = buildSubtree(points, 0, points.size() - 1, 0, -1);
         iheight = floor(log2(points.size()));
     }
 
-    /** TODO
-     *  Return nullptr if the KD tree is empty
+    /** Return nullptr if the KD tree is empty
      *  Find the nearest neighbor. Recursively
      *  From the root, look up for the queryPoint first, to the leaf node
      *  Traverse down, use recursion
      *  Update the thredhold,
+     *  The returned point is owned by the tree and overwritten by the next
+     *  call, use findKNearestNeighbors() to search from several threads.
+     *  If visited is not null, the number of nodes visited is added to it.
      */
-    Point* findNearestNeighbor(Point& queryPoint) {
+    Point* findNearestNeighbor(Point& queryPoint,
+                               unsigned long long* visited = nullptr) {
         // Return nullptr if the tree is empty
         if (!root) return nullptr;
-        numDim = queryPoint.numDim;
-        findNNHelper(root, queryPoint, 0);
-        threshold = numeric_limits<double>::max();
+        nearestNeighbor = findKNearestNeighbors(queryPoint, 1, visited)[0];
         return &nearestNeighbor;
     }
 
-    /** Extra credit */
-    vector<Point> rangeSearch(vector<pair<double, double>>& queryRegion) {
-        return {};
+    /** Return the point of the tree closest to queryPoint, or nullptr if
+     *  the KD tree is empty. The point is owned by the tree and its
+     *  distToQuery is not set. Safe to call concurrently on a built tree.
+     *  If visited is not null, the number of nodes visited is added to it.
+     */
+    const Point* findNearestPoint(const Point& queryPoint,
+                                  unsigned long long* visited = nullptr) const {
+        if (!root) return nullptr;
+        KNNSearch search(queryPoint, 1);
+        findNNHelper(root, search, 0, 0, isize - 1);
+        if (visited != nullptr) *visited += search.visited;
+        return &search.best.front().second->point;
+    }
+
+    /** Return the k points closest to queryPoint, nearest first, with
+     *  distToQuery set. Safe to call concurrently on a built tree.
+     *  If visited is not null, the number of nodes visited is added to it.
+     */
+    vector<Point> findKNearestNeighbors(
+        const Point& queryPoint, unsigned int k,
+        unsigned long long* visited = nullptr) const {
+        vector<Point> result;
+        if (!root || k == 0) return result;
+        KNNSearch search(queryPoint, k);
+        findNNHelper(root, search, 0, 0, isize - 1);
+        if (visited != nullptr) *visited += search.visited;
+        sort_heap(search.best.begin(), search.best.end());
+        for (pair<double, KDNode*>& neighbor : search.best) {
+            result.push_back(neighbor.second->point);
+            result.back().distToQuery = neighbor.first;
+        }
+        return result;
+    }
+
+    /** Return all points inside queryRegion, one inclusive [min, max] pair
+     *  per dimension. Safe to call concurrently on a built tree.
+     */
+    vector<Point> rangeSearch(
+        const vector<pair<double, double>>& queryRegion) const {
+        vector<Point> result;
+        if (!root) return result;
+        vector<pair<double, double>> curBB = boundingBox;
+        rangeSearchHelper(root, curBB, queryRegion, 0, result);
+        return result;
     }
 
     /** Return the size of the KD tree */
@@ -103,6 +188,20 @@ class KDT {
     /** Return the height of the KD tree */
     int height() const { return iheight; }
 
+    /** Return the number of dimensions of the points in the KD tree */
+    unsigned int dimension() const { return numDim; }
+
+    /** Return the smallest bounding box containing all points */
+    vector<pair<double, double>> getBoundingBox() const { return boundingBox; }
+
+    /** Return the number of bytes allocated for the per-node bounding
+     *  boxes, 0 unless in box pruning mode
+     */
+    unsigned long long boundingBoxBytes() const {
+        return (unsigned long long)nodeBoxes.capacity() *
+               sizeof(pair<double, double>);
+    }
+
     /** In order traverse the KD tree */
     vector<Point> inorder() {
         vector<Point> vec(0);
@@ -142,51 +241,103 @@ class KDT {
             }
             node->right = buildSubtree(points, medi + 1, end,
                                        (curDim + 1) % numDim, height + 1);
+            // The box of a subtree is the union of its children's boxes
+            // and the node's own point
+            if (boxPruning) {
+                pair<double, double>* box = &nodeBoxes[medi * numDim];
+                for (unsigned int i = 0; i < numDim; i++) {
+                    box[i] = make_pair(points[medi].features[i],
+                                       points[medi].features[i]);
+                }
+                if (node->left) merge_box(box, (start + medi - 1) / 2);
+                if (node->right) merge_box(box, (medi + 1 + end) / 2);
+            }
             return node;
         } else {
             return nullptr;
         }
     }
 
-    /** Find the nearest node by updating the threshold */
-    void findNNHelper(KDNode* node, Point& queryPoint, unsigned int curDim) {
+    /** Find the nearest nodes by updating the threshold of search. node
+     *  was built from points [start, end], like in buildSubtree().
+     */
+    void findNNHelper(KDNode* node, KNNSearch& search, unsigned int curDim,
+                      unsigned int start, unsigned int end) const {
+        search.visited++;
+        const Point& queryPoint = search.queryPoint;
         // Leaf node
         if (node->left == nullptr && node->right == nullptr) {
             // Update the threshold if it's smaller
-            update_threshold(node, queryPoint);
-        } else if (node->left != nullptr &&
-                   queryPoint.features[curDim] < node->point.features[curDim]) {
-            // Go left
-            findNNHelper(node->left, queryPoint, (curDim + 1) % numDim);
-            // Distance for current dimension
-            double dist_dim_r = curr_dim_dis(node, queryPoint, curDim);
-            // Go right
-            if (node->right != nullptr && dist_dim_r <= threshold) {
-                // Go to the right subtree
-                findNNHelper(node->right, queryPoint, (curDim + 1) % numDim);
-            }
-            // If the node has a smaller threshold, update
-            update_threshold(node, queryPoint);
-        } else if (node->right != nullptr) {
-            // Go right
-            findNNHelper(node->right, queryPoint, (curDim + 1) % numDim);
-            // Distance for current dimension
-            double dist_dim_l = curr_dim_dis(node, queryPoint, curDim);
-            // Go left
-            if (node->left != nullptr && dist_dim_l <= threshold) {
-                // Go to the left subtree
-                findNNHelper(node->left, queryPoint, (curDim + 1) % numDim);
-            }
-            //  If the node has a better smaller threshold, update
-            update_threshold(node, queryPoint);
+            update_threshold(node, search);
+            return;
         }
+        // The subtree on the query point's side is searched first
+        unsigned int medi = (start + end) / 2;
+        KDNode* near = node->right;
+        unsigned int nearStart = medi + 1;
+        unsigned int nearEnd = end;
+        KDNode* far = node->left;
+        unsigned int farStart = start;
+        unsigned int farEnd = medi - 1;
+        if (node->left != nullptr &&
+            queryPoint.features[curDim] < node->point.features[curDim]) {
+            swap(near, far);
+            swap(nearStart, farStart);
+            swap(nearEnd, farEnd);
+        }
+        unsigned int nextDim = (curDim + 1) % numDim;
+        if (near != nullptr) {
+            findNNHelper(near, search, nextDim, nearStart, nearEnd);
+        }
+        // Go to the other subtree only if it may hold a closer point
+        if (far != nullptr &&
+            prune_dis(node, (farStart + farEnd) / 2, queryPoint, curDim) <=
+                search.threshold()) {
+            findNNHelper(far, search, nextDim, farStart, farEnd);
+        }
+        // If the node has a smaller threshold, update
+        update_threshold(node, search);
     }
 
-    /** Extra credit */
+    /** Collect the points of the subtree at node that lie in queryRegion.
+     *  curBB is the cell of node: the box its splitting planes carve out
+     *  of the bounding box of all points.
+     */
     void rangeSearchHelper(KDNode* node, vector<pair<double, double>>& curBB,
-                           vector<pair<double, double>>& queryRegion,
-                           unsigned int curDim) {
-        return;
+                           const vector<pair<double, double>>& queryRegion,
+                           unsigned int curDim, vector<Point>& result) const {
+        if (node == nullptr) return;
+        bool inside = true;
+        for (unsigned int i = 0; i < numDim; i++) {
+            // The cell does not overlap the region
+            if (curBB[i].second < queryRegion[i].first ||
+                curBB[i].first > queryRegion[i].second) {
+                return;
+            }
+            if (curBB[i].first < queryRegion[i].first ||
+                curBB[i].second > queryRegion[i].second) {
+                inside = false;
+            }
+        }
+        // The cell lies in the region, so does the whole subtree
+        if (inside) {
+            inorder_helper(node, result);
+            return;
+        }
+        if (is_contained(node->point, queryRegion)) {
+            result.push_back(node->point);
+        }
+        // Points equal to the split value may be on both sides
+        double split = node->point.features[curDim];
+        unsigned int nextDim = (curDim + 1) % numDim;
+        double bound = curBB[curDim].second;
+        curBB[curDim].second = split;
+        rangeSearchHelper(node->left, curBB, queryRegion, nextDim, result);
+        curBB[curDim].second = bound;
+        bound = curBB[curDim].first;
+        curBB[curDim].first = split;
+        rangeSearchHelper(node->right, curBB, queryRegion, nextDim, result);
+        curBB[curDim].first = bound;
     }
 
     /** Helper method of destructor, recursively delete the tree */
@@ -200,22 +351,74 @@ class KDT {
 
     // Add your own helper methods here
     /** Calculate the square euclidean distance of two points */
-    double curr_dim_dis(KDNode* n, Point& p, int dim) {
-        return pow(fabs(n->point.features[dim] - p.features[dim]), SQ);
+    double curr_dim_dis(KDNode* n, const Point& p, int dim) const {
+        double diff = n->point.features[dim] - p.features[dim];
+        return diff * diff;
+    }
+
+    /** Lower bound of the square distance from p to any point in the child
+     *  subtree of n built from points[child]: distance to the child's
+     *  bounding box in box pruning mode, otherwise distance to the
+     *  splitting plane of n
+     */
+    double prune_dis(KDNode* n, unsigned int child, const Point& p,
+                     int dim) const {
+        if (!boxPruning) return curr_dim_dis(n, p, dim);
+        const pair<double, double>* box = &nodeBoxes[child * numDim];
+        double dist = 0;
+        for (unsigned int i = 0; i < numDim; i++) {
+            double x = p.features[i];
+            const pair<double, double>& range = box[i];
+            if (x < range.first) {
+                dist += (range.first - x) * (range.first - x);
+            } else if (x > range.second) {
+                dist += (x - range.second) * (x - range.second);
+            }
+        }
+        return dist;
+    }
+
+    /** Grow box so that it contains p */
+    static void extend_box(vector<pair<double, double>>& box, Point& p) {
+        for (unsigned int i = 0; i < box.size(); i++) {
+            box[i].first = min(box[i].first, p.features[i]);
+            box[i].second = max(box[i].second, p.features[i]);
+        }
+    }
+
+    /** Grow box so that it contains the bounding box of the node built
+     *  from points[child]
+     */
+    void merge_box(pair<double, double>* box, unsigned int child) {
+        const pair<double, double>* childBox = &nodeBoxes[child * numDim];
+        for (unsigned int i = 0; i < numDim; i++) {
+            box[i].first = min(box[i].first, childBox[i].first);
+            box[i].second = max(box[i].second, childBox[i].second);
+        }
     }
 
     /** Update the threshold */
-    void update_threshold(KDNode* node, Point& queryPoint) {
+    void update_threshold(KDNode* node, KNNSearch& search) const {
         double dist = 0;
-        vector<double> v1 = node->point.features;
-        vector<double> v2 = queryPoint.features;
-        for (unsigned int i = 0; i < numDim; i++)
-            dist += pow(fabs(v1[i] - v2[i]), SQ);
-        if (dist < threshold) {
-            threshold = dist;
-            node->point.distToQuery = dist;
-            nearestNeighbor = node->point;
+        const vector<double>& v1 = node->point.features;
+        const vector<double>& v2 = search.queryPoint.features;
+        for (unsigned int i = 0; i < numDim; i++) {
+            double diff = v1[i] - v2[i];
+            dist += diff * diff;
+        }
+        search.offer(dist, node);
+    }
+
+    /** Check if the given point is contained in queryRegion */
+    bool is_contained(const Point& p,
+                      const vector<pair<double, double>>& queryRegion) const {
+        for (unsigned int i = 0; i < numDim; i++) {
+            if (p.features[i] < queryRegion[i].first ||
+                p.features[i] > queryRegion[i].second) {
+                return false;
+            }
         }
+        return true;
     }
 
     /** Helper function for in order traverse*/
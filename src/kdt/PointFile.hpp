@@ -0,0 +1,282 @@
+/**
+ * Binary point file format, and writing and loading of point files in
+ * either the text or the binary format.
+ *
+ * A binary point file is a 32 byte header followed by a block of
+ * coordinates and an optional block of ids:
+ *
+ *   offset  size  field
+ *        0     8  magic "KDTPOINT"
+ *        8     4  version, currently 1
+ *       12     4  dtype of the coordinates: 1 = float64, 2 = float32
+ *       16     8  count, the number of points
+ *       24     4  numDim, the number of features of every point
+ *       28     4  flags: bit 0 set if the file has point ids
+ *       32        coordinates, count * numDim values of dtype, point after
+ *                 point
+ *         ...     ids, count uint64 values, if flag bit 0 is set
+ *
+ * All integers and floating point values are little-endian.
+ *
+ * The coordinates are stored point after point, not dimension by
+ * dimension: PointSet and the trees take them in that order, and
+ * QueryReader and DiskKDT read a file sequentially, from a pipe too, so
+ * every point must be whole once its bytes have arrived.
+ */
+
+#ifndef PointFile_hpp
+#define PointFile_hpp
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <vector>
+#include "PointReader.hpp"
+
+using namespace std;
+
+/** Type of the coordinates stored in a binary point file */
+enum PointDType : uint32_t { FLOAT64 = 1, FLOAT32 = 2 };
+
+const char POINT_FILE_MAGIC[8] = {'K', 'D', 'T', 'P', 'O', 'I', 'N', 'T'};
+const uint32_t POINT_FILE_VERSION = 1;
+const uint32_t POINT_FILE_HAS_IDS = 1;
+
+struct PointFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t dtype;
+    uint64_t count;
+    uint32_t numDim;
+    uint32_t flags;
+};
+
+static_assert(sizeof(PointFileHeader) == 32, "header must be packed");
+
+/** True if this machine stores numbers little-endian */
+inline bool hostIsLittleEndian() {
+    const uint32_t one = 1;
+    unsigned char first;
+    memcpy(&first, &one, 1);
+    return first == 1;
+}
+
+/** Reverse the bytes of each of the count values of size bytes at data,
+ *  converting between little-endian and the host order on big-endian hosts
+ */
+inline void swapToLittleEndian(void* data, size_t count, size_t size) {
+    if (hostIsLittleEndian()) return;
+    unsigned char* bytes = (unsigned char*)data;
+    for (size_t i = 0; i < count; i++) {
+        reverse(bytes + i * size, bytes + (i + 1) * size);
+    }
+}
+
+/** Read exactly len bytes from fd. Return false on error or end of file */
+inline bool readBlock(int fd, void* dst, size_t len) {
+    // large reads are split, some systems refuse reads above 2 GB
+    const size_t MAX_READ = 1 << 30;
+    char* out = (char*)dst;
+    while (len > 0) {
+        ssize_t got = read(fd, out, min(len, MAX_READ));
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return false;
+        out += got;
+        len -= got;
+    }
+    return true;
+}
+
+/** Return true if fileName starts with the binary point file magic */
+inline bool isBinaryPointFile(const char* fileName) {
+    char magic[sizeof(POINT_FILE_MAGIC)];
+    ifstream in(fileName, ios::binary);
+    in.read(magic, sizeof(magic));
+    return in.gcount() == sizeof(magic) &&
+           memcmp(magic, POINT_FILE_MAGIC, sizeof(magic)) == 0;
+}
+
+/** Write points to fileName in the binary format with coordinates of the
+ *  given dtype. Ids are written if points has one per point. Return false
+ *  if the file cannot be written.
+ */
+inline bool writeBinaryPoints(const char* fileName, const PointSet& points,
+                              PointDType dtype = FLOAT64) {
+    // values converted and written at a time
+    const size_t BLOCK = 1 << 20;
+
+    PointFileHeader header;
+    memcpy(header.magic, POINT_FILE_MAGIC, sizeof(header.magic));
+    header.version = POINT_FILE_VERSION;
+    header.dtype = dtype;
+    header.count = points.size();
+    header.numDim = points.numDim;
+    bool hasIds = !points.ids.empty() && points.ids.size() == points.size();
+    header.flags = hasIds ? POINT_FILE_HAS_IDS : 0;
+    swapToLittleEndian(&header.version, 2, sizeof(uint32_t));
+    swapToLittleEndian(&header.count, 1, sizeof(uint64_t));
+    swapToLittleEndian(&header.numDim, 2, sizeof(uint32_t));
+
+    ofstream out(fileName, ios::binary);
+    if (!out.is_open()) return false;
+    out.write((const char*)&header, sizeof(header));
+
+    size_t numValues = header.count * points.numDim;
+    if (dtype == FLOAT64 && hostIsLittleEndian()) {
+        out.write((const char*)points.coords.data(),
+                  numValues * sizeof(double));
+    } else if (dtype == FLOAT64) {
+        vector<double> block;
+        for (size_t i = 0; i < numValues; i += BLOCK) {
+            block.assign(points.coords.begin() + i,
+                         points.coords.begin() + min(numValues, i + BLOCK));
+            swapToLittleEndian(block.data(), block.size(), sizeof(double));
+            out.write((const char*)block.data(),
+                      block.size() * sizeof(double));
+        }
+    } else {
+        vector<float> block;
+        for (size_t i = 0; i < numValues; i += BLOCK) {
+            block.assign(points.coords.begin() + i,
+                         points.coords.begin() + min(numValues, i + BLOCK));
+            swapToLittleEndian(block.data(), block.size(), sizeof(float));
+            out.write((const char*)block.data(), block.size() * sizeof(float));
+        }
+    }
+    if (hasIds) {
+        vector<uint64_t> ids = points.ids;
+        swapToLittleEndian(ids.data(), ids.size(), sizeof(uint64_t));
+        out.write((const char*)ids.data(), ids.size() * sizeof(uint64_t));
+    }
+    return out.good();
+}
+
+/** Write points to fileName in the text format. Return false on failure */
+inline bool writeTextPoints(const char* fileName, const PointSet& points) {
+    FILE* out = fopen(fileName, "w");
+    if (out == nullptr) return false;
+    char buf[32];
+    for (size_t i = 0; i < points.size(); i++) {
+        for (unsigned int d = 0; d < points.numDim; d++) {
+            // 17 significant digits read back as the same double
+            int len = snprintf(buf, sizeof(buf), "%.17g", points.valueAt(i, d));
+            buf[len++] = d + 1 == points.numDim ? '\n' : ' ';
+            fwrite(buf, 1, len, out);
+        }
+    }
+    return fclose(out) == 0;
+}
+
+/** Load the binary point file fileName into points. Return false if the
+ *  file cannot be read or is not a valid binary point file.
+ */
+inline bool readBinaryPoints(const char* fileName, PointSet& points) {
+    // values read and converted at a time for float32 files
+    const size_t BLOCK = 1 << 20;
+
+    points.numDim = 0;
+    points.coords.clear();
+    points.ids.clear();
+    int fd = open(fileName, O_RDONLY);
+    if (fd < 0) return false;
+    PointFileHeader header;
+    bool ok = readBlock(fd, &header, sizeof(header)) &&
+              memcmp(header.magic, POINT_FILE_MAGIC, sizeof(header.magic)) ==
+                  0;
+    swapToLittleEndian(&header.version, 2, sizeof(uint32_t));
+    swapToLittleEndian(&header.count, 1, sizeof(uint64_t));
+    swapToLittleEndian(&header.numDim, 2, sizeof(uint32_t));
+    ok = ok && header.version == POINT_FILE_VERSION &&
+         (header.dtype == FLOAT64 || header.dtype == FLOAT32) &&
+         (header.numDim > 0 || header.count == 0);
+    // refuse sizes that would not fit in memory rather than overflow, and
+    // headers promising more values than the file holds
+    ok = ok && (header.numDim == 0 ||
+                header.count <= SIZE_MAX / sizeof(double) / header.numDim);
+    struct stat info;
+    ok = ok && fstat(fd, &info) == 0 &&
+         header.count * header.numDim *
+                 (header.dtype == FLOAT64 ? sizeof(double) : sizeof(float)) <=
+             (uint64_t)info.st_size - sizeof(header);
+    if (!ok) {
+        close(fd);
+        return false;
+    }
+
+    size_t numValues = header.count * header.numDim;
+    points.numDim = header.numDim;
+    points.coords.resize(numValues);
+    if (header.dtype == FLOAT64) {
+        ok = readBlock(fd, points.coords.data(), numValues * sizeof(double));
+        swapToLittleEndian(points.coords.data(), numValues, sizeof(double));
+    } else {
+        vector<float> block;
+        for (size_t i = 0; ok && i < numValues; i += BLOCK) {
+            block.resize(min(BLOCK, numValues - i));
+            ok = readBlock(fd, block.data(), block.size() * sizeof(float));
+            swapToLittleEndian(block.data(), block.size(), sizeof(float));
+            copy(block.begin(), block.end(), points.coords.begin() + i);
+        }
+    }
+    if (ok && (header.flags & POINT_FILE_HAS_IDS)) {
+        points.ids.resize(header.count);
+        ok = readBlock(fd, points.ids.data(),
+                       header.count * sizeof(uint64_t));
+        swapToLittleEndian(points.ids.data(), header.count, sizeof(uint64_t));
+    }
+    close(fd);
+    if (!ok) {
+        points.numDim = 0;
+        points.coords.clear();
+        points.ids.clear();
+    }
+    return ok;
+}
+
+/** Return the number of features of the points in fileName, in the binary
+ *  or the text format, without reading the whole file. Return 0 if the
+ *  file cannot be read.
+ */
+inline unsigned int pointFileDimension(const char* fileName) {
+    // longest first line of a text file looked at
+    const size_t MAX_LINE = 1 << 16;
+    vector<char> start(MAX_LINE);
+    ifstream in(fileName, ios::binary);
+    in.read(start.data(), start.size());
+    size_t len = in.gcount();
+    if (len >= sizeof(PointFileHeader) &&
+        memcmp(start.data(), POINT_FILE_MAGIC, sizeof(POINT_FILE_MAGIC)) ==
+            0) {
+        PointFileHeader header;
+        memcpy(&header, start.data(), sizeof(header));
+        swapToLittleEndian(&header.numDim, 1, sizeof(uint32_t));
+        return header.numDim;
+    }
+    return countDimensions(start.data(), start.data() + len);
+}
+
+/** Load the points of fileName, in the binary or the text format. Return
+ *  false if the file cannot be read.
+ */
+inline bool loadPoints(const char* fileName, PointSet& points) {
+    if (isBinaryPointFile(fileName)) return readBinaryPoints(fileName, points);
+    return loadPointSet(fileName, points);
+}
+
+/** Load the points of fileName, in the binary or the text format, as
+ *  Point objects. Return false if the file cannot be read.
+ */
+inline bool loadPoints(const char* fileName, vector<Point>& points) {
+    PointSet pointSet;
+    if (!loadPoints(fileName, pointSet)) return false;
+    points = pointSet.toPoints();
+    return true;
+}
+
+#endif /* PointFile_hpp */
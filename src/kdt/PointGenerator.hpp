@@ -0,0 +1,270 @@
+/**
+ * Seedable generator of synthetic point sets, for benchmarks and stress
+ * tests. Besides uniform points it makes the distributions that uniform
+ * data hides:
+ *   uniform     every coordinate uniform in [min, max]
+ *   clustered   tight gaussian clusters around uniform centers
+ *   duplicates  uniform points, each repeated many times
+ *   line        points on a line along dimension 0, every other
+ *               coordinate the same for all points
+ *   grid        a regular grid filled row by row, in the order of
+ *               data/largeQuery.txt
+ *   outliers    uniform points, and a few far outside [min, max]
+ *
+ * The same workload and seed give the same points with every standard
+ * library: the random numbers come from mt19937_64 through conversions
+ * written here, not from the standard distributions, whose output is left
+ * to the library. Across platforms this holds for the distributions made
+ * of uniform numbers. The gaussian clusters also go through log and cos,
+ * which are not correctly rounded in every libm, so their coordinates may
+ * differ in the last bits.
+ */
+
+#ifndef PointGenerator_hpp
+#define PointGenerator_hpp
+
+#include <math.h>
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include "PointReader.hpp"
+
+using namespace std;
+
+/** Shape of a generated point set */
+enum PointDistribution { UNIFORM, CLUSTERED, DUPLICATES, LINE, GRID, OUTLIERS };
+
+/** Every distribution, in the order of PointDistribution */
+const PointDistribution POINT_DISTRIBUTIONS[] = {
+    UNIFORM, CLUSTERED, DUPLICATES, LINE, GRID, OUTLIERS};
+
+/** Return the name of distribution, as accepted by parseDistribution() */
+inline const char* distributionName(PointDistribution distribution) {
+    static const char* const NAMES[] = {"uniform", "clustered", "duplicates",
+                                        "line",    "grid",      "outliers"};
+    return NAMES[distribution];
+}
+
+/** Set distribution from its name. Return false if there is none */
+inline bool parseDistribution(const string& name,
+                              PointDistribution& distribution) {
+    for (PointDistribution d : POINT_DISTRIBUTIONS) {
+        if (name == distributionName(d)) {
+            distribution = d;
+            return true;
+        }
+    }
+    return false;
+}
+
+/** What to generate. The fields after seed tune single distributions and
+ *  have defaults that make them hard cases.
+ */
+struct PointWorkload {
+    PointDistribution distribution;
+    size_t count;
+    unsigned int numDim;
+    uint64_t seed;
+
+    // range of the coordinates, outliers excepted
+    double min;
+    double max;
+
+    // clustered: number of clusters, and standard deviation of a cluster
+    // as a fraction of max - min
+    unsigned int numClusters;
+    double spread;
+
+    // duplicates: fraction of the points that repeat another point
+    double duplicateRate;
+
+    // outliers: fraction of the points that are outliers, and how many
+    // times max - min they may lie from the middle
+    double outlierRate;
+    double outlierScale;
+
+    PointWorkload(PointDistribution distribution, size_t count,
+                  unsigned int numDim, uint64_t seed = 42)
+        : distribution(distribution),
+          count(count),
+          numDim(numDim),
+          seed(seed),
+          min(-100),
+          max(100),
+          numClusters(8),
+          spread(0.002),
+          duplicateRate(0.9),
+          outlierRate(0.01),
+          outlierScale(1000) {}
+};
+
+class PointGenerator {
+  private:
+    PointWorkload workload;
+    mt19937_64 random;
+
+  public:
+    explicit PointGenerator(const PointWorkload& workload)
+        : workload(workload), random(workload.seed) {}
+
+    /** Return the points of the workload */
+    PointSet generate() {
+        PointSet points;
+        points.numDim = workload.numDim;
+        if (workload.numDim == 0 || workload.count == 0) return points;
+        points.coords.reserve(workload.count * workload.numDim);
+        switch (workload.distribution) {
+            case UNIFORM:
+                for (size_t i = 0; i < workload.count; i++) addUniform(points);
+                break;
+            case CLUSTERED:
+                addClustered(points);
+                break;
+            case DUPLICATES:
+                addDuplicates(points);
+                break;
+            case LINE:
+                addLine(points);
+                break;
+            case GRID:
+                addGrid(points);
+                break;
+            case OUTLIERS:
+                addOutliers(points);
+                break;
+        }
+        return points;
+    }
+
+  private:
+    /** Return a number uniform in [0, 1) */
+    double unit() { return (random() >> 11) * (1.0 / (1ull << 53)); }
+
+    /** Return a number uniform in [lo, hi) */
+    double between(double lo, double hi) { return lo + (hi - lo) * unit(); }
+
+    /** Return a number uniform in [0, n) */
+    size_t below(size_t n) { return (size_t)(unit() * n); }
+
+    /** Return a standard normal number, by the Box-Muller transform */
+    double gaussian() {
+        const double TWO_PI = 6.283185307179586;
+        double u = 1 - unit();
+        return sqrt(-2 * log(u)) * cos(TWO_PI * unit());
+    }
+
+    /** Add a point uniform in the range */
+    void addUniform(PointSet& points) {
+        for (unsigned int d = 0; d < workload.numDim; d++) {
+            points.coords.push_back(between(workload.min, workload.max));
+        }
+    }
+
+    /** Add points around centers uniform in the range, picking a center
+     *  for every point
+     */
+    void addClustered(PointSet& points) {
+        unsigned int numClusters = std::max(1u, workload.numClusters);
+        PointSet centers;
+        for (unsigned int c = 0; c < numClusters; c++) addUniform(centers);
+        double sigma = workload.spread * (workload.max - workload.min);
+        for (size_t i = 0; i < workload.count; i++) {
+            size_t c = below(numClusters);
+            for (unsigned int d = 0; d < workload.numDim; d++) {
+                points.coords.push_back(
+                    centers.coords[c * workload.numDim + d] +
+                    sigma * gaussian());
+            }
+        }
+    }
+
+    /** Add distinct uniform points, then copies of random ones among them,
+     *  and shuffle
+     */
+    void addDuplicates(PointSet& points) {
+        size_t distinct = (size_t)(workload.count *
+                                       (1 - workload.duplicateRate) +
+                                   0.5);
+        distinct = std::max<size_t>(1, std::min(distinct, workload.count));
+        for (size_t i = 0; i < distinct; i++) addUniform(points);
+        for (size_t i = distinct; i < workload.count; i++) {
+            size_t copy = below(distinct) * workload.numDim;
+            for (unsigned int d = 0; d < workload.numDim; d++) {
+                points.coords.push_back(points.coords[copy + d]);
+            }
+        }
+        shufflePoints(points);
+    }
+
+    /** Add points that differ only in dimension 0 */
+    void addLine(PointSet& points) {
+        vector<double> fixed;
+        for (unsigned int d = 0; d < workload.numDim; d++) {
+            fixed.push_back(between(workload.min, workload.max));
+        }
+        for (size_t i = 0; i < workload.count; i++) {
+            points.coords.push_back(between(workload.min, workload.max));
+            points.coords.insert(points.coords.end(), fixed.begin() + 1,
+                                 fixed.end());
+        }
+    }
+
+    /** Add the first count points of the smallest grid with at least count
+     *  points, the last dimension changing fastest
+     */
+    void addGrid(PointSet& points) {
+        size_t side = 1;
+        while (pow((double)side, workload.numDim) < workload.count) side++;
+        double step = (workload.max - workload.min) / side;
+        vector<size_t> cell(workload.numDim, 0);
+        for (size_t i = 0; i < workload.count; i++) {
+            for (unsigned int d = 0; d < workload.numDim; d++) {
+                points.coords.push_back(workload.min + step * cell[d]);
+            }
+            for (unsigned int d = workload.numDim; d-- > 0;) {
+                if (++cell[d] < side) break;
+                cell[d] = 0;
+            }
+        }
+    }
+
+    /** Add uniform points, each an outlier uniform in outlierScale times
+     *  the range with probability outlierRate
+     */
+    void addOutliers(PointSet& points) {
+        double middle = (workload.min + workload.max) / 2;
+        double reach =
+            workload.outlierScale * (workload.max - workload.min) / 2;
+        for (size_t i = 0; i < workload.count; i++) {
+            if (unit() >= workload.outlierRate) {
+                addUniform(points);
+                continue;
+            }
+            for (unsigned int d = 0; d < workload.numDim; d++) {
+                points.coords.push_back(between(middle - reach,
+                                                middle + reach));
+            }
+        }
+    }
+
+    /** Put the points in random order */
+    void shufflePoints(PointSet& points) {
+        unsigned int numDim = workload.numDim;
+        for (size_t i = points.size(); i > 1; i--) {
+            size_t j = below(i);
+            swap_ranges(points.coords.begin() + (i - 1) * numDim,
+                        points.coords.begin() + i * numDim,
+                        points.coords.begin() + j * numDim);
+        }
+    }
+};
+
+/** Return the points of workload */
+inline PointSet generatePoints(const PointWorkload& workload) {
+    return PointGenerator(workload).generate();
+}
+
+#endif /* PointGenerator_hpp */
@@ -0,0 +1,274 @@
+/**
+ * Fast loader for text point files: one point per line, features separated
+ * by whitespace. The file is memory-mapped, cut into chunks on line
+ * boundaries and the chunks are parsed in parallel straight into one flat
+ * coordinate buffer.
+ *
+ * As with reading the file through an ifstream, the number of dimensions
+ * is the number of values on the first line, the values are then taken in
+ * order numDim at a time and an incomplete last point is dropped. Reading
+ * stops at the first value that is not a number.
+ */
+
+#ifndef PointReader_hpp
+#define PointReader_hpp
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Point.hpp"
+
+using namespace std;
+
+/** Points stored row by row in one flat buffer */
+struct PointSet {
+    // number of features of every point
+    unsigned int numDim;
+    // numDim values per point, point after point
+    vector<double> coords;
+    // id of every point, empty if the points have none
+    vector<uint64_t> ids;
+
+    PointSet() : numDim(0) {}
+
+    /** Return the number of points */
+    size_t size() const { return numDim == 0 ? 0 : coords.size() / numDim; }
+
+    /** Return the value at dimension d of point i */
+    double valueAt(size_t i, unsigned int d) const {
+        return coords[i * numDim + d];
+    }
+
+    /** Copy the points out into Point objects */
+    vector<Point> toPoints() const {
+        vector<Point> result;
+        result.reserve(size());
+        for (size_t i = 0; i < size(); i++) {
+            const double* first = coords.data() + i * numDim;
+            result.emplace_back(vector<double>(first, first + numDim));
+        }
+        return result;
+    }
+};
+
+/** Whitespace separating the values of a point file */
+inline bool isPointSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' ||
+           c == '\f';
+}
+
+/** Parse the decimal number at the start of [first, last) into value, in
+ *  the manner of std::from_chars. Return the end of the number, or first
+ *  if there is no number. Values with at most 15 significant digits and a
+ *  small exponent, which covers our data files, are computed exactly with
+ *  a single multiplication or division, anything else goes to strtod.
+ */
+inline const char* parseDouble(const char* first, const char* last,
+                               double& value) {
+    static const double POW10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                                   1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                   1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                                   1e18, 1e19, 1e20, 1e21, 1e22};
+    const int MAX_DIGITS = 19;      // digits that always fit in uint64_t
+    const uint64_t MAX_EXACT = 1ull << 53;  // integers exact in a double
+    const int MAX_EXACT_POW = 22;   // largest power of 10 exact in a double
+
+    const char* p = first;
+    bool negative = false;
+    if (p != last && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        p++;
+    }
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool anyDigit = false;
+    bool truncated = false;
+    while (p != last && *p >= '0' && *p <= '9') {
+        if (digits < MAX_DIGITS) {
+            mantissa = mantissa * 10 + (*p - '0');
+            if (mantissa != 0) digits++;
+        } else {
+            exponent++;
+            truncated = true;
+        }
+        anyDigit = true;
+        p++;
+    }
+    if (p != last && *p == '.') {
+        p++;
+        while (p != last && *p >= '0' && *p <= '9') {
+            if (digits < MAX_DIGITS) {
+                mantissa = mantissa * 10 + (*p - '0');
+                if (mantissa != 0) digits++;
+                exponent--;
+            } else {
+                truncated = true;
+            }
+            anyDigit = true;
+            p++;
+        }
+    }
+    if (!anyDigit) return first;
+    if (p != last && (*p == 'e' || *p == 'E')) {
+        const char* e = p + 1;
+        bool negativeExp = false;
+        if (e != last && (*e == '-' || *e == '+')) {
+            negativeExp = *e == '-';
+            e++;
+        }
+        if (e != last && *e >= '0' && *e <= '9') {
+            int exp = 0;
+            while (e != last && *e >= '0' && *e <= '9') {
+                if (exp < 100000) exp = exp * 10 + (*e - '0');
+                e++;
+            }
+            exponent += negativeExp ? -exp : exp;
+            p = e;
+        }
+    }
+    if (!truncated && mantissa <= MAX_EXACT && exponent >= -MAX_EXACT_POW &&
+        exponent <= MAX_EXACT_POW) {
+        value = (double)mantissa;
+        value = exponent < 0 ? value / POW10[-exponent]
+                             : value * POW10[exponent];
+        if (negative) value = -value;
+        return p;
+    }
+    // strtod needs a terminated string, the mapped file may not have one
+    string token(first, p);
+    value = strtod(token.c_str(), nullptr);
+    return p;
+}
+
+/** Return the number of values in [first, last) */
+inline size_t countValues(const char* first, const char* last) {
+    size_t count = 0;
+    bool inValue = false;
+    for (const char* p = first; p != last; p++) {
+        bool space = isPointSpace(*p);
+        if (!space && !inValue) count++;
+        inValue = !space;
+    }
+    return count;
+}
+
+/** Parse the values in [first, last) into out. Return the number of values
+ *  parsed, which is less than the number of values only if one of them is
+ *  not a number.
+ */
+inline size_t parseValues(const char* first, const char* last, double* out) {
+    size_t count = 0;
+    const char* p = first;
+    while (true) {
+        while (p != last && isPointSpace(*p)) p++;
+        if (p == last) return count;
+        const char* end = parseDouble(p, last, out[count]);
+        if (end == p || (end != last && !isPointSpace(*end))) return count;
+        count++;
+        p = end;
+    }
+}
+
+/** Return the number of dimensions of the first line of [first, last) */
+inline unsigned int countDimensions(const char* first, const char* last) {
+    const char* eol = find(first, last, '\n');
+    return countValues(first, eol);
+}
+
+/** Load the points of the text file fileName into points, parsing chunks
+ *  of the file on numThreads threads (0: one per core). An empty file
+ *  gives an empty set. Return false if the file cannot be opened or
+ *  mapped.
+ */
+inline bool loadPointSet(const char* fileName, PointSet& points,
+                         unsigned int numThreads = 0) {
+    // chunks smaller than this are not worth a thread
+    const size_t MIN_CHUNK_BYTES = 1 << 20;
+
+    points.numDim = 0;
+    points.coords.clear();
+    points.ids.clear();
+    int fd = open(fileName, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) < 0) {
+        close(fd);
+        return false;
+    }
+    // nothing to map, and no points, like an empty stream
+    if (info.st_size == 0) {
+        close(fd);
+        return true;
+    }
+    size_t length = info.st_size;
+    void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) return false;
+    madvise(mapped, length, MADV_SEQUENTIAL);
+    const char* data = (const char*)mapped;
+    const char* dataEnd = data + length;
+
+    points.numDim = countDimensions(data, dataEnd);
+    if (points.numDim == 0) {
+        munmap(mapped, length);
+        return true;
+    }
+
+    // cut the file into chunks that end right after a newline
+    if (numThreads == 0) numThreads = max(1u, thread::hardware_concurrency());
+    size_t numChunks = min<size_t>(numThreads, length / MIN_CHUNK_BYTES + 1);
+    vector<const char*> bounds(1, data);
+    for (size_t i = 1; i < numChunks; i++) {
+        const char* cut = data + length * i / numChunks;
+        cut = max(cut, bounds.back());
+        cut = find(cut, dataEnd, '\n');
+        if (cut != dataEnd) cut++;
+        bounds.push_back(cut);
+    }
+    bounds.push_back(dataEnd);
+
+    // count the values of every chunk to know where its values go, then
+    // parse all chunks straight into the coordinate buffer
+    vector<size_t> offsets(numChunks + 1, 0);
+    vector<size_t> parsed(numChunks, 0);
+    vector<thread> workers;
+    for (size_t i = 0; i < numChunks; i++) {
+        workers.emplace_back([&, i] {
+            offsets[i + 1] = countValues(bounds[i], bounds[i + 1]);
+        });
+    }
+    for (thread& worker : workers) worker.join();
+    workers.clear();
+    for (size_t i = 0; i < numChunks; i++) offsets[i + 1] += offsets[i];
+    points.coords.resize(offsets[numChunks]);
+    for (size_t i = 0; i < numChunks; i++) {
+        workers.emplace_back([&, i] {
+            parsed[i] = parseValues(bounds[i], bounds[i + 1],
+                                    points.coords.data() + offsets[i]);
+        });
+    }
+    for (thread& worker : workers) worker.join();
+    munmap(mapped, length);
+
+    // keep the values before the first one that is not a number, and only
+    // complete points
+    size_t numValues = offsets[numChunks];
+    for (size_t i = 0; i < numChunks; i++) {
+        if (offsets[i] + parsed[i] < offsets[i + 1]) {
+            numValues = offsets[i] + parsed[i];
+            break;
+        }
+    }
+    points.coords.resize(numValues - numValues % points.numDim);
+    return true;
+}
+
+#endif /* PointReader_hpp */
@@ -0,0 +1,263 @@
+/**
+ * Binary protocol spoken between the KD tree query server and its clients,
+ * plus the socket helpers both sides share.
+ *
+ * Every message is a fixed 16 byte header followed by doubles. Integers and
+ * doubles are sent in host byte order, which is little-endian on every
+ * machine we run on; server and client are expected to share a host.
+ *
+ * Request:  RequestHeader, then numDim doubles (NN, kNN) or numDim
+ *           [min, max] pairs of doubles (range).
+ * Response: ResponseHeader, then numPoints entries of (1 + numDim) doubles:
+ *           the squared distance to the query (0 for range), then the
+ *           coordinates of the point.
+ *
+ * Clients may send many requests without waiting for the responses. The
+ * responses carry the id of their request and may arrive out of order.
+ *
+ * Addresses are "unix:<socket path>" or "tcp:<port>". TCP servers only
+ * listen on the loopback interface.
+ */
+
+#ifndef QueryProtocol_hpp
+#define QueryProtocol_hpp
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "Point.hpp"
+
+using namespace std;
+
+/** Kinds of queries the server answers */
+enum QueryType : uint8_t { NN_QUERY = 1, KNN_QUERY = 2, RANGE_QUERY = 3 };
+
+/** Outcome of a query */
+enum QueryStatus : uint8_t { QUERY_OK = 0, QUERY_BAD_REQUEST = 1 };
+
+// largest number of dimensions a request may carry
+const uint32_t MAX_QUERY_DIM = 1 << 16;
+
+struct RequestHeader {
+    uint32_t id;
+    uint8_t type;
+    uint8_t reserved[3];
+    // number of neighbors of a kNN query, ignored otherwise
+    uint32_t k;
+    uint32_t numDim;
+};
+
+struct ResponseHeader {
+    uint32_t id;
+    uint8_t status;
+    uint8_t reserved[3];
+    uint32_t numPoints;
+    uint32_t numDim;
+};
+
+static_assert(sizeof(RequestHeader) == 16, "request header must be packed");
+static_assert(sizeof(ResponseHeader) == 16, "response header must be packed");
+
+struct QueryRequest {
+    RequestHeader header;
+    vector<double> values;
+
+    /** Number of doubles following a header of the given type */
+    static size_t numValues(const RequestHeader& header) {
+        if (header.type == RANGE_QUERY) return 2 * (size_t)header.numDim;
+        return header.numDim;
+    }
+};
+
+struct QueryResponse {
+    ResponseHeader header;
+    vector<double> values;
+};
+
+/** Buffered reader over a socket, so that small pipelined messages do not
+ *  cost one system call each
+ */
+class SocketReader {
+  private:
+    int fd;
+    vector<char> buffer;
+    size_t begin;
+    size_t end;
+
+  public:
+    SocketReader(int fd) : fd(fd), buffer(1 << 16), begin(0), end(0) {}
+
+    /** Read exactly len bytes. Return false on error or end of stream */
+    bool read(void* dst, size_t len) {
+        char* out = (char*)dst;
+        while (len > 0) {
+            if (begin == end) {
+                ssize_t got = ::read(fd, buffer.data(), buffer.size());
+                if (got < 0 && errno == EINTR) continue;
+                if (got <= 0) return false;
+                begin = 0;
+                end = got;
+            }
+            size_t chunk = min(len, end - begin);
+            memcpy(out, buffer.data() + begin, chunk);
+            begin += chunk;
+            out += chunk;
+            len -= chunk;
+        }
+        return true;
+    }
+};
+
+/** Write exactly len bytes. Return false on error */
+inline bool writeFully(int fd, const void* src, size_t len) {
+    const char* in = (const char*)src;
+    while (len > 0) {
+        ssize_t sent = send(fd, in, len, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) return false;
+        in += sent;
+        len -= sent;
+    }
+    return true;
+}
+
+/** Append raw bytes to buf */
+inline void appendBytes(vector<char>& buf, const void* src, size_t len) {
+    buf.insert(buf.end(), (const char*)src, (const char*)src + len);
+}
+
+/** Encode a request at the end of buf */
+inline void appendRequest(vector<char>& buf, const QueryRequest& request) {
+    appendBytes(buf, &request.header, sizeof(RequestHeader));
+    appendBytes(buf, request.values.data(),
+                request.values.size() * sizeof(double));
+}
+
+/** Encode the response to request id at the end of buf. Distances are
+ *  taken from distToQuery of the points.
+ */
+inline void appendResponse(vector<char>& buf, uint32_t id, QueryStatus status,
+                           uint32_t numDim, const vector<Point>& points) {
+    ResponseHeader header = {};
+    header.id = id;
+    header.status = status;
+    header.numPoints = points.size();
+    header.numDim = numDim;
+    appendBytes(buf, &header, sizeof(ResponseHeader));
+    for (const Point& p : points) {
+        appendBytes(buf, &p.distToQuery, sizeof(double));
+        appendBytes(buf, p.features.data(), numDim * sizeof(double));
+    }
+}
+
+/** Decode the next request. Return false on error, end of stream or a
+ *  request too large to be valid.
+ */
+inline bool readRequest(SocketReader& in, QueryRequest& request) {
+    if (!in.read(&request.header, sizeof(RequestHeader))) return false;
+    if (request.header.numDim > MAX_QUERY_DIM) return false;
+    request.values.resize(QueryRequest::numValues(request.header));
+    return in.read(request.values.data(),
+                   request.values.size() * sizeof(double));
+}
+
+/** Decode the next response. Return false on error or end of stream */
+inline bool readResponse(SocketReader& in, QueryResponse& response) {
+    if (!in.read(&response.header, sizeof(ResponseHeader))) return false;
+    if (response.header.numDim > MAX_QUERY_DIM) return false;
+    response.values.resize((size_t)response.header.numPoints *
+                           (1 + response.header.numDim));
+    return in.read(response.values.data(),
+                   response.values.size() * sizeof(double));
+}
+
+/** Fill in the socket address for address. Return the address family, or
+ *  -1 if address is not "unix:<path>" or "tcp:<port>"
+ */
+inline int parseAddress(const string& address, sockaddr_storage& storage,
+                        socklen_t& len) {
+    memset(&storage, 0, sizeof(storage));
+    if (address.compare(0, 5, "unix:") == 0) {
+        sockaddr_un* addr = (sockaddr_un*)&storage;
+        string path = address.substr(5);
+        if (path.empty() || path.size() >= sizeof(addr->sun_path)) return -1;
+        addr->sun_family = AF_UNIX;
+        strcpy(addr->sun_path, path.c_str());
+        len = sizeof(sockaddr_un);
+        return AF_UNIX;
+    }
+    if (address.compare(0, 4, "tcp:") == 0) {
+        sockaddr_in* addr = (sockaddr_in*)&storage;
+        int port = atoi(address.c_str() + 4);
+        if (port <= 0 || port > 65535) return -1;
+        addr->sin_family = AF_INET;
+        addr->sin_port = htons(port);
+        addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        len = sizeof(sockaddr_in);
+        return AF_INET;
+    }
+    return -1;
+}
+
+/** Open a listening socket on address. Return -1 on failure */
+inline int openListener(const string& address) {
+    sockaddr_storage storage;
+    socklen_t len;
+    int family = parseAddress(address, storage, len);
+    if (family < 0) return -1;
+    int fd = socket(family, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (family == AF_UNIX) {
+        // remove a socket file left behind by an earlier server, but never
+        // anything else a mistyped address may name
+        const char* path = ((sockaddr_un*)&storage)->sun_path;
+        struct stat info;
+        if (lstat(path, &info) == 0) {
+            if (!S_ISSOCK(info.st_mode)) {
+                close(fd);
+                return -1;
+            }
+            unlink(path);
+        }
+    } else {
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    }
+    if (bind(fd, (sockaddr*)&storage, len) < 0 || listen(fd, SOMAXCONN) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/** Connect to the server listening on address. Return -1 on failure */
+inline int openConnection(const string& address) {
+    sockaddr_storage storage;
+    socklen_t len;
+    int family = parseAddress(address, storage, len);
+    if (family < 0) return -1;
+    int fd = socket(family, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, (sockaddr*)&storage, len) < 0) {
+        close(fd);
+        return -1;
+    }
+    if (family == AF_INET) {
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    }
+    return fd;
+}
+
+#endif /* QueryProtocol_hpp */
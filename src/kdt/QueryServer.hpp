@@ -0,0 +1,266 @@
+/**
+ * Long-running server answering nearest neighbor, k nearest neighbor and
+ * range queries on a built KD tree over a local socket. See
+ * QueryProtocol.hpp for the wire format.
+ *
+ * Every connection has a reader thread which decodes requests into a
+ * shared queue. Worker threads take the queued requests in micro-batches
+ * of up to maxBatch, waiting at most batchDelay for a batch to fill up,
+ * answer them against the tree and send the responses of a batch with one
+ * write per connection.
+ */
+
+#ifndef QueryServer_hpp
+#define QueryServer_hpp
+
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include "KDT.hpp"
+#include "QueryProtocol.hpp"
+
+using namespace std;
+
+class QueryServer {
+  private:
+    /** An accepted client connection */
+    struct Connection {
+        int fd;
+        // serializes the responses written by different workers
+        mutex writeLock;
+
+        Connection(int fd) : fd(fd) {}
+        ~Connection() { close(fd); }
+    };
+
+    /** A decoded request waiting to be answered */
+    struct Job {
+        shared_ptr<Connection> conn;
+        QueryRequest request;
+    };
+
+    const KDT& tree;
+    unsigned int numWorkers;
+    unsigned int maxBatch;
+    chrono::microseconds batchDelay;
+    // queued requests beyond which readers stop reading from their sockets
+    unsigned int maxQueued;
+
+    int listenFd;
+    atomic<bool> running;
+    thread acceptor;
+    vector<thread> workers;
+
+    mutex queueLock;
+    condition_variable queueReady;
+    condition_variable queueSpace;
+    deque<Job> queue;
+
+    // open connections and number of reader threads still running
+    mutex connLock;
+    condition_variable readersDone;
+    set<shared_ptr<Connection>> connections;
+    unsigned int numReaders;
+
+    atomic<unsigned long long> numRequests;
+    atomic<unsigned long long> numBatches;
+
+  public:
+    /** Serve queries on tree, which must outlive the server and must not
+     *  be modified while the server runs.
+     *  numWorkers: number of threads answering queries
+     *  maxBatch: largest number of requests answered as one batch
+     *  batchDelayMicros: longest time a worker waits for a batch to fill up
+     */
+    QueryServer(const KDT& tree, unsigned int numWorkers = 4,
+                unsigned int maxBatch = 64, unsigned int batchDelayMicros = 50)
+        : tree(tree),
+          numWorkers(max(numWorkers, 1u)),
+          maxBatch(max(maxBatch, 1u)),
+          batchDelay(batchDelayMicros),
+          maxQueued(64 * max(maxBatch, 1u) * max(numWorkers, 1u)),
+          listenFd(-1),
+          running(false),
+          numReaders(0),
+          numRequests(0),
+          numBatches(0) {}
+
+    /** Destructor, stops the server if it is running */
+    ~QueryServer() { stop(); }
+
+    /** Start listening on address and serving queries in the background.
+     *  Return false if the address could not be opened.
+     */
+    bool start(const string& address) {
+        if (running) return false;
+        listenFd = openListener(address);
+        if (listenFd < 0) return false;
+        running = true;
+        for (unsigned int i = 0; i < numWorkers; i++) {
+            workers.emplace_back(&QueryServer::workerLoop, this);
+        }
+        acceptor = thread(&QueryServer::acceptLoop, this);
+        return true;
+    }
+
+    /** Stop accepting connections, close the open ones and wait for all
+     *  threads to finish. Queued requests are dropped.
+     */
+    void stop() {
+        if (!running.exchange(false)) return;
+        {
+            // wake up readers waiting for queue space and idle workers
+            lock_guard<mutex> lock(queueLock);
+        }
+        queueReady.notify_all();
+        queueSpace.notify_all();
+        shutdown(listenFd, SHUT_RDWR);
+        acceptor.join();
+        close(listenFd);
+        listenFd = -1;
+        {
+            unique_lock<mutex> lock(connLock);
+            for (const shared_ptr<Connection>& conn : connections) {
+                shutdown(conn->fd, SHUT_RDWR);
+            }
+            readersDone.wait(lock, [this] { return numReaders == 0; });
+        }
+        for (thread& worker : workers) worker.join();
+        workers.clear();
+        queue.clear();
+    }
+
+    /** Return the number of requests answered so far */
+    unsigned long long requestsServed() const { return numRequests; }
+
+    /** Return the number of batches answered so far */
+    unsigned long long batchesServed() const { return numBatches; }
+
+  private:
+    /** Accept connections and start a reader thread for each */
+    void acceptLoop() {
+        while (running) {
+            int fd = accept(listenFd, nullptr, nullptr);
+            if (fd < 0) {
+                if (errno == EINTR || errno == ECONNABORTED) continue;
+                return;
+            }
+            shared_ptr<Connection> conn = make_shared<Connection>(fd);
+            lock_guard<mutex> lock(connLock);
+            if (!running) {
+                shutdown(fd, SHUT_RDWR);
+                continue;
+            }
+            connections.insert(conn);
+            numReaders++;
+            thread(&QueryServer::readLoop, this, conn).detach();
+        }
+    }
+
+    /** Decode requests from one connection into the queue until the client
+     *  disconnects or the server stops
+     */
+    void readLoop(shared_ptr<Connection> conn) {
+        SocketReader in(conn->fd);
+        Job job;
+        job.conn = conn;
+        while (running && readRequest(in, job.request)) {
+            unique_lock<mutex> lock(queueLock);
+            queueSpace.wait(lock, [this] {
+                return !running || queue.size() < maxQueued;
+            });
+            if (!running) break;
+            queue.push_back(job);
+            lock.unlock();
+            queueReady.notify_one();
+        }
+        lock_guard<mutex> lock(connLock);
+        connections.erase(conn);
+        numReaders--;
+        readersDone.notify_all();
+    }
+
+    /** Answer batches of queued requests until the server stops */
+    void workerLoop() {
+        vector<Job> batch;
+        map<Connection*, vector<char>> output;
+        while (true) {
+            {
+                unique_lock<mutex> lock(queueLock);
+                queueReady.wait(lock,
+                                [this] { return !running || !queue.empty(); });
+                if (!running) return;
+                // give a small batch a moment to fill up
+                if (queue.size() < maxBatch && batchDelay.count() > 0) {
+                    queueReady.wait_for(lock, batchDelay, [this] {
+                        return !running || queue.size() >= maxBatch;
+                    });
+                    if (!running) return;
+                    if (queue.empty()) continue;
+                }
+                size_t count = min<size_t>(maxBatch, queue.size());
+                for (size_t i = 0; i < count; i++) {
+                    batch.push_back(move(queue.front()));
+                    queue.pop_front();
+                }
+            }
+            queueSpace.notify_all();
+
+            for (Job& job : batch) {
+                answer(job.request, output[job.conn.get()]);
+            }
+            numRequests += batch.size();
+            numBatches++;
+            for (Job& job : batch) {
+                vector<char>& buf = output[job.conn.get()];
+                if (buf.empty()) continue;
+                lock_guard<mutex> lock(job.conn->writeLock);
+                // a failed write means the client is gone, its reader
+                // thread cleans up
+                writeFully(job.conn->fd, buf.data(), buf.size());
+                buf.clear();
+            }
+            batch.clear();
+            output.clear();
+        }
+    }
+
+    /** Answer one request, appending the encoded response to buf */
+    void answer(const QueryRequest& request, vector<char>& buf) const {
+        const RequestHeader& header = request.header;
+        unsigned int numDim = tree.dimension();
+        if (header.numDim != numDim || tree.size() == 0) {
+            appendResponse(buf, header.id, QUERY_BAD_REQUEST, 0, {});
+            return;
+        }
+        if (header.type == NN_QUERY || header.type == KNN_QUERY) {
+            unsigned int k = header.type == NN_QUERY ? 1 : header.k;
+            Point query(request.values);
+            appendResponse(buf, header.id, QUERY_OK, numDim,
+                           tree.findKNearestNeighbors(query, k));
+        } else if (header.type == RANGE_QUERY) {
+            vector<pair<double, double>> region;
+            for (unsigned int i = 0; i < numDim; i++) {
+                region.emplace_back(request.values[2 * i],
+                                    request.values[2 * i + 1]);
+            }
+            vector<Point> found = tree.rangeSearch(region);
+            for (Point& p : found) p.distToQuery = 0;
+            appendResponse(buf, header.id, QUERY_OK, numDim, found);
+        } else {
+            appendResponse(buf, header.id, QUERY_BAD_REQUEST, 0, {});
+        }
+    }
+};
+
+#endif /* QueryServer_hpp */
@@ -0,0 +1,341 @@
+/**
+ * Streaming nearest neighbor queries: query points are read incrementally
+ * from a file descriptor in blocks, the blocks are answered on worker
+ * threads and the results are written in input order. A fixed pool of
+ * blocks is reused, so memory use does not grow with the number of
+ * queries.
+ */
+
+#ifndef QueryStream_hpp
+#define QueryStream_hpp
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "KDT.hpp"
+#include "Point.hpp"
+#include "PointFile.hpp"
+#include "PointReader.hpp"
+
+using namespace std;
+
+/** Incremental reader of query points from a text or binary point stream.
+ *  Works on pipes, so the format is detected from the first bytes rather
+ *  than by seeking.
+ */
+class QueryReader {
+  private:
+    int fd;
+    unsigned int numDim;
+    vector<char> buffer;
+    size_t begin;
+    size_t end;
+    bool eof;
+    // false once a value that is not a number was met
+    bool good;
+    bool binary;
+    uint32_t dtype;
+    // points left in a binary stream
+    uint64_t remaining;
+
+    /** Move the unread bytes to the front and read more behind them.
+     *  Return false if nothing more could be read.
+     */
+    bool fill() {
+        if (eof) return false;
+        if (begin > 0) {
+            memmove(buffer.data(), buffer.data() + begin, end - begin);
+            end -= begin;
+            begin = 0;
+        }
+        if (end == buffer.size()) buffer.resize(2 * buffer.size());
+        while (true) {
+            ssize_t got = read(fd, buffer.data() + end, buffer.size() - end);
+            if (got < 0 && errno == EINTR) continue;
+            if (got <= 0) {
+                if (got < 0) good = false;
+                eof = true;
+                return false;
+            }
+            end += got;
+            return true;
+        }
+    }
+
+    /** Make sure len bytes are buffered. Return false at end of stream */
+    bool ensure(size_t len) {
+        while (end - begin < len) {
+            if (!fill()) return false;
+        }
+        return true;
+    }
+
+    /** Read the header of a binary stream */
+    void readHeader() {
+        PointFileHeader header;
+        if (!ensure(sizeof(header))) {
+            good = false;
+            return;
+        }
+        memcpy(&header, buffer.data() + begin, sizeof(header));
+        begin += sizeof(header);
+        swapToLittleEndian(&header.version, 2, sizeof(uint32_t));
+        swapToLittleEndian(&header.count, 1, sizeof(uint64_t));
+        swapToLittleEndian(&header.numDim, 2, sizeof(uint32_t));
+        dtype = header.dtype;
+        remaining = header.count;
+        good = header.version == POINT_FILE_VERSION &&
+               (dtype == FLOAT64 || dtype == FLOAT32) &&
+               header.numDim == numDim;
+    }
+
+    /** Parse the next text value into value. Return false at the end of
+     *  the stream or at a value that is not a number.
+     */
+    bool nextValue(double& value) {
+        while (true) {
+            while (begin != end && isPointSpace(buffer[begin])) begin++;
+            if (begin != end) break;
+            if (!fill()) return false;
+        }
+        // make sure the whole value is buffered
+        size_t valueEnd = begin;
+        while (true) {
+            while (valueEnd != end && !isPointSpace(buffer[valueEnd])) {
+                valueEnd++;
+            }
+            if (valueEnd != end || eof) break;
+            size_t offset = valueEnd - begin;
+            if (!fill()) break;
+            valueEnd = begin + offset;
+        }
+        const char* first = buffer.data() + begin;
+        const char* last = buffer.data() + valueEnd;
+        if (parseDouble(first, last, value) != last) {
+            good = false;
+            return false;
+        }
+        begin = valueEnd;
+        return true;
+    }
+
+  public:
+    /** Read points of numDim features from fd, buffering bufferSize bytes
+     *  at a time
+     */
+    QueryReader(int fd, unsigned int numDim, size_t bufferSize = 1 << 20)
+        : fd(fd),
+          numDim(numDim),
+          buffer(max<size_t>(bufferSize, sizeof(PointFileHeader))),
+          begin(0),
+          end(0),
+          eof(false),
+          good(true),
+          binary(false),
+          dtype(FLOAT64),
+          remaining(0) {
+        ensure(sizeof(POINT_FILE_MAGIC));
+        binary = end - begin >= sizeof(POINT_FILE_MAGIC) &&
+                 memcmp(buffer.data() + begin, POINT_FILE_MAGIC,
+                        sizeof(POINT_FILE_MAGIC)) == 0;
+        if (binary) readHeader();
+    }
+
+    /** Read up to maxPoints points into out, numDim values per point.
+     *  Return the number of points read, 0 at the end of the stream.
+     */
+    size_t readPoints(double* out, size_t maxPoints) {
+        size_t count = 0;
+        if (binary) {
+            size_t valueSize = dtype == FLOAT64 ? sizeof(double)
+                                                : sizeof(float);
+            size_t pointSize = valueSize * numDim;
+            while (good && count < maxPoints && remaining > 0 &&
+                   ensure(pointSize)) {
+                const char* in = buffer.data() + begin;
+                double* point = out + count * numDim;
+                if (dtype == FLOAT64) {
+                    memcpy(point, in, pointSize);
+                    swapToLittleEndian(point, numDim, sizeof(double));
+                } else {
+                    for (unsigned int d = 0; d < numDim; d++) {
+                        float value;
+                        memcpy(&value, in + d * sizeof(float), sizeof(float));
+                        swapToLittleEndian(&value, 1, sizeof(float));
+                        point[d] = value;
+                    }
+                }
+                begin += pointSize;
+                remaining--;
+                count++;
+            }
+            return count;
+        }
+        while (good && count < maxPoints) {
+            double* point = out + count * numDim;
+            unsigned int d = 0;
+            while (d < numDim && nextValue(point[d])) d++;
+            // an incomplete last point is dropped
+            if (d < numDim) break;
+            count++;
+        }
+        return count;
+    }
+
+    /** Return true if reading stopped before the end of the stream: at a
+     *  value that is not a number, on a read error, or short of the count
+     *  in a binary header
+     */
+    bool failed() const { return !good || (binary && remaining > 0); }
+};
+
+/** Return the most bytes formatPoint() writes for a point of numDim
+ *  features: per feature a sign, 309 integer digits, a point, 6 decimals
+ *  and a separator, plus the parentheses and the newline
+ */
+inline size_t maxFormattedLength(unsigned int numDim) {
+    return numDim * 330 + 4;
+}
+
+/** Format a point like operator<< for Point does, followed by a newline,
+ *  into out, which must hold maxFormattedLength(numDim) bytes. Return the
+ *  number of bytes written. Uses no heap memory.
+ */
+inline size_t formatPoint(char* out, const vector<double>& features,
+                          unsigned int numDim) {
+    char* p = out;
+    *p++ = '(';
+    for (unsigned int i = 0; i < numDim; i++) {
+        // same conversion as to_string(double)
+        p += snprintf(p, 330, "%f", features[i]);
+        if (i + 1 < numDim) {
+            *p++ = ',';
+            *p++ = ' ';
+        }
+    }
+    *p++ = ')';
+    *p++ = '\n';
+    return p - out;
+}
+
+/** Answer the nearest neighbor query of every point read from inFd and
+ *  write the neighbors to out in input order, one per line in the format
+ *  of operator<< for Point. Queries are answered in blocks of blockSize on
+ *  numThreads threads (0: one per core). Return the number of queries
+ *  answered. If failed is given, it is set to whether the input stopped
+ *  early (see QueryReader::failed()), after the queries before that point
+ *  are answered.
+ */
+inline unsigned long long streamNearestNeighbors(const KDT& tree, int inFd,
+                                                 FILE* out,
+                                                 unsigned int numThreads = 0,
+                                                 size_t blockSize = 4096,
+                                                 bool* failed = nullptr) {
+    /** A block of queries and the formatted answers to them */
+    struct Block {
+        unsigned long long seq;
+        size_t count;
+        vector<double> queries;
+        // grown while formatting, as answers are far shorter than the
+        // longest one possible
+        vector<char> output;
+    };
+
+    unsigned int numDim = tree.dimension();
+    size_t maxLength = maxFormattedLength(numDim);
+    if (numThreads == 0) numThreads = max(1u, thread::hardware_concurrency());
+    blockSize = max<size_t>(blockSize, 1);
+    // blocks being read, answered or waiting for their turn to be written
+    size_t numBlocks = 2 * numThreads + 2;
+    vector<Block> blocks(numBlocks);
+    for (Block& block : blocks) block.queries.resize(blockSize * numDim);
+
+    mutex lock;
+    condition_variable changed;
+    deque<Block*> freeBlocks;
+    deque<Block*> readyBlocks;
+    for (Block& block : blocks) freeBlocks.push_back(&block);
+    bool inputDone = false;
+    unsigned long long nextToWrite = 0;
+
+    vector<thread> workers;
+    for (unsigned int t = 0; t < numThreads; t++) {
+        workers.emplace_back([&] {
+            Point query = Point(vector<double>(numDim));
+            while (true) {
+                Block* block;
+                {
+                    unique_lock<mutex> guard(lock);
+                    changed.wait(guard, [&] {
+                        return inputDone || !readyBlocks.empty();
+                    });
+                    if (readyBlocks.empty()) return;
+                    block = readyBlocks.front();
+                    readyBlocks.pop_front();
+                }
+                vector<char>& output = block->output;
+                size_t length = 0;
+                for (size_t i = 0; i < block->count; i++) {
+                    copy(block->queries.begin() + i * numDim,
+                         block->queries.begin() + (i + 1) * numDim,
+                         query.features.begin());
+                    const Point* neighbor = tree.findNearestPoint(query);
+                    if (output.size() < length + maxLength) {
+                        output.resize(max(2 * output.size(),
+                                          length + maxLength));
+                    }
+                    length += formatPoint(output.data() + length,
+                                          neighbor->features, numDim);
+                }
+                // write the answers once all earlier blocks are written
+                unique_lock<mutex> guard(lock);
+                changed.wait(guard, [&] { return nextToWrite == block->seq; });
+                fwrite(output.data(), 1, length, out);
+                nextToWrite++;
+                freeBlocks.push_back(block);
+                changed.notify_all();
+            }
+        });
+    }
+
+    unsigned long long numQueries = 0;
+    unsigned long long seq = 0;
+    QueryReader reader(inFd, numDim);
+    while (tree.size() > 0) {
+        Block* block;
+        {
+            unique_lock<mutex> guard(lock);
+            changed.wait(guard, [&] { return !freeBlocks.empty(); });
+            block = freeBlocks.front();
+            freeBlocks.pop_front();
+        }
+        block->count = reader.readPoints(block->queries.data(), blockSize);
+        if (block->count == 0) break;
+        block->seq = seq++;
+        numQueries += block->count;
+        {
+            lock_guard<mutex> guard(lock);
+            readyBlocks.push_back(block);
+        }
+        changed.notify_all();
+    }
+    {
+        lock_guard<mutex> guard(lock);
+        inputDone = true;
+    }
+    changed.notify_all();
+    for (thread& worker : workers) worker.join();
+    fflush(out);
+    if (failed != nullptr) *failed = reader.failed();
+    return numQueries;
+}
+
+#endif /* QueryStream_hpp */
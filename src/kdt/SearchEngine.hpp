@@ -0,0 +1,150 @@
+/**
+ * Nearest neighbor search that picks, for every batch of queries, between
+ * a brute force scan (BruteForce) and a KD tree (KDT) with a simple cost
+ * model of both, in nanoseconds:
+ *
+ *   scan    n * dim * scanCost per query
+ *   tree    visits * (visitCost + dim * visitCostPerDim) per query, where
+ *           a search visits about visitFactor * (k + log2 n) * 2^dim
+ *           nodes, and at most all n of them
+ *   build   n * log2 n * buildCost, once, before the first tree batch
+ *
+ * The tree is only built when a batch is expected to be answered faster
+ * with it, its build included, so small batches and high dimensions stay
+ * on the scan and large batches of low dimensional queries move to the
+ * tree. Both answer the same neighbors, up to ties in distance.
+ */
+
+#ifndef SearchEngine_hpp
+#define SearchEngine_hpp
+
+#include <math.h>
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include "BruteForce.hpp"
+#include "KDT.hpp"
+#include "Point.hpp"
+
+using namespace std;
+
+/** Costs of the model of SearchEngine, in nanoseconds. The defaults were
+ *  measured with 10 neighbors of uniform points.
+ */
+struct SearchCosts {
+    // per coordinate scanned
+    double scanCost = 1.0;
+
+    // per node a tree search visits, and per dimension of that node
+    double visitCost = 20;
+    double visitCostPerDim = 2;
+
+    // fraction of (k + log2 n) * 2^dim nodes a tree search visits
+    double visitFactor = 0.6;
+
+    // per point and per level of the tree build
+    double buildCost = 70;
+};
+
+class SearchEngine {
+  public:
+    /** How a batch of queries is answered */
+    enum Method { BRUTE_FORCE, KD_TREE };
+
+  private:
+    SearchCosts costs;
+    BruteForce scan;
+    // tree, nullptr until a batch needs it
+    unique_ptr<KDT> tree;
+
+    Method last;
+
+  public:
+    /** Constructor of an empty engine, see build() */
+    explicit SearchEngine(const SearchCosts& costs = SearchCosts())
+        : costs(costs), last(BRUTE_FORCE) {}
+
+    /** Take the points to search, which must all have the same number of
+     *  dimensions. Only the scan is built now, and the tree is built later
+     *  from the scan's copy of the points.
+     */
+    void build(const vector<Point>& points) {
+        scan.build(points);
+        tree.reset();
+    }
+
+    /** Return the number of points */
+    size_t size() const { return scan.size(); }
+
+    /** Return true once a batch has built the tree */
+    bool hasTree() const { return tree != nullptr; }
+
+    /** Return the method that answered the last batch */
+    Method lastMethod() const { return last; }
+
+    /** Return the expected time of numQueries searches for k neighbors by
+     *  method, including the tree build if it is still due
+     */
+    double expectedCost(Method method, size_t numQueries,
+                        unsigned int k) const {
+        double n = scan.size();
+        double numDim = scan.dimension();
+        if (method == BRUTE_FORCE) {
+            return numQueries * n * numDim * costs.scanCost;
+        }
+        double levels = log2(max(n, 2.0));
+        double visits = costs.visitFactor * (k + levels) *
+                        pow(2.0, min(numDim, 60.0));
+        visits = min(max(visits, 1.0), n);
+        double cost = numQueries * visits *
+                      (costs.visitCost + numDim * costs.visitCostPerDim);
+        if (tree == nullptr) cost += n * levels * costs.buildCost;
+        return cost;
+    }
+
+    /** Return the method expected to answer numQueries searches for k
+     *  neighbors faster
+     */
+    Method choose(size_t numQueries, unsigned int k) const {
+        return expectedCost(KD_TREE, numQueries, k) <
+                       expectedCost(BRUTE_FORCE, numQueries, k)
+                   ? KD_TREE
+                   : BRUTE_FORCE;
+    }
+
+    /** Return the k nearest neighbors of every query, nearest first with
+     *  distToQuery set, by the method choose() picks for the batch,
+     *  searching on numThreads threads (0: one per core)
+     */
+    vector<vector<Point>> findKNearestNeighbors(const vector<Point>& queries,
+                                                unsigned int k,
+                                                unsigned int numThreads = 0) {
+        last = choose(queries.size(), k);
+        if (last == BRUTE_FORCE) {
+            return scan.findKNearestNeighbors(queries, k, numThreads);
+        }
+        if (tree == nullptr) {
+            // the points exist only for the build, the tree keeps its own
+            vector<Point> points;
+            points.reserve(scan.size());
+            for (size_t i = 0; i < scan.size(); i++) {
+                points.push_back(scan.pointAt(i));
+            }
+            tree.reset(new KDT());
+            tree->build(points);
+        }
+        vector<vector<Point>> results(queries.size());
+        // tree searches that make a range worth a thread
+        const size_t MIN_QUERIES = 64;
+        parallelRanges(queries.size(), numThreads, MIN_QUERIES,
+                       [&](size_t first, size_t end) {
+                           for (size_t i = first; i < end; i++) {
+                               results[i] =
+                                   tree->findKNearestNeighbors(queries[i], k);
+                           }
+                       });
+        return results;
+    }
+};
+
+#endif /* SearchEngine_hpp */
@@ -0,0 +1,345 @@
+/**
+ * Small harness for repeatable benchmarks. A case runs its work a few
+ * times to warm up, then for every repetition times the work in batches
+ * of operations, so that each batch gives one sample of the time per
+ * operation. The samples of a case are summed up as the median, the
+ * percentiles and the throughput at the median, printed as a table and
+ * written to a JSON file for tracking over time:
+ *
+ *   {"context": {"repetitions": 5, "warmup": 1, "quick": false, ...},
+ *    "benchmarks": [{"name": "kdt/knn", "params": {"n": 100000, ...},
+ *                    "samples": 100, "median_ns": 1520.5, "p10_ns": ...,
+ *                    "p90_ns": ..., "p99_ns": ..., "min_ns": ...,
+ *                    "max_ns": ..., "ops_per_sec": ...}, ...]}
+ */
+
+#ifndef Benchmark_hpp
+#define Benchmark_hpp
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Timer.hpp"
+
+using namespace std;
+
+/** Parameters of a case, in the order they are printed */
+typedef vector<pair<string, string>> BenchmarkParams;
+
+/** Summary of the samples of one case */
+struct BenchmarkResult {
+    string name;
+    BenchmarkParams params;
+    size_t samples;
+    double median;
+    double p10;
+    double p90;
+    double p99;
+    double min;
+    double max;
+};
+
+class Benchmark {
+  private:
+    // timed runs of every case, after the warmup runs
+    unsigned int repetitions;
+
+    // untimed runs of every case
+    unsigned int warmups;
+
+    // smaller sweeps
+    bool quick;
+
+    // only cases whose name contains it run
+    string filter;
+
+    // JSON output, none if empty
+    string jsonFile;
+
+    // sweeps, empty for the defaults of the suite
+    vector<size_t> sizes;
+    vector<unsigned int> dims;
+
+    vector<BenchmarkResult> results;
+
+  public:
+    /** Read the options from the command line:
+     *    --repetitions R  timed runs of every case (default 5)
+     *    --warmup W       untimed runs before them (default 1)
+     *    --quick          smaller sweeps, for a fast check
+     *    --filter S       run only the cases whose name contains S
+     *    --sizes N,N,...  numbers of items or points to sweep
+     *    --dims D,D,...   KD tree dimensions to sweep
+     *    --json FILE      write the results to FILE
+     *  Exit with a usage message on anything else.
+     */
+    Benchmark(int argc, char* argv[])
+        : repetitions(5), warmups(1), quick(false) {
+        for (int i = 1; i < argc; i++) {
+            string option = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (option == "--quick") {
+                quick = true;
+            } else if (option == "--repetitions" && hasValue) {
+                repetitions = max(1, atoi(argv[++i]));
+            } else if (option == "--warmup" && hasValue) {
+                warmups = max(0, atoi(argv[++i]));
+            } else if (option == "--filter" && hasValue) {
+                filter = argv[++i];
+            } else if (option == "--sizes" && hasValue) {
+                if (!parseList(argv[++i], sizes)) usage(argv[0]);
+            } else if (option == "--dims" && hasValue) {
+                if (!parseList(argv[++i], dims)) usage(argv[0]);
+            } else if (option == "--json" && hasValue) {
+                jsonFile = argv[++i];
+            } else {
+                usage(argv[0]);
+            }
+        }
+    }
+
+    /** Return true for smaller sweeps */
+    bool isQuick() const { return quick; }
+
+    /** Return the sizes to sweep, or defaults if none were given */
+    vector<size_t> sizesOr(const vector<size_t>& defaults) const {
+        return sizes.empty() ? defaults : sizes;
+    }
+
+    /** Return the dimensions to sweep, or defaults if none were given */
+    vector<unsigned int> dimsOr(const vector<unsigned int>& defaults) const {
+        return dims.empty() ? defaults : dims;
+    }
+
+    /** Return true if the case called name is to run */
+    bool selected(const string& name) const {
+        return name.find(filter) != string::npos;
+    }
+
+    /** Return true if any of the cases called names is to run */
+    bool selectedAny(const vector<string>& names) const {
+        for (const string& name : names) {
+            if (selected(name)) return true;
+        }
+        return false;
+    }
+
+    /** Time work(first, last), which runs operations [first, last) of
+     *  numOps, in batches of batchSize operations: whole for the warmup
+     *  runs, then batch by batch in every repetition. Skipped unless
+     *  selected(name).
+     */
+    template <typename Work>
+    void measure(const string& name, const BenchmarkParams& params,
+                 size_t numOps, size_t batchSize, Work work) {
+        if (!selected(name) || numOps == 0) return;
+        batchSize = max<size_t>(1, min(batchSize, numOps));
+        for (unsigned int w = 0; w < warmups; w++) work(0, numOps);
+        vector<double> samples;
+        Timer timer;
+        for (unsigned int r = 0; r < repetitions; r++) {
+            for (size_t first = 0; first < numOps; first += batchSize) {
+                size_t last = min(numOps, first + batchSize);
+                timer.begin_timer();
+                work(first, last);
+                samples.push_back((double)timer.end_timer() / (last - first));
+            }
+        }
+        record(name, params, samples);
+    }
+
+    /** Time once(), which does numOps operations from scratch, in every
+     *  warmup run and repetition. prepare() runs untimed before each, to
+     *  reset the state once() changes. Skipped unless selected(name).
+     */
+    template <typename Prepare, typename Once>
+    void measureOnce(const string& name, const BenchmarkParams& params,
+                     size_t numOps, Prepare prepare, Once once) {
+        if (!selected(name) || numOps == 0) return;
+        vector<double> samples;
+        Timer timer;
+        for (unsigned int r = 0; r < warmups + repetitions; r++) {
+            prepare();
+            timer.begin_timer();
+            once();
+            double sample = (double)timer.end_timer() / numOps;
+            if (r >= warmups) samples.push_back(sample);
+        }
+        record(name, params, samples);
+    }
+
+    /** Add a case from its samples, in nanoseconds per operation, and
+     *  print it
+     */
+    void record(const string& name, const BenchmarkParams& params,
+                vector<double> samples) {
+        sort(samples.begin(), samples.end());
+        BenchmarkResult result;
+        result.name = name;
+        result.params = params;
+        result.samples = samples.size();
+        result.median = percentile(samples, 50);
+        result.p10 = percentile(samples, 10);
+        result.p90 = percentile(samples, 90);
+        result.p99 = percentile(samples, 99);
+        result.min = samples.front();
+        result.max = samples.back();
+        results.push_back(result);
+
+        ostringstream label;
+        label << name;
+        for (const pair<string, string>& param : params) {
+            label << " " << param.first << "=" << param.second;
+        }
+        cout << left << setw(52) << label.str() << right << fixed
+             << setprecision(1) << " median " << setw(10) << result.median
+             << " ns  p90 " << setw(10) << result.p90 << " ns  "
+             << setprecision(0) << setw(12) << 1e9 / result.median
+             << " ops/s" << endl;
+    }
+
+    /** Write the JSON file if one was asked for. Return the exit code of
+     *  the suite: 0, or 1 if the file cannot be written.
+     */
+    int finish() const {
+        if (jsonFile.empty()) return 0;
+        ofstream out(jsonFile);
+        out << "{\"context\": {\"date\": " << (long long)time(nullptr)
+            << ", \"repetitions\": " << repetitions
+            << ", \"warmup\": " << warmups
+            << ", \"quick\": " << (quick ? "true" : "false")
+#ifdef __VERSION__
+            << ", \"compiler\": \"" << escape(__VERSION__) << "\""
+#endif
+            << "},\n \"benchmarks\": [";
+        for (size_t i = 0; i < results.size(); i++) {
+            const BenchmarkResult& result = results[i];
+            out << (i == 0 ? "\n" : ",\n") << "  {\"name\": \""
+                << escape(result.name) << "\", \"params\": {";
+            for (size_t p = 0; p < result.params.size(); p++) {
+                out << (p == 0 ? "" : ", ") << "\""
+                    << escape(result.params[p].first) << "\": "
+                    << jsonValue(result.params[p].second);
+            }
+            out << "}, \"samples\": " << result.samples << setprecision(1)
+                << fixed << ", \"median_ns\": " << result.median
+                << ", \"p10_ns\": " << result.p10
+                << ", \"p90_ns\": " << result.p90
+                << ", \"p99_ns\": " << result.p99
+                << ", \"min_ns\": " << result.min
+                << ", \"max_ns\": " << result.max
+                << ", \"ops_per_sec\": " << 1e9 / result.median << "}";
+        }
+        out << "\n ]}\n";
+        out.close();
+        if (out.fail()) {
+            cerr << "Could not write " << jsonFile << endl;
+            return 1;
+        }
+        cout << "Results written to " << jsonFile << endl;
+        return 0;
+    }
+
+  private:
+    /** Print the usage message and exit */
+    [[noreturn]] static void usage(const char* program) {
+        cerr << "Usage: " << program
+             << " [--repetitions R] [--warmup W] [--quick]"
+             << " [--filter S] [--sizes N,N] [--dims D,D]"
+             << " [--json FILE]" << endl;
+        exit(2);
+    }
+
+    /** Return the p-th percentile of the sorted samples, by nearest rank */
+    static double percentile(const vector<double>& sorted, double p) {
+        size_t rank = (size_t)(p / 100 * sorted.size() + 0.5);
+        return sorted[min(sorted.size() - 1, rank == 0 ? 0 : rank - 1)];
+    }
+
+    /** Return the comma separated parts of list */
+    static vector<string> split(const string& list) {
+        vector<string> parts;
+        stringstream in(list);
+        string part;
+        while (getline(in, part, ',')) {
+            if (!part.empty()) parts.push_back(part);
+        }
+        return parts;
+    }
+
+    /** Append the comma separated numbers of list to values. Return false
+     *  if there is none, or one is not a positive decimal number that fits
+     *  a Number.
+     */
+    template <typename Number>
+    static bool parseList(const string& list, vector<Number>& values) {
+        for (const string& part : split(list)) {
+            if (part.find_first_not_of("0123456789") != string::npos) {
+                return false;
+            }
+            errno = 0;
+            unsigned long long value = strtoull(part.c_str(), nullptr, 10);
+            if (errno == ERANGE || value == 0 || (Number)value != value) {
+                return false;
+            }
+            values.push_back((Number)value);
+        }
+        return !values.empty();
+    }
+
+    /** Return true if value is a number in the decimal syntax of JSON:
+     *  an optional minus, an integer without leading zeros, an optional
+     *  fraction and an optional exponent
+     */
+    static bool isJsonNumber(const string& value) {
+        size_t i = 0;
+        // skip digits, return how many
+        auto digits = [&value, &i] {
+            size_t start = i;
+            while (i < value.size() && value[i] >= '0' && value[i] <= '9') i++;
+            return i - start;
+        };
+        if (i < value.size() && value[i] == '-') i++;
+        size_t integer = i;
+        size_t integerDigits = digits();
+        if (integerDigits == 0) return false;
+        if (value[integer] == '0' && integerDigits > 1) return false;
+        if (i < value.size() && value[i] == '.') {
+            i++;
+            if (digits() == 0) return false;
+        }
+        if (i < value.size() && (value[i] == 'e' || value[i] == 'E')) {
+            i++;
+            if (i < value.size() && (value[i] == '+' || value[i] == '-')) i++;
+            if (digits() == 0) return false;
+        }
+        return i == value.size();
+    }
+
+    /** Return s with the characters JSON strings cannot hold escaped */
+    static string escape(const string& s) {
+        string escaped;
+        for (char c : s) {
+            if (c == '"' || c == '\\') escaped += '\\';
+            if ((unsigned char)c >= ' ') escaped += c;
+        }
+        return escaped;
+    }
+
+    /** Return value as a JSON number if it is one, else as a string */
+    static string jsonValue(const string& value) {
+        if (isJsonNumber(value)) return value;
+        return "\"" + escape(value) + "\"";
+    }
+};
+
+#endif /* Benchmark_hpp */
@@ -0,0 +1,233 @@
+/**
+ * Benchmark suite of the BST and KD tree operations, for tracking their
+ * performance over time:
+ *   bst/insert, avl/insert   insert n keys in random or sorted order
+ *   bst/find, avl/find       find keys that are in the tree, and keys
+ *                            that are not
+ *   bst/iterate, avl/iterate visit every key in order
+ *   kdt/build                build a tree of n points
+ *   kdt/nn, kdt/knn          nearest and 10 nearest neighbors of points
+ *                            drawn like the tree points
+ *   kdt/range                points in boxes around those points, sized
+ *                            to hold about 10 uniform points
+ *   brute/knn                10 nearest neighbors by BruteForce, on fewer
+ *                            queries when n * dim is large
+ *   engine/knn               10 nearest neighbors of the whole batch of
+ *                            queries by SearchEngine, on one thread, with
+ *                            the method it picks as a parameter
+ * swept over n, the dimension and the distribution of the points, every
+ * one of PointGenerator.hpp. The plain BST is not given sorted keys past
+ * 10^4, where it degenerates into a list.
+ *
+ * Usage: ./benchmark [--repetitions R] [--warmup W] [--quick] [--filter S]
+ *                    [--sizes N,N] [--dims D,D] [--json FILE]
+ * See Benchmark.hpp for the options and the JSON format. `ninja -C build
+ * benchmark` runs the suite and writes build/benchmark.json.
+ */
+
+#include <cmath>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "AVL.hpp"
+#include "BST.hpp"
+#include "Benchmark.hpp"
+#include "BruteForce.hpp"
+#include "KDT.hpp"
+#include "Point.hpp"
+#include "PointGenerator.hpp"
+#include "SearchEngine.hpp"
+
+using namespace std;
+
+// results of the timed operations, so that they are not optimized away
+volatile size_t sink;
+
+/** Return n distinct even keys in random order, or sorted */
+vector<unsigned int> evenKeys(size_t n, bool sorted, mt19937_64& random) {
+    vector<unsigned int> keys(n);
+    for (size_t i = 0; i < n; i++) keys[i] = 2 * i;
+    if (!sorted) shuffle(keys.begin(), keys.end(), random);
+    return keys;
+}
+
+/** Return numQueries keys drawn from keys, plus one if miss to get keys
+ *  that are not there
+ */
+vector<unsigned int> keyQueries(const vector<unsigned int>& keys,
+                                size_t numQueries, bool miss,
+                                mt19937_64& random) {
+    vector<unsigned int> queries(numQueries);
+    for (unsigned int& query : queries) {
+        query = keys[random() % keys.size()] + (miss ? 1 : 0);
+    }
+    return queries;
+}
+
+/** Time inserting n keys into a Tree, finding keys in it and iterating
+ *  over it
+ */
+template <typename Tree>
+void benchmarkTree(Benchmark& bench, const string& treeName, size_t n,
+                   bool sorted, mt19937_64& random) {
+    if (!bench.selectedAny({treeName + "/insert", treeName + "/find",
+                            treeName + "/iterate"})) {
+        return;
+    }
+    BenchmarkParams params{{"n", to_string(n)},
+                           {"order", sorted ? "sorted" : "random"}};
+    vector<unsigned int> keys = evenKeys(n, sorted, random);
+    unique_ptr<Tree> tree;
+    bench.measureOnce(
+        treeName + "/insert", params, n, [&]() { tree.reset(new Tree()); },
+        [&]() {
+            for (unsigned int key : keys) tree->insert(key);
+        });
+    if (tree == nullptr || tree->size() != n) {
+        tree.reset(new Tree());
+        for (unsigned int key : keys) tree->insert(key);
+    }
+
+    size_t numQueries = min<size_t>(n, bench.isQuick() ? 10000 : 100000);
+    for (bool miss : {false, true}) {
+        vector<unsigned int> queries =
+            keyQueries(keys, numQueries, miss, random);
+        BenchmarkParams findParams = params;
+        findParams.push_back({"queries", miss ? "miss" : "hit"});
+        bench.measure(treeName + "/find", findParams, numQueries, 1000,
+                      [&](size_t first, size_t last) {
+                          size_t found = 0;
+                          for (size_t i = first; i < last; i++) {
+                              found += tree->find(queries[i]) != tree->end();
+                          }
+                          sink = found;
+                      });
+    }
+
+    bench.measure(treeName + "/iterate", params, n, n,
+                  [&](size_t, size_t) {
+                      size_t sum = 0;
+                      for (unsigned int key : *tree) sum += key;
+                      sink = sum;
+                  });
+}
+
+/** Time building a KD tree of n points and searching it */
+void benchmarkKDT(Benchmark& bench, size_t n, unsigned int numDim,
+                  PointDistribution distribution) {
+    if (!bench.selectedAny({"kdt/build", "kdt/nn", "kdt/knn", "kdt/range",
+                            "brute/knn", "engine/knn"})) {
+        return;
+    }
+    BenchmarkParams params{{"n", to_string(n)},
+                           {"dim", to_string(numDim)},
+                           {"distribution", distributionName(distribution)}};
+    PointWorkload workload(distribution, n, numDim);
+    vector<Point> points = generatePoints(workload).toPoints();
+    vector<Point> input;
+    unique_ptr<KDT> tree;
+    bench.measureOnce(
+        "kdt/build", params, n,
+        [&]() {
+            tree.reset(new KDT());
+            input = points;
+        },
+        [&]() { tree->build(input); });
+    if (tree == nullptr || tree->size() != n) {
+        tree.reset(new KDT());
+        input = points;
+        tree->build(input);
+    }
+    input.clear();
+
+    size_t numQueries = bench.isQuick() ? 200 : 1000;
+    PointWorkload queryWorkload(distribution, numQueries, numDim, 7);
+    vector<Point> queries = generatePoints(queryWorkload).toPoints();
+    bench.measure("kdt/nn", params, numQueries, 50,
+                  [&](size_t first, size_t last) {
+                      for (size_t i = first; i < last; i++) {
+                          sink = (size_t)tree->findNearestPoint(queries[i]);
+                      }
+                  });
+    BenchmarkParams knnParams = params;
+    knnParams.push_back({"k", "10"});
+    bench.measure("kdt/knn", knnParams, numQueries, 50,
+                  [&](size_t first, size_t last) {
+                      for (size_t i = first; i < last; i++) {
+                          sink = tree->findKNearestNeighbors(queries[i], 10)
+                                     .size();
+                      }
+                  });
+    double side = pow(10.0 / n, 1.0 / numDim) * (workload.max - workload.min);
+    vector<vector<pair<double, double>>> boxes;
+    for (const Point& query : queries) {
+        vector<pair<double, double>> box;
+        for (double x : query.features) {
+            box.push_back({x - side / 2, x + side / 2});
+        }
+        boxes.push_back(box);
+    }
+    bench.measure("kdt/range", params, numQueries, 50,
+                  [&](size_t first, size_t last) {
+                      for (size_t i = first; i < last; i++) {
+                          sink = tree->rangeSearch(boxes[i]).size();
+                      }
+                  });
+
+    BruteForce scan;
+    scan.build(points);
+    // about 10^7 coordinates scanned per repetition
+    size_t numScans =
+        min(numQueries, max<size_t>(10, 10000000 / (n * numDim)));
+    bench.measure("brute/knn", knnParams, numScans, 10,
+                  [&](size_t first, size_t last) {
+                      for (size_t i = first; i < last; i++) {
+                          sink = scan.findKNearestNeighbors(queries[i], 10)
+                                     .size();
+                      }
+                  });
+    SearchEngine engine;
+    engine.build(points);
+    BenchmarkParams engineParams = knnParams;
+    engineParams.push_back(
+        {"method", engine.choose(numQueries, 10) == SearchEngine::KD_TREE
+                       ? "kd_tree"
+                       : "brute_force"});
+    bench.measure("engine/knn", engineParams, numQueries, numQueries,
+                  [&](size_t first, size_t last) {
+                      vector<Point> batch(queries.begin() + first,
+                                          queries.begin() + last);
+                      sink = engine.findKNearestNeighbors(batch, 10, 1).size();
+                  });
+}
+
+int main(int argc, char* argv[]) {
+    Benchmark bench(argc, argv);
+    mt19937_64 random(42);
+    vector<size_t> defaultSizes = bench.isQuick()
+                                      ? vector<size_t>{1000, 10000}
+                                      : vector<size_t>{10000, 100000, 1000000};
+    vector<size_t> sizes = bench.sizesOr(defaultSizes);
+
+    for (size_t n : sizes) {
+        for (bool sorted : {false, true}) {
+            if (!sorted || n <= 10000) {
+                benchmarkTree<BST<unsigned int>>(bench, "bst", n, sorted,
+                                                 random);
+            }
+            benchmarkTree<AVL<unsigned int>>(bench, "avl", n, sorted, random);
+        }
+    }
+
+    vector<unsigned int> dims = bench.dimsOr(
+        bench.isQuick() ? vector<unsigned int>{2, 3}
+                        : vector<unsigned int>{2, 3, 5, 8});
+    for (PointDistribution distribution : POINT_DISTRIBUTIONS) {
+        for (unsigned int numDim : dims) {
+            for (size_t n : sizes) benchmarkKDT(bench, n, numDim, distribution);
+        }
+    }
+    return bench.finish();
+}
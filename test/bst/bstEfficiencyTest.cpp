@@ -0,0 +1,757 @@
+/**
+ * Test efficiency of the trees on actor names and integer keys:
+ *   1, 2   insert and find the names in a BST and an AVL, in sorted and
+ *          in shuffled order
+ *   3      build a tree from all names at once, compared to inserting
+ *          them one by one
+ *   4      find in the pointer tree, findBatch and find in a FrozenBST
+ *          snapshot, from 10^4 integer keys up to the given maximum
+ *   5      string lookups, compared to lookups straight from a character
+ *          buffer
+ *   6      lookups on more reader threads while a writer inserts, in a
+ *          ConcurrentBST and in a BST behind a mutex
+ *   7      read pages of names from any position, walking from begin()
+ *          and with select()
+ *   8      type names one character at a time, with the latency of the
+ *          matches shown per keystroke
+ *   9      merge and intersect a cast list with all names, item by item
+ *          and with the set operations, and merge two large trees on
+ *          more threads
+ *   10     hit-heavy and miss-heavy lookups with and without a Bloom
+ *          filter in front of the tree
+ *   11     Zipf distributed lookups of names and keys in balanced trees
+ *          and in a splay tree
+ *   12     full iterations over trees with parent pointers and over
+ *          threaded trees
+ *   13     find with and without a hash index, and the memory the index
+ *          takes
+ *   14     load a tree from a text file, load a snapshot into a tree and
+ *          map it, and look up names in the mapped snapshot
+ *
+ * Usage: ./bstEfficiencyTest [actor names filename] [max number of keys]
+ * Without a file, data/actors.txt is used. The maximum defaults to 10^7,
+ * 10^8 keys take about 6 GB.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "AVL.hpp"
+#include "BST.hpp"
+#include "BSTSnapshot.hpp"
+#include "ConcurrentBST.hpp"
+#include "FrozenBST.hpp"
+#include "SplayBST.hpp"
+#include "ThreadedBST.hpp"
+#include "Timer.hpp"
+
+using namespace std;
+
+/** Returns the lines of a file, one name per line */
+vector<string> readNames(const char* fileName) {
+    vector<string> names;
+    ifstream in(fileName, ios::binary);
+    string line;
+    while (getline(in, line)) {
+        line = line.substr(0, line.find('\r'));
+        if (!line.empty()) names.push_back(line);
+    }
+    return names;
+}
+
+/** Insert every name into tree, then find every name in it, and print
+ *  the time taken per operation
+ */
+void insertAndFind(BST<string>& tree, const vector<string>& names) {
+    Timer t;
+    t.begin_timer();
+    for (const string& name : names) tree.insert(name);
+    long long insertTime = t.end_timer();
+
+    unsigned int found = 0;
+    t.begin_timer();
+    for (const string& name : names) {
+        if (tree.find(name) != tree.end()) found++;
+    }
+    long long findTime = t.end_timer();
+
+    cout << "  height " << tree.height() << ", found " << found << endl;
+    cout << "  insert: " << insertTime / names.size() << " ns/op, "
+         << (long long)(names.size() * 1e9 / insertTime) << " ops/s" << endl;
+    cout << "  find:   " << findTime / names.size() << " ns/op, "
+         << (long long)(names.size() * 1e9 / findTime) << " ops/s" << endl;
+}
+
+/** Return the time per find of every query in tree, in nanoseconds */
+template <typename Tree>
+double timeFinds(const Tree& tree, const vector<unsigned int>& queries) {
+    Timer t;
+    unsigned int found = 0;
+    t.begin_timer();
+    for (unsigned int query : queries) {
+        if (tree.find(query) != tree.end()) found++;
+    }
+    long long findTime = t.end_timer();
+    // use the result so that the loop is not optimized away
+    if (found == queries.size() + 1) cout << found;
+    return (double)findTime / queries.size();
+}
+
+/** Return the time per query of findBatch over all queries, in
+ *  nanoseconds
+ */
+double timeFindBatch(const BST<unsigned int>& tree,
+                     const vector<unsigned int>& queries) {
+    Timer t;
+    vector<BST<unsigned int>::iterator> results;
+    t.begin_timer();
+    tree.findBatch(queries, results);
+    long long findTime = t.end_timer();
+    return (double)findTime / queries.size();
+}
+
+/** Time lookups of every name in tree, once constructing a string from a
+ *  character buffer as a line reader would, once from the buffer itself
+ */
+void timeStringFinds(const BST<string>& tree, const vector<string>& names) {
+    // lookups per measurement
+    const size_t NUM_LOOKUPS = 2000000;
+
+    // the names one after another in one buffer
+    string buffer;
+    vector<pair<size_t, size_t>> spans;
+    for (const string& name : names) {
+        spans.push_back(make_pair(buffer.size(), name.size()));
+        buffer += name;
+    }
+    Timer t;
+    unsigned int found = 0;
+    t.begin_timer();
+    for (size_t i = 0; i < NUM_LOOKUPS; i++) {
+        const pair<size_t, size_t>& span = spans[i % spans.size()];
+        string name(buffer.data() + span.first, span.second);
+        if (tree.find(name) != tree.end()) found++;
+    }
+    long long stringTime = t.end_timer();
+    t.begin_timer();
+    for (size_t i = 0; i < NUM_LOOKUPS; i++) {
+        const pair<size_t, size_t>& span = spans[i % spans.size()];
+        if (tree.find(buffer.data() + span.first, span.second) != tree.end()) {
+            found++;
+        }
+    }
+    long long bufferTime = t.end_timer();
+    cout << "  found " << found / 2 << " of " << NUM_LOOKUPS << endl;
+    cout << "  find(string):        " << stringTime / NUM_LOOKUPS << " ns/op"
+         << endl;
+    cout << "  find(char*, length): " << bufferTime / NUM_LOOKUPS << " ns/op"
+         << endl;
+}
+
+/** Run numReaders threads that each find names with find, while
+ *  another thread calls insert every 100 microseconds. Return the number of
+ *  lookups per second.
+ */
+template <typename Find, typename Insert>
+double readScaling(unsigned int numReaders, const vector<string>& names,
+                   Find find, Insert insert) {
+    // lookups of every reader
+    const size_t NUM_LOOKUPS = 500000;
+
+    atomic<bool> done(false);
+    thread writer([&] {
+        for (int i = 0; !done.load(); i++) {
+            insert(names[i % names.size()] + " #" + to_string(i));
+            this_thread::sleep_for(chrono::microseconds(100));
+        }
+    });
+    atomic<size_t> found(0);
+    Timer t;
+    t.begin_timer();
+    vector<thread> readers;
+    for (unsigned int r = 0; r < numReaders; r++) {
+        readers.emplace_back([&names, &find, &found, r] {
+            size_t hits = 0;
+            for (size_t i = 0; i < NUM_LOOKUPS; i++) {
+                if (find(names[(i + r * 7919) % names.size()])) hits++;
+            }
+            found += hits;
+        });
+    }
+    for (thread& reader : readers) reader.join();
+    long long readTime = t.end_timer();
+    done.store(true);
+    writer.join();
+    if (found.load() != numReaders * NUM_LOOKUPS) cout << "Missed a name";
+    return numReaders * NUM_LOOKUPS * 1e9 / readTime;
+}
+
+/** Type every name of typed one character at a time, calling complete
+ *  with each prefix, and print the median and 99th percentile time per
+ *  keystroke
+ */
+template <typename Complete>
+void timeKeystrokes(const vector<string>& typed, Complete complete) {
+    Timer t;
+    vector<long long> times;
+    size_t numMatches = 0;
+    for (const string& name : typed) {
+        for (size_t len = 1; len <= name.size(); len++) {
+            t.begin_timer();
+            numMatches += complete(name.substr(0, len));
+            times.push_back(t.end_timer());
+        }
+    }
+    sort(times.begin(), times.end());
+    cout << numMatches / times.size() << " matches/keystroke, p50 "
+         << times[times.size() / 2] << " ns, p99 "
+         << times[times.size() * 99 / 100] << " ns" << endl;
+}
+
+/** Time finding queries in tree and print the time per lookup */
+void timeFilteredFinds(const BST<string>& tree, const vector<string>& queries,
+                       const string& label) {
+    Timer t;
+    size_t found = 0;
+    t.begin_timer();
+    for (const string& query : queries) {
+        if (tree.find(query) != tree.end()) found++;
+    }
+    long long time = t.end_timer();
+    cout << "  " << label << string(30 - label.size(), ' ')
+         << time / queries.size() << " ns/find, "
+         << found * 100 / queries.size() << "% found" << endl;
+}
+
+/** Return count indexes below n drawn from a Zipf distribution with
+ *  exponent skew: index i is drawn in proportion to 1 / (i + 1)^skew
+ */
+vector<size_t> zipfIndexes(size_t n, double skew, size_t count,
+                           mt19937& random) {
+    vector<double> cumulative(n);
+    double sum = 0;
+    for (size_t i = 0; i < n; i++) {
+        sum += 1 / pow(i + 1.0, skew);
+        cumulative[i] = sum;
+    }
+    uniform_real_distribution<double> uniform(0, sum);
+    vector<size_t> indexes(count);
+    for (size_t& index : indexes) {
+        index = lower_bound(cumulative.begin(), cumulative.end(),
+                            uniform(random)) -
+                cumulative.begin();
+        if (index == n) index = n - 1;
+    }
+    return indexes;
+}
+
+/** Find every query in tree, through a non-const reference so that a
+ *  splay tree adapts, and return the time per lookup
+ */
+template <typename Tree, typename Query>
+long long timeSkewedFinds(Tree& tree, const vector<Query>& queries) {
+    Timer t;
+    size_t found = 0;
+    t.begin_timer();
+    for (const Query& query : queries) {
+        if (tree.find(query) != tree.end()) found++;
+    }
+    long long time = t.end_timer();
+    if (found != queries.size()) cout << "Missed a query";
+    return time / queries.size();
+}
+
+/** Iterate over tree rounds times and return the time per item */
+template <typename Tree>
+double timeIteration(const Tree& tree, unsigned int rounds) {
+    Timer t;
+    unsigned long long sum = 0;
+    t.begin_timer();
+    for (unsigned int round = 0; round < rounds; round++) {
+        for (auto it = tree.begin(); it != tree.end(); ++it) sum += *it;
+    }
+    long long time = t.end_timer();
+    if (sum == 0) cout << "No keys";
+    return (double)time / rounds / tree.size();
+}
+
+/** Time finding every query in tree and return the time per lookup */
+template <typename Query>
+long long timeIndexFinds(const BST<Query>& tree, const vector<Query>& queries,
+                         size_t& found) {
+    Timer t;
+    t.begin_timer();
+    for (const Query& query : queries) {
+        if (tree.find(query) != tree.end()) found++;
+    }
+    return t.end_timer() / queries.size();
+}
+
+/** Print the time per lookup of hits and misses in tree, without and with
+ *  a hash index, and the memory of the tree nodes and of the index
+ */
+template <typename Query>
+void compareHashIndex(BST<Query>& tree, const vector<Query>& hits,
+                      const vector<Query>& misses) {
+    size_t found = 0;
+    long long treeHits = timeIndexFinds(tree, hits, found);
+    long long treeMisses = timeIndexFinds(tree, misses, found);
+    tree.useHashIndex(true);
+    long long indexHits = timeIndexFinds(tree, hits, found);
+    long long indexMisses = timeIndexFinds(tree, misses, found);
+    if (found != 2 * hits.size()) cout << "Wrong lookups";
+    cout << "  tree: " << treeHits << " ns/hit, " << treeMisses
+         << " ns/miss; index: " << indexHits << " ns/hit, " << indexMisses
+         << " ns/miss" << endl;
+    cout << "  memory: nodes " << tree.size() * sizeof(BSTNode<Query>)
+         << " bytes, index " << tree.hashIndexBytes() << " bytes ("
+         << tree.hashIndexBytes() / tree.size() << " bytes/item)" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    const unsigned int NUM_QUERIES = 1000000;
+    const char* fileName = argc > 1 ? argv[1] : "data/actors.txt";
+    size_t maxKeys = argc > 2 ? stoull(argv[2]) : 10000000;
+    vector<string> shuffled = readNames(fileName);
+    if (shuffled.empty()) {
+        cout << "Could not read " << fileName << endl;
+        return -1;
+    }
+    shuffle(shuffled.begin(), shuffled.end(), mt19937(42));
+    vector<string> sorted = shuffled;
+    sort(sorted.begin(), sorted.end());
+    cout << "Number of names: " << sorted.size() << endl;
+
+    cout << "\nTest 1: sorted names" << endl;
+    {
+        BST<string> bst;
+        cout << "BST:" << endl;
+        insertAndFind(bst, sorted);
+    }
+    {
+        AVL<string> avl;
+        cout << "AVL:" << endl;
+        insertAndFind(avl, sorted);
+    }
+
+    cout << "\nTest 2: shuffled names" << endl;
+    {
+        BST<string> bst;
+        cout << "BST:" << endl;
+        insertAndFind(bst, shuffled);
+    }
+    {
+        AVL<string> avl;
+        cout << "AVL:" << endl;
+        insertAndFind(avl, shuffled);
+    }
+
+    cout << "\nTest 3: build from all names at once" << endl;
+    // a hundred numbered copies of every name for a larger input
+    vector<string> many;
+    for (const string& name : shuffled) {
+        for (int i = 0; i < 100; i++) many.push_back(name + " " + to_string(i));
+    }
+    vector<string> manySorted = many;
+    sort(manySorted.begin(), manySorted.end());
+    for (const vector<string>* input : {&shuffled, &many, &manySorted}) {
+        Timer t;
+        cout << input->size() << " names"
+             << (input == &manySorted ? ", sorted:" : ":") << endl;
+        {
+            AVL<string> avl;
+            t.begin_timer();
+            for (const string& name : *input) avl.insert(name);
+            long long insertTime = t.end_timer();
+            cout << "  AVL inserts: " << insertTime / 1000000 << " ms" << endl;
+        }
+        {
+            BST<string> bst;
+            t.begin_timer();
+            bst.build(input->begin(), input->end());
+            long long buildTime = t.end_timer();
+            cout << "  BST build:   " << buildTime / 1000000 << " ms, height "
+                 << bst.height() << endl;
+        }
+    }
+
+    cout << "\nTest 4: find, findBatch and find in a frozen snapshot" << endl;
+    mt19937 random(42);
+    for (size_t numKeys = 10000; numKeys <= maxKeys; numKeys *= 10) {
+        // every third number is a key, so that a third of the queries hit
+        vector<unsigned int> keys(numKeys);
+        for (size_t i = 0; i < numKeys; i++) keys[i] = 3 * i;
+        vector<unsigned int> queries(NUM_QUERIES);
+        for (unsigned int& query : queries) query = random() % (3 * numKeys);
+        BST<unsigned int> bst;
+        bst.build(keys.begin(), keys.end());
+        keys = vector<unsigned int>();
+        FrozenBST<unsigned int> frozen(bst);
+        cout << numKeys << " keys:" << endl;
+        cout << "  BST find:       " << timeFinds(bst, queries) << " ns"
+             << endl;
+        cout << "  BST findBatch:  " << timeFindBatch(bst, queries) << " ns"
+             << endl;
+        cout << "  FrozenBST find: " << timeFinds(frozen, queries) << " ns"
+             << endl;
+    }
+
+    cout << "\nTest 5: string lookups" << endl;
+    {
+        BST<string> bst;
+        bst.build(shuffled.begin(), shuffled.end());
+        vector<string> queries = shuffled;
+        vector<string> misses = shuffled;
+        // same long prefixes, but not in the tree
+        for (string& miss : misses) miss += ".";
+        queries.insert(queries.end(), misses.begin(), misses.end());
+        shuffle(queries.begin(), queries.end(), random);
+        timeStringFinds(bst, queries);
+    }
+
+    cout << "\nTest 6: read scaling with a writer" << endl;
+    unsigned int maxReaders = max(4u, thread::hardware_concurrency());
+    for (unsigned int numReaders = 1; numReaders <= maxReaders;
+         numReaders *= 2) {
+        ConcurrentBST<string> concurrent;
+        concurrent.build(shuffled.begin(), shuffled.end());
+        double lockFree = readScaling(
+            numReaders, shuffled,
+            [&](const string& name) {
+                return concurrent.find(name) != concurrent.end();
+            },
+            [&](const string& name) { concurrent.insert(name); });
+
+        BST<string> bst;
+        bst.build(shuffled.begin(), shuffled.end());
+        mutex lock;
+        double locked = readScaling(
+            numReaders, shuffled,
+            [&](const string& name) {
+                lock_guard<mutex> guard(lock);
+                return bst.find(name) != bst.end();
+            },
+            [&](const string& name) {
+                lock_guard<mutex> guard(lock);
+                bst.insert(name);
+            });
+        cout << numReaders << " readers:" << endl;
+        cout << "  ConcurrentBST: " << (long long)lockFree << " finds/s"
+             << endl;
+        cout << "  BST + mutex:   " << (long long)locked << " finds/s" << endl;
+    }
+
+    cout << "\nTest 7: pages of 50 names" << endl;
+    {
+        const unsigned int PAGE = 50;
+        const unsigned int NUM_PAGES = 1000;
+        BST<string> bst;
+        bst.build(shuffled.begin(), shuffled.end());
+        vector<unsigned int> starts(NUM_PAGES);
+        for (unsigned int& start : starts) {
+            start = random() % (bst.size() - PAGE);
+        }
+        Timer t;
+        size_t length = 0;
+        t.begin_timer();
+        for (unsigned int start : starts) {
+            auto it = bst.begin();
+            for (unsigned int i = 0; i < start; i++) ++it;
+            for (unsigned int i = 0; i < PAGE; i++, ++it) length += it->size();
+        }
+        long long walkTime = t.end_timer();
+        t.begin_timer();
+        for (unsigned int start : starts) {
+            auto it = bst.select(start);
+            for (unsigned int i = 0; i < PAGE; i++, ++it) length += it->size();
+        }
+        long long selectTime = t.end_timer();
+        if (length == 0) cout << "No names";
+        cout << "  walk from begin(): " << walkTime / NUM_PAGES << " ns/page"
+             << endl;
+        cout << "  select():          " << selectTime / NUM_PAGES
+             << " ns/page" << endl;
+    }
+    cout << "\nTest 8: type-ahead, 10 matches per keystroke" << endl;
+    {
+        const unsigned int LIMIT = 10;
+        BST<string> bst;
+        bst.build(shuffled.begin(), shuffled.end());
+        size_t numTyped = min<size_t>(1000, shuffled.size());
+        vector<string> typed(shuffled.begin(), shuffled.begin() + numTyped);
+        cout << "  prefixSearch(): ";
+        timeKeystrokes(typed, [&](const string& prefix) {
+            return bst.prefixSearch(prefix, LIMIT).size();
+        });
+        // the full scan is slow, type fewer names
+        typed.resize(min<size_t>(20, typed.size()));
+        cout << "  full scan:      ";
+        timeKeystrokes(typed, [&](const string& prefix) {
+            vector<string> matches;
+            for (const string& name : bst) {
+                if (matches.size() < LIMIT &&
+                    name.compare(0, prefix.size(), prefix) == 0) {
+                    matches.push_back(name);
+                }
+            }
+            return matches.size();
+        });
+    }
+    cout << "\nTest 9: set operations with a cast list of 1000 names" << endl;
+    {
+        const unsigned int CAST = 1000;
+        const unsigned int ROUNDS = 20;
+        size_t castSize = min<size_t>(CAST, shuffled.size());
+        vector<string> cast(shuffled.end() - castSize, shuffled.end());
+        // half of the cast is not in the names yet
+        for (size_t i = 0; i < castSize / 2; i++) cast[i] += " Jr.";
+        long long insertTime = 0, unionTime = 0;
+        long long findTime = 0, intersectionTime = 0;
+        size_t total = 0;
+        Timer t;
+        for (unsigned int round = 0; round < ROUNDS; round++) {
+            AVL<string> all;
+            AVL<string> castTree;
+            all.build(shuffled.begin(), shuffled.end());
+            castTree.build(cast.begin(), cast.end());
+            t.begin_timer();
+            for (const string& name : castTree) all.insert(name);
+            insertTime += t.end_timer();
+            all.build(shuffled.begin(), shuffled.end());
+            t.begin_timer();
+            all.setUnion(castTree);
+            unionTime += t.end_timer();
+            total += all.size();
+
+            all.build(shuffled.begin(), shuffled.end());
+            castTree.build(cast.begin(), cast.end());
+            AVL<string> common;
+            t.begin_timer();
+            for (const string& name : castTree) {
+                if (all.find(name) != all.end()) common.insert(name);
+            }
+            findTime += t.end_timer();
+            t.begin_timer();
+            castTree.setIntersection(all);
+            intersectionTime += t.end_timer();
+            if (castTree.size() != common.size()) cout << "Wrong intersection";
+        }
+        if (total == 0) cout << "No names";
+        cout << "  union, insert each: " << insertTime / ROUNDS / 1000
+             << " us, setUnion(): " << unionTime / ROUNDS / 1000 << " us"
+             << endl;
+        cout << "  intersection, find each: " << findTime / ROUNDS / 1000
+             << " us, setIntersection(): " << intersectionTime / ROUNDS / 1000
+             << " us (includes freeing the other names)" << endl;
+
+        // integer trees: one of 10^6 keys merged with m keys, m up to 10^6
+        size_t n = min<size_t>(maxKeys, 1000000);
+        mt19937 keys(3);
+        vector<unsigned int> big(n);
+        for (unsigned int& key : big) key = keys();
+        for (size_t m = 1000; m <= n; m *= 10) {
+            vector<unsigned int> small(m);
+            for (unsigned int& key : small) key = keys();
+            AVL<unsigned int> a;
+            AVL<unsigned int> b;
+            a.build(big.begin(), big.end());
+            b.build(small.begin(), small.end());
+            t.begin_timer();
+            for (unsigned int key : b) a.insert(key);
+            long long eachTime = t.end_timer();
+            a.build(big.begin(), big.end());
+            t.begin_timer();
+            a.setUnion(b, 1);
+            long long setTime = t.end_timer();
+            b.build(small.begin(), small.end());
+            a.build(big.begin(), big.end());
+            t.begin_timer();
+            a.setUnion(b);
+            long long threadsTime = t.end_timer();
+            cout << "  " << n << " with " << m << " keys, insert each: "
+                 << eachTime / m << " ns/key, setUnion(): " << setTime / m
+                 << " ns/key, on " << thread::hardware_concurrency()
+                 << " threads: " << threadsTime / m << " ns/key" << endl;
+        }
+    }
+    cout << "\nTest 10: Bloom filter in front of find" << endl;
+    {
+        const size_t NUM_LOOKUPS = 2000000;
+        BST<string> bst;
+        bst.build(shuffled.begin(), shuffled.end());
+        vector<string> hits(NUM_LOOKUPS);
+        vector<string> misses(NUM_LOOKUPS);
+        for (size_t i = 0; i < NUM_LOOKUPS; i++) {
+            hits[i] = shuffled[random() % shuffled.size()];
+            // mostly misses, one lookup in ten hits
+            misses[i] = hits[i];
+            if (i % 10 != 0) misses[i] += " Jr.";
+        }
+        timeFilteredFinds(bst, hits, "no filter, hits:");
+        timeFilteredFinds(bst, misses, "no filter, 90% misses:");
+        for (double rate : {0.01, 0.001}) {
+            bst.useFilter(rate);
+            string label = "filter at " + to_string(rate).substr(0, 5);
+            timeFilteredFinds(bst, hits, label + ", hits:");
+            timeFilteredFinds(bst, misses, label + ", 90% misses:");
+        }
+    }
+    cout << "\nTest 11: Zipf distributed lookups" << endl;
+    {
+        const size_t NUM_LOOKUPS = 2000000;
+        const unsigned int SPLAY_PERIOD = 32;
+        size_t numKeys = min<size_t>(maxKeys, 1000000);
+        vector<unsigned int> keys(numKeys);
+        for (size_t i = 0; i < numKeys; i++) keys[i] = i;
+        shuffle(keys.begin(), keys.end(), random);
+        for (double skew : {0.8, 1.0, 1.2}) {
+            // the most popular names are the first of shuffled
+            vector<string> names;
+            for (size_t i : zipfIndexes(shuffled.size(), skew, NUM_LOOKUPS,
+                                        random)) {
+                names.push_back(shuffled[i]);
+            }
+            vector<unsigned int> queries;
+            for (size_t i : zipfIndexes(numKeys, skew, NUM_LOOKUPS, random)) {
+                queries.push_back(keys[i]);
+            }
+            BST<string> bst;
+            AVL<string> avl;
+            SplayBST<string> splay;
+            SplayBST<string> periodic(SPLAY_PERIOD);
+            bst.build(shuffled.begin(), shuffled.end());
+            splay.build(shuffled.begin(), shuffled.end());
+            periodic.build(shuffled.begin(), shuffled.end());
+            for (const string& name : shuffled) avl.insert(name);
+            BST<unsigned int> keyBst;
+            SplayBST<unsigned int> keySplay;
+            SplayBST<unsigned int> keyPeriodic(SPLAY_PERIOD);
+            keyBst.build(keys.begin(), keys.end());
+            keySplay.build(keys.begin(), keys.end());
+            keyPeriodic.build(keys.begin(), keys.end());
+            cout << "  skew " << skew << ", names: balanced BST "
+                 << timeSkewedFinds(bst, names) << " ns, AVL "
+                 << timeSkewedFinds(avl, names) << " ns, splay "
+                 << timeSkewedFinds(splay, names) << " ns, splay 1/"
+                 << SPLAY_PERIOD << ": " << timeSkewedFinds(periodic, names)
+                 << " ns" << endl;
+            cout << "  skew " << skew << ", " << numKeys
+                 << " keys: balanced BST " << timeSkewedFinds(keyBst, queries)
+                 << " ns, splay " << timeSkewedFinds(keySplay, queries)
+                 << " ns, splay 1/" << SPLAY_PERIOD << ": "
+                 << timeSkewedFinds(keyPeriodic, queries) << " ns" << endl;
+        }
+    }
+    cout << "\nTest 12: full iteration, parent pointers and threads" << endl;
+    {
+        for (size_t numKeys = 10000; numKeys <= maxKeys; numKeys *= 10) {
+            unsigned int rounds = max<size_t>(1, 10000000 / numKeys);
+            vector<unsigned int> keys(numKeys);
+            for (size_t i = 0; i < numKeys; i++) keys[i] = 2 * i;
+            shuffle(keys.begin(), keys.end(), random);
+            BST<unsigned int> bst;
+            ThreadedBST<unsigned int> threaded;
+            // inserted in random order, the nodes are spread in memory
+            for (unsigned int key : keys) {
+                bst.insert(key);
+                threaded.insert(key);
+            }
+            BST<unsigned int> builtBst;
+            ThreadedBST<unsigned int> builtThreaded;
+            builtBst.build(keys.begin(), keys.end());
+            builtThreaded.build(keys.begin(), keys.end());
+            cout << "  " << numKeys << " keys, inserted: BST "
+                 << timeIteration(bst, rounds) << " ns/item, threaded "
+                 << timeIteration(threaded, rounds) << " ns/item; built: BST "
+                 << timeIteration(builtBst, rounds) << " ns/item, threaded "
+                 << timeIteration(builtThreaded, rounds) << " ns/item" << endl;
+        }
+    }
+    cout << "\nTest 13: find with a hash index" << endl;
+    {
+        const size_t NUM_LOOKUPS = 2000000;
+        BST<string> names;
+        names.build(shuffled.begin(), shuffled.end());
+        vector<string> hits(NUM_LOOKUPS);
+        vector<string> misses(NUM_LOOKUPS);
+        for (size_t i = 0; i < NUM_LOOKUPS; i++) {
+            hits[i] = shuffled[random() % shuffled.size()];
+            misses[i] = hits[i] + " Jr.";
+        }
+        cout << "  " << names.size() << " names" << endl;
+        compareHashIndex(names, hits, misses);
+
+        size_t numKeys = min<size_t>(maxKeys, 1000000);
+        vector<unsigned int> keys(numKeys);
+        for (size_t i = 0; i < numKeys; i++) keys[i] = 2 * i;
+        BST<unsigned int> bst;
+        bst.build(keys.begin(), keys.end());
+        vector<unsigned int> keyHits(NUM_LOOKUPS);
+        vector<unsigned int> keyMisses(NUM_LOOKUPS);
+        for (size_t i = 0; i < NUM_LOOKUPS; i++) {
+            keyHits[i] = keys[random() % numKeys];
+            keyMisses[i] = keyHits[i] + 1;
+        }
+        cout << "  " << numKeys << " integer keys" << endl;
+        compareHashIndex(bst, keyHits, keyMisses);
+    }
+    cout << "\nTest 14: load from text and from a snapshot" << endl;
+    {
+        string textFile = "/tmp/bstEfficiencyTest_names.txt";
+        string snapshotFile = "/tmp/bstEfficiencyTest_names.bin";
+        {
+            ofstream out(textFile, ios::binary);
+            for (const string& name : many) out << name << '\n';
+        }
+        Timer t;
+        t.begin_timer();
+        BST<string> bst;
+        for (const string& name : readNames(textFile.c_str())) {
+            bst.insert(name);
+        }
+        cout << "  " << bst.size() << " names, read and insert: "
+             << t.end_timer() / 1000000 << " ms" << endl;
+        t.begin_timer();
+        bool saved = saveSnapshot(bst, snapshotFile.c_str());
+        cout << "  save: " << t.end_timer() / 1000000 << " ms" << endl;
+        t.begin_timer();
+        BST<string> loaded;
+        bool opened = loadSnapshot(loaded, snapshotFile.c_str());
+        cout << "  loadSnapshot: " << t.end_timer() / 1000000 << " ms" << endl;
+        t.begin_timer();
+        BSTSnapshot snapshot;
+        bool mapped = snapshot.open(snapshotFile.c_str());
+        cout << "  BSTSnapshot::open: " << t.end_timer() / 1000 << " us"
+             << endl;
+        if (!saved || !opened || !mapped) cout << "Snapshot failed" << endl;
+
+        vector<string> queries(1000000);
+        for (string& query : queries) query = many[random() % many.size()];
+        size_t found = 0;
+        t.begin_timer();
+        for (const string& query : queries) {
+            if (loaded.find(query) != loaded.end()) found++;
+        }
+        long long treeTime = t.end_timer() / queries.size();
+        t.begin_timer();
+        for (const string& query : queries) {
+            if (snapshot.contains(query)) found++;
+        }
+        long long snapshotTime = t.end_timer() / queries.size();
+        if (found != 2 * queries.size()) cout << "Wrong lookups" << endl;
+        cout << "  find: balanced tree " << treeTime << " ns, snapshot "
+             << snapshotTime << " ns" << endl;
+        remove(textFile.c_str());
+        remove(snapshotFile.c_str());
+    }
+    return 0;
+}
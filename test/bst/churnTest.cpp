@@ -0,0 +1,92 @@
+/**
+ * Test erase and insert churn on BST and AVL trees: a tree of fixed size
+ * in which every step erases a random item and inserts a new one. Counts
+ * the calls to the global allocator during the churn, which should be none
+ * once erased nodes are reused by inserts.
+ *
+ * Usage: ./churnTest [number of items] [number of steps]
+ */
+
+#include <stdlib.h>
+#include <atomic>
+#include <iostream>
+#include <new>
+#include <random>
+#include <vector>
+
+#include "AVL.hpp"
+#include "BST.hpp"
+#include "Timer.hpp"
+
+using namespace std;
+
+// calls to the global operator new
+static atomic<unsigned long long> numAllocations(0);
+
+void* operator new(size_t size) {
+    numAllocations.fetch_add(1, memory_order_relaxed);
+    void* p = malloc(size == 0 ? 1 : size);
+    if (p == nullptr) throw bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+/** Fill tree with numItems keys, then erase a random key and insert a new
+ *  one numSteps times, printing the time and allocations per step
+ */
+void churn(BST<unsigned long long>& tree, unsigned int numItems,
+           unsigned int numSteps) {
+    mt19937_64 random(42);
+    vector<unsigned long long> keys(numItems);
+    for (unsigned long long& key : keys) {
+        do {
+            key = random();
+        } while (!tree.insert(key));
+    }
+    // queue of the keys to erase, allocated before the churn
+    keys.reserve(numItems + numSteps);
+
+    Timer t;
+    unsigned long long allocationsBefore = numAllocations.load();
+    t.begin_timer();
+    for (unsigned int step = 0; step < numSteps; step++) {
+        size_t victim = step + random() % numItems;
+        swap(keys[step], keys[victim]);
+        tree.erase(keys[step]);
+        unsigned long long key;
+        do {
+            key = random();
+        } while (!tree.insert(key));
+        keys.push_back(key);
+    }
+    long long churnTime = t.end_timer();
+    unsigned long long allocations = numAllocations.load() - allocationsBefore;
+    cout << "  size " << tree.size() << ", height " << tree.height() << endl;
+    cout << "  " << churnTime / numSteps << " ns per erase + insert, "
+         << allocations << " allocations in " << numSteps << " steps"
+         << endl;
+}
+
+int main(int argc, char* argv[]) {
+    unsigned int numItems = argc > 1 ? atoi(argv[1]) : 1000000;
+    unsigned int numSteps = argc > 2 ? atoi(argv[2]) : 1000000;
+    if (numItems == 0 || numSteps == 0) {
+        cout << "Usage: ./churnTest [number of items] [number of steps]"
+             << endl;
+        return -1;
+    }
+    cout << "BST:" << endl;
+    {
+        BST<unsigned long long> bst;
+        churn(bst, numItems, numSteps);
+    }
+    cout << "AVL:" << endl;
+    {
+        AVL<unsigned long long> avl;
+        churn(avl, numItems, numSteps);
+    }
+    return 0;
+}
@@ -4,6 +4,9 @@
  * prints if it was found in the BST.
  * An optional flag "-p" can be added. In this case, inorder and iterator
  * traversal with be performed to print the data in BST.
+ * The input file may also be a snapshot written by saveSnapshot(). It is
+ * then mapped and searched in place, without reading or inserting the
+ * strings, and only loaded into a tree to print it with "-p".
  *
  * Usage: ./main -p <input filename> <query filename>
  *
@@ -15,6 +18,7 @@
 #include <string>
 #include <vector>
 #include "BST.hpp"
+#include "BSTSnapshot.hpp"
 
 using namespace std;
 
@@ -62,36 +66,95 @@ bool argValid(int argc, char* argv[]) {
     return true;
 }
 
-/** Parse files to build BST and query vector */
-void parseFiles(BST<string>& bst, vector<string>& queryNames, char* argv[],
-                bool printFlag) {
+/** Parse the query file into query names */
+void parseQueries(const char* queryFile, vector<string>& queryNames) {
     ifstream in;
     string line;
-    // parse file for building BST
-    if (!printFlag) {
-        in.open(argv[1], ios::binary);
-    } else {
-        in.open(argv[2], ios::binary);
-    }
+    in.open(queryFile, ios::binary);
     while (!in.eof()) {
         getline(in, line);
         if (line.empty()) break;
-        bst.insert(line);
+        queryNames.push_back(line);
     }
     in.close();
+}
+
+/** Parse files to build BST and query vector
+ *  return false if the input file is a snapshot that cannot be read
+ */
+bool parseFiles(BST<string>& bst, vector<string>& queryNames, char* argv[],
+                bool printFlag) {
+    ifstream in;
+    string line;
+    // parse file for building BST, or load a snapshot of one
+    const char* inputFile = printFlag ? argv[2] : argv[1];
+    if (BSTSnapshot::isSnapshot(inputFile)) {
+        if (!loadSnapshot(bst, inputFile)) {
+            cout << "Invalid snapshot file " << inputFile
+                 << ". Please try again.\n";
+            return false;
+        }
+    } else {
+        in.open(inputFile, ios::binary);
+        while (!in.eof()) {
+            getline(in, line);
+            if (line.empty()) break;
+            bst.insert(line);
+        }
+        in.close();
+    }
 
     // parse file for query names
-    if (!printFlag) {
-        in.open(argv[2], ios::binary);
+    parseQueries(printFlag ? argv[3] : argv[2], queryNames);
+    return true;
+}
+
+/** Print the size, height and emptiness of a tree, then whether each of
+ *  the query names was found, found(name) telling if name is in the tree
+ */
+template <typename Found>
+void printFindResults(size_t size, int height,
+                      const vector<string>& queryNames, Found found) {
+    const int TRUC_LEN = 2;
+
+    cout << "Size of BST: " << size << endl;
+    cout << "Height of BST: " << height << endl;
+    cout << "BST is empty: ";
+    if (size == 0) {
+        cout << "true" << endl;
     } else {
-        in.open(argv[3], ios::binary);
+        cout << "false" << endl;
     }
-    while (!in.eof()) {
-        getline(in, line);
-        if (line.empty()) break;
-        queryNames.push_back(line);
+
+    string result = "";
+    for (const string& query : queryNames) {
+        if (found(query)) {
+            result += "found, ";
+        } else {
+            result += "not found, ";
+        }
     }
-    in.close();
+    result = result.substr(0, result.length() - TRUC_LEN);
+    cout << "Find results for query names: " << result << endl;
+}
+
+/** Answer the queries from the snapshot in snapshotFile, mapped and
+ *  searched in place. Return -1 if it cannot be read.
+ */
+int findInSnapshot(const char* snapshotFile, const char* queryFile) {
+    BSTSnapshot snapshot;
+    if (!snapshot.open(snapshotFile)) {
+        cout << "Invalid snapshot file " << snapshotFile
+             << ". Please try again.\n";
+        return -1;
+    }
+    vector<string> queryNames;
+    parseQueries(queryFile, queryNames);
+    printFindResults(snapshot.size(), snapshot.height(), queryNames,
+                     [&snapshot](const string& name) {
+                         return snapshot.contains(name);
+                     });
+    return 0;
 }
 
 int main(int argc, char* argv[]) {
@@ -105,32 +168,21 @@ int main(int argc, char* argv[]) {
     if (!argValid(argc, argv)) return -1;
     if (argc == NUM_ARG_FLAG) printFlag = true;
 
+    // a snapshot is searched where it lies unless it is to be printed
+    if (!printFlag && BSTSnapshot::isSnapshot(argv[1])) {
+        return findInSnapshot(argv[1], argv[2]);
+    }
+
     // parse files to build BST and query vector
     BST<string> tree = BST<string>();
     vector<string> queryNames;
-    parseFiles(tree, queryNames, argv, printFlag);
-
-    // print size, height, is empty
-    cout << "Size of BST: " << tree.size() << endl;
-    cout << "Height of BST: " << tree.height() << endl;
-    cout << "BST is empty: ";
-    if (tree.empty()) {
-        cout << "true" << endl;
-    } else {
-        cout << "false" << endl;
-    }
+    if (!parseFiles(tree, queryNames, argv, printFlag)) return -1;
 
-    // print find query results
-    result = "";
-    for (string& query : queryNames) {
-        if (tree.find(query) == tree.end()) {
-            result += "not found, ";
-        } else {
-            result += "found, ";
-        }
-    }
-    result = result.substr(0, result.length() - TRUC_LEN);
-    cout << "Find results for query names: " << result << endl;
+    // print size, height, is empty and find query results
+    printFindResults(tree.size(), tree.height(), queryNames,
+                     [&tree](const string& name) {
+                         return tree.find(name) != tree.end();
+                     });
 
     if (printFlag) {
         // print inorder traversal
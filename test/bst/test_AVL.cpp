@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "AVL.hpp"
+#include "util.hpp"
+
+using namespace std;
+using namespace testing;
+
+/** Expose the root of an AVL tree to check its shape */
+template <typename Data>
+class InspectableAVL : public AVL<Data> {
+  public:
+    BSTNode<Data>* getRoot() const { return this->root; }
+};
+
+/** Check the parent links, cached heights and sizes and the balance of
+ *  the subtree at n. Return its height.
+ */
+template <typename Data>
+int checkShape(BSTNode<Data>* n, BSTNode<Data>* parent) {
+    if (n == nullptr) return -1;
+    EXPECT_EQ(n->parent, parent);
+    int left = checkShape(n->left, n);
+    int right = checkShape(n->right, n);
+    EXPECT_LE(abs(left - right), 1);
+    EXPECT_EQ(n->height, max(left, right) + 1);
+    EXPECT_EQ(n->size, (n->left ? n->left->size : 0) +
+                           (n->right ? n->right->size : 0) + 1);
+    return n->height;
+}
+
+TEST(AVLTests, EMPTY_TREE_TEST) {
+    AVL<int> avl;
+    ASSERT_TRUE(avl.empty());
+    ASSERT_EQ(avl.height(), -1);
+    ASSERT_EQ(avl.find(1), avl.end());
+}
+
+TEST(AVLTests, SORTED_INSERT_TEST) {
+    // assert that sorted input gives a balanced tree, not a list
+    InspectableAVL<int> avl;
+    for (int i = 0; i < 1023; i++) {
+        ASSERT_TRUE(avl.insert(i));
+    }
+    ASSERT_EQ(avl.size(), 1023);
+    ASSERT_EQ(avl.height(), 9);
+    ASSERT_EQ(checkShape<int>(avl.getRoot(), nullptr), avl.height());
+    ASSERT_FALSE(avl.insert(512));
+    ASSERT_EQ(avl.size(), 1023);
+}
+
+TEST(AVLTests, ALL_ROTATION_CASES_TEST) {
+    // assert that the left-left, right-right, left-right and right-left
+    // cases all keep the order and the shape
+    vector<vector<int>> inputs{{3, 2, 1}, {1, 2, 3}, {3, 1, 2}, {1, 3, 2}};
+    for (vector<int>& input : inputs) {
+        InspectableAVL<int> avl;
+        insertIntoBST(input, avl);
+        ASSERT_EQ(avl.height(), 1);
+        EXPECT_EQ(*avl.begin(), 1);
+        EXPECT_EQ(avl.inorder(), vector<int>({1, 2, 3}));
+        checkShape<int>(avl.getRoot(), nullptr);
+    }
+}
+
+TEST(AVLTests, SHUFFLED_ACTORS_TEST) {
+    // assert that the tree matches a sorted set on the actor names
+    vector<string> names;
+    loadVectorFromFile("actors.txt", names);
+    shuffle(names.begin(), names.end(), mt19937(1));
+    InspectableAVL<string> avl;
+    insertIntoBST(names, avl);
+    set<string> expected(names.begin(), names.end());
+    ASSERT_EQ(avl.size(), expected.size());
+    ASSERT_EQ(checkShape<string>(avl.getRoot(), nullptr), avl.height());
+    // 1.44 log2(n) bounds the height of an AVL tree
+    EXPECT_LE(avl.height(), 1.44 * log2(avl.size()));
+
+    auto it = avl.begin();
+    for (const string& name : expected) {
+        ASSERT_NE(it, avl.end());
+        EXPECT_EQ(*it, name);
+        EXPECT_EQ(*avl.find(name), name);
+        ++it;
+    }
+    EXPECT_EQ(it, avl.end());
+    EXPECT_EQ(avl.find("Not An Actor"), avl.end());
+}
+
+TEST(AVLTests, ERASE_KEEPS_BALANCE_TEST) {
+    // assert that erasing half of a sorted input keeps the shape valid
+    InspectableAVL<int> avl;
+    for (int i = 0; i < 1000; i++) avl.insert(i);
+    for (int i = 0; i < 1000; i += 2) {
+        ASSERT_TRUE(avl.erase(i));
+        checkShape<int>(avl.getRoot(), nullptr);
+    }
+    ASSERT_EQ(avl.size(), 500);
+    EXPECT_LE(avl.height(), 1.44 * log2(avl.size()));
+    EXPECT_EQ(*avl.begin(), 1);
+    EXPECT_EQ(avl.rank(501), 250);
+}
+
+TEST(AVLTests, SET_OPERATIONS_KEEP_BALANCE_TEST) {
+    // assert that split, join and the set operations of AVL trees of
+    // very different sizes give balanced trees
+    mt19937 random(23);
+    for (int m : {1, 7, 100, 5000}) {
+        for (int op = 0; op < 3; op++) {
+            InspectableAVL<int> big;
+            InspectableAVL<int> small;
+            for (int i = 0; i < 5000; i++) big.insert(random() % 20000);
+            for (int i = 0; i < m; i++) small.insert(random() % 20000);
+            if (op == 0) small.setUnion(big);
+            if (op == 1) small.setIntersection(big);
+            if (op == 2) small.setDifference(big);
+            checkShape<int>(small.getRoot(), nullptr);
+        }
+        InspectableAVL<int> low;
+        InspectableAVL<int> high;
+        for (int i = 0; i < 5000; i++) low.insert(i);
+        for (int i = 0; i < m; i++) high.insert(10000 + i);
+        low.join(high);
+        checkShape<int>(low.getRoot(), nullptr);
+        high.join(low);
+        checkShape<int>(high.getRoot(), nullptr);
+        EXPECT_EQ(high.size(), 5000 + m);
+        EXPECT_TRUE(high.split(2500, low));
+        checkShape<int>(high.getRoot(), nullptr);
+        checkShape<int>(low.getRoot(), nullptr);
+        EXPECT_EQ(high.size(), 2500);
+        // the trees take inserts and erases like any other
+        high.insert(-1);
+        low.erase(10000);
+        checkShape<int>(high.getRoot(), nullptr);
+        checkShape<int>(low.getRoot(), nullptr);
+    }
+}
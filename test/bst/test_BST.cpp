@@ -1,11 +1,14 @@
 #include <algorithm>
+#include <cmath>
 #include <fstream>
 #include <iostream>
+#include <random>
 #include <set>
 #include <string>
 #include <vector>
 
 #include <gtest/gtest.h>
+#include "AVL.hpp"
 #include "BST.hpp"
 #include "util.hpp"
 
@@ -165,4 +168,478 @@ TEST_F(SmallBSTFixture, INORDER_TEST) {
     for (unsigned int i = 0; i < x.size(); i++) {
         EXPECT_EQ(x[i], y[i]);
     }
-}
\ No newline at end of file
+}
+TEST(BSTTests, SORTED_INSERT_HEIGHT_TEST) {
+    // assert that the cached height follows a degenerate tree
+    BST<int> bst;
+    for (int i = 0; i < 100; i++) {
+        bst.insert(i);
+        ASSERT_EQ(bst.height(), i);
+    }
+    ASSERT_FALSE(bst.insert(50));
+    ASSERT_EQ(bst.height(), 99);
+}
+
+TEST_F(BSTFixture, HEIGHT_AFTER_INSERTS_TEST) {
+    // assert that the height follows inserts deeper in the tree
+    ASSERT_EQ(bst_2.height(), 2);
+    bst_2.insert(-40);
+    bst_2.insert(-50);
+    ASSERT_EQ(bst_2.height(), 4);
+}
+
+/** Check the parent links and cached heights and sizes of the subtree at n.
+ *  Return its height.
+ */
+template <typename Data>
+int checkLinks(BSTNode<Data>* n, BSTNode<Data>* parent) {
+    if (n == nullptr) return -1;
+    EXPECT_EQ(n->parent, parent);
+    int height = max(checkLinks(n->left, n), checkLinks(n->right, n)) + 1;
+    EXPECT_EQ(n->height, height);
+    EXPECT_EQ(n->size, (n->left ? n->left->size : 0) +
+                           (n->right ? n->right->size : 0) + 1);
+    return height;
+}
+
+/** Expose the root of a BST to check its shape */
+template <typename Data>
+class InspectableBST : public BST<Data> {
+  public:
+    BSTNode<Data>* getRoot() const { return this->root; }
+};
+
+TEST(BSTTests, BUILD_UNSORTED_TEST) {
+    // assert that build sorts, drops duplicates and balances the tree
+    InspectableBST<int> bst;
+    bst.insert(1000);
+    vector<int> input{5, 3, 9, 3, 1, 7, 5, 5, 2, 8, 6, 4};
+    bst.build(input.begin(), input.end());
+    ASSERT_EQ(bst.size(), 9);
+    ASSERT_EQ(bst.height(), 3);
+    EXPECT_EQ(bst.inorder(), vector<int>({1, 2, 3, 4, 5, 6, 7, 8, 9}));
+    EXPECT_EQ(checkLinks<int>(bst.getRoot(), nullptr), 3);
+    EXPECT_EQ(bst.find(1000), bst.end());
+
+    // the built tree takes inserts like any other
+    ASSERT_TRUE(bst.insert(10));
+    ASSERT_FALSE(bst.insert(4));
+    EXPECT_EQ(checkLinks<int>(bst.getRoot(), nullptr), bst.height());
+}
+
+TEST(BSTTests, BUILD_SORTED_TEST) {
+    // assert that sorted input with duplicates gives a complete tree
+    InspectableBST<int> bst;
+    vector<int> input;
+    for (int i = 0; i < 1023; i++) {
+        input.push_back(i);
+        if (i % 10 == 0) input.push_back(i);
+    }
+    bst.build(input.begin(), input.end());
+    ASSERT_EQ(bst.size(), 1023);
+    ASSERT_EQ(bst.height(), 9);
+    checkLinks<int>(bst.getRoot(), nullptr);
+    int expected = 0;
+    for (auto it = bst.begin(); it != bst.end(); ++it) {
+        ASSERT_EQ(*it, expected++);
+    }
+    ASSERT_EQ(expected, 1023);
+}
+
+TEST(BSTTests, BUILD_EMPTY_TEST) {
+    // assert that an empty range empties the tree
+    BST<int> bst;
+    bst.insert(1);
+    vector<int> input;
+    bst.build(input.begin(), input.end());
+    ASSERT_TRUE(bst.empty());
+    ASSERT_EQ(bst.size(), 0);
+    ASSERT_EQ(bst.height(), -1);
+    ASSERT_EQ(bst.begin(), bst.end());
+}
+
+TEST(BSTTests, BUILD_PARALLEL_TEST) {
+    // assert that the threaded sort gives the same tree as std::set
+    vector<int> input;
+    mt19937 random(7);
+    for (int i = 0; i < 200000; i++) input.push_back(random() % 150000);
+    InspectableBST<int> bst;
+    bst.build(input.begin(), input.end(), 4);
+    set<int> expected(input.begin(), input.end());
+    ASSERT_EQ(bst.size(), expected.size());
+    EXPECT_EQ(bst.inorder(), vector<int>(expected.begin(), expected.end()));
+    checkLinks<int>(bst.getRoot(), nullptr);
+}
+
+TEST(BSTTests, BUILD_ACTORS_TEST) {
+    // assert that building from the actor names finds every name
+    vector<string> names;
+    loadVectorFromFile("actors.txt", names);
+    BST<string> bst;
+    bst.build(names.begin(), names.end());
+    set<string> expected(names.begin(), names.end());
+    ASSERT_EQ(bst.size(), expected.size());
+    for (const string& name : names) {
+        ASSERT_NE(bst.find(name), bst.end());
+    }
+}
+
+TEST_F(SmallBSTFixture, FIND_BATCH_TEST) {
+    // assert that batched lookups give the same iterators as find
+    vector<int> queries{100, 2, -33, 3, 5, 4, 1, 1, -34};
+    vector<BSTIterator<int>> results;
+    bst.findBatch(queries, results);
+    ASSERT_EQ(results.size(), queries.size());
+    for (unsigned int i = 0; i < queries.size(); i++) {
+        EXPECT_EQ(results[i], bst.find(queries[i]));
+    }
+}
+
+TEST(BSTTests, FIND_BATCH_EMPTY_TEST) {
+    // assert that nothing is found in an empty tree
+    BST<int> bst;
+    vector<int> queries{1, 2, 3};
+    vector<BSTIterator<int>> results;
+    bst.findBatch(queries, results);
+    ASSERT_EQ(results.size(), 3);
+    for (auto& result : results) EXPECT_EQ(result, bst.end());
+}
+
+TEST(BSTTests, FIND_BATCH_THREADS_TEST) {
+    // assert that a batch split across threads matches find
+    BST<int> bst;
+    vector<int> queries;
+    mt19937 random(3);
+    for (int i = 0; i < 20000; i++) bst.insert(random() % 100000);
+    for (int i = 0; i < 100000; i++) queries.push_back(random() % 100000);
+    vector<BSTIterator<int>> results;
+    bst.findBatch(queries, results, 4);
+    ASSERT_EQ(results.size(), queries.size());
+    for (unsigned int i = 0; i < queries.size(); i++) {
+        ASSERT_EQ(results[i], bst.find(queries[i]));
+    }
+}
+
+TEST_F(SmallBSTFixture, BOUNDS_TEST) {
+    // assert that bounds land on the right items of -33 1 3 4 100
+    EXPECT_EQ(*bst.lower_bound(-100), -33);
+    EXPECT_EQ(*bst.lower_bound(1), 1);
+    EXPECT_EQ(*bst.lower_bound(2), 3);
+    EXPECT_EQ(bst.lower_bound(101), bst.end());
+    EXPECT_EQ(*bst.upper_bound(1), 3);
+    EXPECT_EQ(*bst.upper_bound(2), 3);
+    EXPECT_EQ(bst.upper_bound(100), bst.end());
+
+    auto range = bst.equal_range(4);
+    EXPECT_EQ(*range.first, 4);
+    EXPECT_EQ(*range.second, 100);
+    range = bst.equal_range(5);
+    EXPECT_EQ(range.first, range.second);
+    EXPECT_EQ(*range.first, 100);
+}
+
+TEST_F(SmallBSTFixture, REVERSE_ITERATION_TEST) {
+    // assert that decrementing from end() visits the items backwards
+    vector<int> backwards;
+    auto it = bst.end();
+    while (it != bst.begin()) backwards.push_back(*--it);
+    EXPECT_EQ(backwards, vector<int>({100, 4, 3, 1, -33}));
+    vector<int> reversed(make_reverse_iterator(bst.end()),
+                         make_reverse_iterator(bst.begin()));
+    EXPECT_EQ(reversed, backwards);
+}
+
+TEST(BSTTests, SCAN_TEST) {
+    // assert that scan visits the names from A up to C
+    vector<string> names;
+    loadVectorFromFile("actors.txt", names);
+    BST<string> bst;
+    insertIntoBST(names, bst);
+    vector<string> scanned;
+    bst.scan("A", "C", [&](const string& name) { scanned.push_back(name); });
+    vector<string> expected;
+    for (const string& name : bst.inorder()) {
+        if (name >= "A" && name < "C") expected.push_back(name);
+    }
+    ASSERT_GT(expected.size(), 0);
+    EXPECT_EQ(scanned, expected);
+
+    scanned.clear();
+    bst.scan("C", "A", [&](const string& name) { scanned.push_back(name); });
+    EXPECT_TRUE(scanned.empty());
+}
+
+TEST_F(SmallBSTFixture, RANK_SELECT_TEST) {
+    // assert positions in -33 1 3 4 100
+    EXPECT_EQ(bst.rank(-100), 0);
+    EXPECT_EQ(bst.rank(-33), 0);
+    EXPECT_EQ(bst.rank(2), 2);
+    EXPECT_EQ(bst.rank(3), 2);
+    EXPECT_EQ(bst.rank(1000), 5);
+    EXPECT_EQ(*bst.select(0), -33);
+    EXPECT_EQ(*bst.select(2), 3);
+    EXPECT_EQ(*bst.select(4), 100);
+    EXPECT_EQ(bst.select(5), bst.end());
+    auto it = bst.select(3);
+    EXPECT_EQ(*++it, 100);
+}
+
+TEST(BSTTests, RANK_SELECT_ACTORS_TEST) {
+    // assert that rank and select agree with the sorted names, in a tree
+    // built by inserts and in a balanced AVL tree
+    vector<string> names;
+    loadVectorFromFile("actors.txt", names);
+    set<string> unique(names.begin(), names.end());
+    vector<string> sorted(unique.begin(), unique.end());
+    InspectableBST<string> bst;
+    insertIntoBST(names, bst);
+    AVL<string> avl;
+    insertIntoBST(names, avl);
+    checkLinks<string>(bst.getRoot(), nullptr);
+    for (unsigned int i = 0; i < sorted.size(); i++) {
+        ASSERT_EQ(bst.rank(sorted[i]), i);
+        ASSERT_EQ(*bst.select(i), sorted[i]);
+        ASSERT_EQ(avl.rank(sorted[i]), i);
+        ASSERT_EQ(*avl.select(i), sorted[i]);
+    }
+    // a page of 50 names from position 10000
+    auto it = avl.select(10000);
+    for (unsigned int i = 10000; i < 10050; i++, ++it) {
+        ASSERT_EQ(*it, sorted[i]);
+    }
+}
+
+TEST(BSTTests, PREFIX_SEARCH_TEST) {
+    // assert that matches come in order, up to the limit, and that
+    // prefixes longer than 8 bytes and strings equal to them match
+    BST<string> bst;
+    vector<string> words{"car",      "card",     "cardboard", "cardboards",
+                         "care",     "cars",     "cat",       "ca",
+                         "c",        "dog",      "cardboarx", "b"};
+    insertIntoBST(words, bst);
+    EXPECT_EQ(bst.prefixSearch("car", 100),
+              vector<string>({"car", "card", "cardboard", "cardboards",
+                              "cardboarx", "care", "cars"}));
+    EXPECT_EQ(bst.prefixSearch("car", 3),
+              vector<string>({"car", "card", "cardboard"}));
+    EXPECT_EQ(bst.prefixSearch("cardboard", 100),
+              vector<string>({"cardboard", "cardboards"}));
+    EXPECT_EQ(bst.prefixSearch("cardboards", 100),
+              vector<string>({"cardboards"}));
+    EXPECT_EQ(bst.prefixSearch("", 3), vector<string>({"b", "c", "ca"}));
+    EXPECT_TRUE(bst.prefixSearch("cb", 100).empty());
+    EXPECT_TRUE(bst.prefixSearch("e", 100).empty());
+    EXPECT_TRUE(bst.prefixSearch("car", 0).empty());
+    EXPECT_TRUE(BST<string>().prefixSearch("car", 10).empty());
+}
+
+TEST(BSTTests, PREFIX_SEARCH_ACTORS_TEST) {
+    // assert that every prefix of some names matches what a scan of the
+    // sorted names finds
+    vector<string> names;
+    loadVectorFromFile("actors.txt", names);
+    set<string> unique(names.begin(), names.end());
+    BST<string> bst;
+    bst.build(names.begin(), names.end());
+    for (unsigned int i = 0; i < names.size(); i += 997) {
+        for (size_t len = 0; len <= names[i].size(); len++) {
+            string prefix = names[i].substr(0, len);
+            vector<string> expected;
+            for (auto it = unique.lower_bound(prefix);
+                 it != unique.end() && expected.size() < 20 &&
+                 it->compare(0, len, prefix) == 0;
+                 ++it) {
+                expected.push_back(*it);
+            }
+            ASSERT_EQ(bst.prefixSearch(prefix, 20), expected);
+        }
+    }
+}
+
+TEST(BSTTests, ERASE_CASES_TEST) {
+    // erase from 3 (1 (-33, 2), 4): a leaf, a node with one child, the
+    // root with two children and a missing item
+    InspectableBST<int> bst;
+    vector<int> input{3, 4, 1, -33, 2, 10, 7};
+    insertIntoBST(input, bst);
+    ASSERT_TRUE(bst.erase(-33));
+    EXPECT_EQ(bst.inorder(), vector<int>({1, 2, 3, 4, 7, 10}));
+    ASSERT_TRUE(bst.erase(1));
+    EXPECT_EQ(bst.inorder(), vector<int>({2, 3, 4, 7, 10}));
+    ASSERT_TRUE(bst.erase(3));
+    EXPECT_EQ(bst.inorder(), vector<int>({2, 4, 7, 10}));
+    ASSERT_FALSE(bst.erase(3));
+    ASSERT_EQ(bst.size(), 4);
+    EXPECT_EQ(checkLinks<int>(bst.getRoot(), nullptr), bst.height());
+    EXPECT_EQ(bst.rank(7), 2);
+    // the successor two levels down replaces the root
+    ASSERT_TRUE(bst.erase(4));
+    EXPECT_EQ(bst.inorder(), vector<int>({2, 7, 10}));
+    EXPECT_EQ(checkLinks<int>(bst.getRoot(), nullptr), bst.height());
+}
+
+TEST_F(SmallBSTFixture, ERASE_ITERATOR_TEST) {
+    // assert that erase(iterator) returns the next item and that other
+    // iterators stay valid
+    auto four = bst.find(4);
+    auto it = bst.erase(bst.find(3));
+    EXPECT_EQ(it, four);
+    EXPECT_EQ(*it, 4);
+    it = bst.erase(bst.find(100));
+    EXPECT_EQ(it, bst.end());
+    EXPECT_EQ(*--it, 4);
+    EXPECT_EQ(bst.inorder(), vector<int>({-33, 1, 4}));
+}
+
+TEST(BSTTests, ERASE_REUSES_NODES_TEST) {
+    // assert that an insert after an erase reuses the erased node
+    BST<int> bst;
+    for (int i = 0; i < 10; i++) bst.insert(i);
+    const int* erased = &*bst.find(5);
+    bst.erase(5);
+    bst.insert(20);
+    EXPECT_EQ(&*bst.find(20), erased);
+    EXPECT_EQ(bst.size(), 10);
+}
+
+TEST(BSTTests, ERASE_CHURN_TEST) {
+    // assert that random erases and inserts keep the BST and the AVL
+    // tree equal to a set, with correct links, sizes and balance
+    mt19937 random(13);
+    InspectableBST<int> bst;
+    AVL<int> avl;
+    set<int> expected;
+    for (int i = 0; i < 20000; i++) {
+        int item = random() % 2000;
+        if (random() % 2) {
+            EXPECT_EQ(bst.insert(item), expected.insert(item).second);
+            avl.insert(item);
+        } else {
+            bool found = expected.erase(item) > 0;
+            EXPECT_EQ(bst.erase(item), found);
+            EXPECT_EQ(avl.erase(item), found);
+        }
+    }
+    ASSERT_EQ(bst.size(), expected.size());
+    ASSERT_EQ(avl.size(), expected.size());
+    vector<int> sorted(expected.begin(), expected.end());
+    EXPECT_EQ(bst.inorder(), sorted);
+    EXPECT_EQ(avl.inorder(), sorted);
+    EXPECT_EQ(checkLinks<int>(bst.getRoot(), nullptr), bst.height());
+    EXPECT_LE(avl.height(), 1.44 * log2(avl.size() + 2));
+
+    // erase everything through iterators
+    for (auto it = avl.begin(); it != avl.end();) it = avl.erase(it);
+    EXPECT_TRUE(avl.empty());
+    EXPECT_EQ(avl.height(), -1);
+}
+
+TEST(BSTTests, SPLIT_JOIN_TEST) {
+    // assert that splitting at present and missing items and joining the
+    // parts back gives the original items with correct links
+    vector<int> items;
+    for (int i = 0; i < 200; i += 2) items.push_back(i);
+    for (int key : {-1, 0, 51, 100, 198, 300}) {
+        InspectableBST<int> bst;
+        InspectableBST<int> greater;
+        greater.insert(1000);
+        bst.build(items.begin(), items.end());
+        bool present = key >= 0 && key < 200 && key % 2 == 0;
+        EXPECT_EQ(bst.split(key, greater), present);
+        vector<int> less;
+        vector<int> more;
+        for (int item : items) {
+            if (item < key) less.push_back(item);
+            if (item > key) more.push_back(item);
+        }
+        EXPECT_EQ(bst.inorder(), less);
+        EXPECT_EQ(greater.inorder(), more);
+        EXPECT_EQ(checkLinks<int>(bst.getRoot(), nullptr), bst.height());
+        EXPECT_EQ(checkLinks<int>(greater.getRoot(), nullptr),
+                  greater.height());
+        bst.join(greater);
+        EXPECT_TRUE(greater.empty());
+        EXPECT_EQ(bst.size(), items.size() - present);
+        EXPECT_EQ(checkLinks<int>(bst.getRoot(), nullptr), bst.height());
+        if (present) bst.insert(key);
+        EXPECT_EQ(bst.inorder(), items);
+    }
+}
+
+TEST(BSTTests, SET_OPERATIONS_TEST) {
+    // assert that union, intersection and difference of random sets of
+    // different sizes match the std algorithms
+    mt19937 random(17);
+    for (unsigned int m : {0u, 1u, 10u, 300u, 3000u}) {
+        set<int> a;
+        set<int> b;
+        while (a.size() < 3000) a.insert(random() % 10000);
+        while (b.size() < m) b.insert(random() % 10000);
+        vector<int> expected[3];
+        set_union(a.begin(), a.end(), b.begin(), b.end(),
+                  back_inserter(expected[0]));
+        set_intersection(a.begin(), a.end(), b.begin(), b.end(),
+                         back_inserter(expected[1]));
+        set_difference(a.begin(), a.end(), b.begin(), b.end(),
+                       back_inserter(expected[2]));
+        for (int op = 0; op < 3; op++) {
+            // both ways around for the symmetric operations
+            for (bool swapped : {false, true}) {
+                if (op == 2 && swapped) continue;
+                InspectableBST<int> trees[2];
+                for (int item : a) trees[0].insert(item);
+                for (int item : b) trees[1].insert(item);
+                InspectableBST<int>& first = trees[swapped];
+                InspectableBST<int>& second = trees[!swapped];
+                if (op == 0) first.setUnion(second);
+                if (op == 1) first.setIntersection(second);
+                if (op == 2) first.setDifference(second);
+                EXPECT_TRUE(second.empty());
+                EXPECT_EQ(first.inorder(), expected[op]);
+                EXPECT_EQ(first.size(), expected[op].size());
+                EXPECT_EQ(checkLinks<int>(first.getRoot(), nullptr),
+                          first.height());
+            }
+        }
+    }
+}
+
+TEST(BSTTests, SET_OPERATIONS_THREADS_TEST) {
+    // assert that the threaded operations on large trees give the same
+    // items as the std algorithms
+    mt19937 random(19);
+    vector<int> a(200000);
+    vector<int> b(100000);
+    for (int& item : a) item = random() % 1000000;
+    for (int& item : b) item = random() % 1000000;
+    set<int> setA(a.begin(), a.end());
+    set<int> setB(b.begin(), b.end());
+    vector<int> expected;
+    set_union(setA.begin(), setA.end(), setB.begin(), setB.end(),
+              back_inserter(expected));
+    InspectableBST<int> first;
+    InspectableBST<int> second;
+    first.build(a.begin(), a.end());
+    second.build(b.begin(), b.end());
+    first.setUnion(second, 4);
+    EXPECT_EQ(first.inorder(), expected);
+    EXPECT_EQ(checkLinks<int>(first.getRoot(), nullptr), first.height());
+
+    expected.clear();
+    set_intersection(setA.begin(), setA.end(), setB.begin(), setB.end(),
+                     back_inserter(expected));
+    first.build(a.begin(), a.end());
+    second.build(b.begin(), b.end());
+    first.setIntersection(second, 4);
+    EXPECT_EQ(first.inorder(), expected);
+    EXPECT_EQ(checkLinks<int>(first.getRoot(), nullptr), first.height());
+
+    expected.clear();
+    set_difference(setA.begin(), setA.end(), setB.begin(), setB.end(),
+                   back_inserter(expected));
+    first.build(a.begin(), a.end());
+    second.build(b.begin(), b.end());
+    first.setDifference(second, 4);
+    EXPECT_EQ(first.inorder(), expected);
+    EXPECT_EQ(checkLinks<int>(first.getRoot(), nullptr), first.height());
+}
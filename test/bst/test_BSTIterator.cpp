@@ -21,4 +21,34 @@ TEST(BST_ITERATOR_TEST, TEST_ITERATOR_INCREMENT) {
     iter++;
 
     ASSERT_EQ(iter, nullptr);
-}
\ No newline at end of file
+}
+TEST(BST_ITERATOR_TEST, TEST_ITERATOR_DECREMENT) {
+    // 2 <- 1 -> 3, iterate backwards from the largest
+    BSTNode<int> root(2);
+    BSTNode<int> left(1);
+    BSTNode<int> right(3);
+    root.left = &left;
+    root.right = &right;
+    left.parent = &root;
+    right.parent = &root;
+    BSTNode<int>* rootPtr = &root;
+
+    BSTIterator<int> end(nullptr, &rootPtr);
+    BSTIterator<int> iter = end;
+    --iter;
+    ASSERT_EQ(*iter, 3);
+    ASSERT_EQ(*iter--, 3);
+    ASSERT_EQ(*iter, 2);
+    --iter;
+    ASSERT_EQ(*iter, 1);
+    --iter;
+    ASSERT_EQ(iter, nullptr);
+}
+
+TEST(BST_ITERATOR_TEST, TEST_ITERATOR_REFERENCE) {
+    // dereferencing gives the data in the node, not a copy
+    BSTNode<string> node("Bacon, Kevin");
+    BSTIterator<string> iter(&node);
+    ASSERT_EQ(&*iter, &node.data);
+    ASSERT_EQ(iter->size(), 12);
+}
@@ -14,4 +14,17 @@ using namespace testing;
 TEST(BST_NODE_TESTS, TEST_SUCCESSOR) {
     BSTNode<int> node(3);
     ASSERT_EQ(node.successor(), nullptr);
-}
\ No newline at end of file
+}
+TEST(BST_NODE_TESTS, TEST_PREDECESSOR) {
+    // 2 <- 1 -> 3: predecessors go back through the parent
+    BSTNode<int> root(2);
+    BSTNode<int> left(1);
+    BSTNode<int> right(3);
+    root.left = &left;
+    root.right = &right;
+    left.parent = &root;
+    right.parent = &root;
+    ASSERT_EQ(right.predecessor(), &root);
+    ASSERT_EQ(root.predecessor(), &left);
+    ASSERT_EQ(left.predecessor(), nullptr);
+}
@@ -0,0 +1,138 @@
+#include <unistd.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "BST.hpp"
+#include "BSTSnapshot.hpp"
+#include "util.hpp"
+
+using namespace std;
+using namespace testing;
+
+class BSTSnapshotFixture : public ::testing::Test {
+  protected:
+    string fileName;
+
+  public:
+    BSTSnapshotFixture() {
+        fileName = "/tmp/bst_snapshot_test_" + to_string(getpid()) + ".bin";
+    }
+
+    ~BSTSnapshotFixture() { remove(fileName.c_str()); }
+};
+
+TEST_F(BSTSnapshotFixture, SAVE_OPEN_TEST) {
+    // assert that a mapped snapshot finds exactly the items of the tree,
+    // including strings that share their first 8 bytes or hold zero bytes
+    vector<string> items{"Kevin Bacon", "Kevin Bacon Jr.", "Kevin",
+                         "",            string("a\0b", 3), "a",
+                         "Zoe",         "Kevin Bacom"};
+    BST<string> bst;
+    insertIntoBST(items, bst);
+    ASSERT_TRUE(saveSnapshot(bst, fileName.c_str()));
+    ASSERT_TRUE(BSTSnapshot::isSnapshot(fileName.c_str()));
+
+    BSTSnapshot snapshot;
+    ASSERT_TRUE(snapshot.open(fileName.c_str()));
+    ASSERT_EQ(snapshot.size(), bst.size());
+    EXPECT_EQ(snapshot.inorder(), bst.inorder());
+    for (const string& item : items) {
+        EXPECT_TRUE(snapshot.contains(item)) << item;
+        EXPECT_EQ(snapshot.rank(item.data(), item.size()), bst.rank(item));
+    }
+    for (string miss : {"Kevin Bacon J", "Kevin Bacon Jr.!", "b", "A",
+                        "Kevin Baco"}) {
+        EXPECT_FALSE(snapshot.contains(miss)) << miss;
+        EXPECT_EQ(snapshot.rank(miss.data(), miss.size()), bst.rank(miss));
+    }
+    EXPECT_FALSE(snapshot.contains(string("a\0", 2)));
+    EXPECT_EQ(snapshot.prefixSearch("Kevin Bac", 10),
+              bst.prefixSearch("Kevin Bac", 10));
+    EXPECT_EQ(snapshot.prefixSearch("Kevin", 2),
+              (vector<string>{"Kevin", "Kevin Bacom"}));
+}
+
+TEST_F(BSTSnapshotFixture, BST_OPEN_TEST) {
+    // assert that loadSnapshot loads a balanced copy of the saved tree, and
+    // that a file that is not a snapshot leaves the tree unchanged
+    vector<string> names;
+    loadVectorFromFile("actors.txt", names);
+    BST<string> bst;
+    insertIntoBST(names, bst);
+    ASSERT_TRUE(saveSnapshot(bst, fileName.c_str()));
+
+    BST<string> loaded;
+    ASSERT_TRUE(loadSnapshot(loaded, fileName.c_str()));
+    EXPECT_EQ(loaded.inorder(), bst.inorder());
+    int minHeight = 0;
+    while ((2u << minHeight) <= loaded.size()) minHeight++;
+    EXPECT_EQ(loaded.height(), minHeight);
+
+    BSTSnapshot snapshot;
+    ASSERT_TRUE(snapshot.open(fileName.c_str()));
+    EXPECT_EQ(snapshot.height(), minHeight);
+    for (const string& name : names) {
+        ASSERT_TRUE(snapshot.contains(name)) << name;
+        ASSERT_FALSE(snapshot.contains(name + " ")) << name;
+    }
+
+    ofstream out(fileName, ios::binary | ios::trunc);
+    out << "Kevin Bacon\n";
+    out.close();
+    EXPECT_FALSE(BSTSnapshot::isSnapshot(fileName.c_str()));
+    EXPECT_FALSE(loadSnapshot(loaded, fileName.c_str()));
+    EXPECT_EQ(loaded.size(), bst.size());
+    EXPECT_FALSE(snapshot.open(fileName.c_str()));
+    EXPECT_TRUE(snapshot.empty());
+}
+
+TEST_F(BSTSnapshotFixture, EMPTY_AND_TRUNCATED_TEST) {
+    // assert that an empty tree round trips and a cut file is refused
+    BST<string> bst;
+    ASSERT_TRUE(saveSnapshot(bst, fileName.c_str()));
+    BSTSnapshot snapshot;
+    ASSERT_TRUE(snapshot.open(fileName.c_str()));
+    EXPECT_TRUE(snapshot.empty());
+    EXPECT_EQ(snapshot.height(), -1);
+    EXPECT_FALSE(snapshot.contains(""));
+    EXPECT_TRUE(snapshot.prefixSearch("", 5).empty());
+
+    bst.insert("Kevin Bacon");
+    bst.insert("Meryl Streep");
+    ASSERT_TRUE(saveSnapshot(bst, fileName.c_str()));
+    ASSERT_EQ(truncate(fileName.c_str(), 60), 0);
+    EXPECT_FALSE(snapshot.open(fileName.c_str()));
+}
+
+/** Overwrite the 8 bytes at offset of fileName with value */
+void patchWord(const string& fileName, size_t offset, uint64_t value) {
+    fstream file(fileName, ios::binary | ios::in | ios::out);
+    file.seekp(offset);
+    file.write((const char*)&value, sizeof(value));
+}
+
+TEST_F(BSTSnapshotFixture, CORRUPT_TABLES_TEST) {
+    // assert that offsets out of order or past the blob, and nodes naming
+    // no string, are refused instead of read outside the mapping
+    BST<string> bst;
+    bst.insert("Kevin Bacon");
+    bst.insert("Meryl Streep");
+    bst.insert("Tom Hanks");
+    // header, then 3 nodes of 16 bytes, then 4 offsets
+    const size_t OFFSETS = sizeof(SnapshotHeader) + 3 * 16;
+    BSTSnapshot snapshot;
+    for (int corruption = 0; corruption < 4; corruption++) {
+        ASSERT_TRUE(saveSnapshot(bst, fileName.c_str()));
+        ASSERT_TRUE(snapshot.open(fileName.c_str()));
+        snapshot.close();
+        if (corruption == 0) patchWord(fileName, OFFSETS + 8, 1000);
+        if (corruption == 1) patchWord(fileName, OFFSETS + 16, 5);
+        if (corruption == 2) patchWord(fileName, OFFSETS, 5);
+        if (corruption == 3) patchWord(fileName, sizeof(SnapshotHeader) + 8, 3);
+        EXPECT_FALSE(snapshot.open(fileName.c_str())) << corruption;
+        EXPECT_TRUE(snapshot.empty());
+    }
+}
@@ -0,0 +1,151 @@
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "AVL.hpp"
+#include "BST.hpp"
+#include "BloomFilter.hpp"
+#include "SplayBST.hpp"
+#include "util.hpp"
+
+using namespace std;
+using namespace testing;
+
+TEST(BloomFilterTests, NO_FALSE_NEGATIVES_TEST) {
+    // assert that every added hash is found
+    BloomFilter filter(10000, 0.01);
+    mt19937_64 random(3);
+    vector<uint64_t> hashes(10000);
+    for (uint64_t& hash : hashes) {
+        hash = random();
+        filter.add(hash);
+    }
+    for (uint64_t hash : hashes) ASSERT_TRUE(filter.mayContain(hash));
+    EXPECT_EQ(filter.size(), hashes.size());
+    filter.clear();
+    EXPECT_EQ(filter.size(), 0);
+}
+
+TEST(BloomFilterTests, FALSE_POSITIVE_RATE_TEST) {
+    // assert that a full filter keeps close to its false positive rate
+    for (double rate : {0.1, 0.01, 0.001}) {
+        BloomFilter filter(50000, rate);
+        for (int i = 0; i < 50000; i++) filter.add(keyHash(i));
+        int positives = 0;
+        const int NUM_MISSES = 200000;
+        for (int i = 50000; i < 50000 + NUM_MISSES; i++) {
+            if (filter.mayContain(keyHash(i))) positives++;
+        }
+        EXPECT_LE(positives, 1.5 * rate * NUM_MISSES) << "rate " << rate;
+    }
+}
+
+TEST(BloomFilterTests, STRING_HASH_TEST) {
+    // assert that strings hash like char buffers of the same text, and
+    // that every length of tail bytes is hashed
+    string text = "Zeta-Jones, Catherine";
+    for (size_t len = 0; len <= text.size(); len++) {
+        string s = text.substr(0, len);
+        EXPECT_EQ(keyHash(s), hashBytes(text.data(), len));
+        if (len > 0) {
+            EXPECT_NE(keyHash(s), keyHash(text.substr(0, len - 1)));
+        }
+    }
+}
+
+TEST(BloomFilterTests, BST_FIND_TEST) {
+    // assert that find with a filter finds exactly the items, through
+    // inserts that grow the filter, erases, build and the set operations
+    mt19937 random(11);
+    BST<int> bst;
+    AVL<int> avl;
+    set<int> expected;
+    bst.useFilter(0.01);
+    avl.useFilter(0.01);
+    for (int i = 0; i < 20000; i++) {
+        int item = random() % 10000;
+        if (random() % 4) {
+            bst.insert(item);
+            avl.insert(item);
+            expected.insert(item);
+        } else {
+            bst.erase(item);
+            avl.erase(item);
+            expected.erase(item);
+        }
+    }
+    for (int i = -10; i < 10010; i++) {
+        bool found = expected.count(i) > 0;
+        ASSERT_EQ(bst.find(i) != bst.end(), found);
+        ASSERT_EQ(avl.find(i) != avl.end(), found);
+    }
+
+    BST<int> other;
+    vector<int> items;
+    for (int i = 10000; i < 30000; i += 3) items.push_back(i);
+    other.build(items.begin(), items.end());
+    avl.setUnion(other);
+    expected.insert(items.begin(), items.end());
+    BST<int> greater;
+    greater.useFilter(0.01);
+    greater.insert(-5);
+    bst.build(expected.begin(), expected.end());
+    bst.split(20000, greater);
+    for (int i = -10; i < 30010; i++) {
+        bool found = expected.count(i) > 0;
+        ASSERT_EQ(avl.find(i) != avl.end(), found);
+        ASSERT_EQ(bst.find(i) != bst.end(), found && i < 20000);
+        ASSERT_EQ(greater.find(i) != greater.end(), found && i > 20000);
+    }
+    bst.useFilter(0);
+    EXPECT_NE(bst.find(*expected.begin()), bst.end());
+}
+
+TEST(BloomFilterTests, STRING_FIND_TEST) {
+    // assert that names and char buffers are found through the filter
+    vector<string> names;
+    loadVectorFromFile("actors.txt", names);
+    BST<string> bst;
+    bst.useFilter(0.01);
+    insertIntoBST(names, bst);
+    for (const string& name : names) {
+        ASSERT_NE(bst.find(name), bst.end());
+        ASSERT_NE(bst.find(name.data(), name.size()), bst.end());
+        string miss = name + " Jr.";
+        ASSERT_EQ(bst.find(miss), bst.end());
+        ASSERT_EQ(bst.find(miss.c_str()), bst.end());
+    }
+}
+
+/** Key with operator< and nothing else, so it has no KeyHash */
+struct OrderOnlyKey {
+    int value;
+    bool operator<(const OrderOnlyKey& other) const {
+        return value < other.value;
+    }
+};
+
+TEST(BloomFilterTests, UNHASHED_KEY_TEST) {
+    // assert that trees of keys without a hash still compile and work,
+    // with the filter and the index compiled out
+    BST<OrderOnlyKey> bst;
+    AVL<OrderOnlyKey> avl;
+    SplayBST<OrderOnlyKey> splay;
+    for (int i = 0; i < 100; i++) {
+        bst.insert({i * 3});
+        avl.insert({i * 3});
+        splay.insert({i * 3});
+    }
+    EXPECT_TRUE(bst.erase({30}));
+    for (int i = 0; i < 300; i++) {
+        bool in = i % 3 == 0 && i != 30;
+        ASSERT_EQ(bst.find({i}) != bst.end(), in);
+        ASSERT_EQ(avl.find({i}) != avl.end(), i % 3 == 0);
+        ASSERT_EQ(splay.find({i}) != splay.end(), i % 3 == 0);
+    }
+    BST<OrderOnlyKey> greater;
+    EXPECT_TRUE(avl.split({150}, greater));
+    EXPECT_EQ(avl.size() + greater.size(), 99);
+}
@@ -0,0 +1,120 @@
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "ConcurrentBST.hpp"
+#include "util.hpp"
+
+using namespace std;
+using namespace testing;
+
+TEST(ConcurrentBSTTests, EMPTY_TREE_TEST) {
+    ConcurrentBST<int> bst;
+    ASSERT_TRUE(bst.empty());
+    ASSERT_EQ(bst.height(), -1);
+    ASSERT_EQ(bst.begin(), bst.end());
+    ASSERT_EQ(bst.find(1), bst.end());
+}
+
+TEST(ConcurrentBSTTests, SMALL_TREE_TEST) {
+    // assert that the tree behaves like BST with one thread
+    ConcurrentBST<int> bst;
+    for (int item : {3, 4, 1, 100, -33}) ASSERT_TRUE(bst.insert(item));
+    ASSERT_FALSE(bst.insert(3));
+    ASSERT_EQ(bst.size(), 5);
+    ASSERT_EQ(bst.height(), 2);
+    EXPECT_EQ(bst.inorder(), vector<int>({-33, 1, 3, 4, 100}));
+    auto it = bst.find(1);
+    EXPECT_EQ(*it++, 1);
+    EXPECT_EQ(*it, 3);
+    EXPECT_EQ(bst.find(2), bst.end());
+}
+
+TEST(ConcurrentBSTTests, BUILD_BALANCED_TEST) {
+    // assert that build gives a balanced tree from sorted input
+    vector<string> names;
+    loadVectorFromFile("actors_sorted.txt", names);
+    ConcurrentBST<string> bst;
+    bst.build(names.begin(), names.end());
+    set<string> expected(names.begin(), names.end());
+    ASSERT_EQ(bst.size(), expected.size());
+    EXPECT_LE(bst.height(), 14);
+    EXPECT_EQ(bst.inorder(), vector<string>(expected.begin(), expected.end()));
+    for (const string& name : names) {
+        ASSERT_EQ(*bst.find(name.c_str()), name);
+    }
+}
+
+TEST(ConcurrentBSTTests, READERS_DURING_INSERTS_STRESS_TEST) {
+    // assert that readers running during inserts find every item inserted
+    // before they looked, and always iterate in strictly increasing order
+    const int NUM_ITEMS = 200000;
+    const int NUM_READERS = 4;
+    vector<int> items(NUM_ITEMS);
+    for (int i = 0; i < NUM_ITEMS; i++) items[i] = 2 * i;
+    shuffle(items.begin(), items.end(), mt19937(11));
+
+    ConcurrentBST<int> bst;
+    atomic<int> inserted(0);
+    atomic<bool> done(false);
+    atomic<long long> errors(0);
+    vector<thread> readers;
+    for (int r = 0; r < NUM_READERS; r++) {
+        readers.emplace_back([&, r] {
+            mt19937 random(r);
+            int round = 0;
+            while (!done.load()) {
+                int count = inserted.load();
+                for (int i = 0; i < 1000 && count > 0; i++) {
+                    int item = items[random() % count];
+                    auto it = bst.find(item);
+                    if (it == bst.end() || *it != item) errors++;
+                    // odd items are never inserted
+                    if (bst.find(item + 1) != bst.end()) errors++;
+                }
+                if (round++ % 50 == 0) {
+                    int previous = -1;
+                    int seen = 0;
+                    for (int item : bst.inorder()) {
+                        if (item <= previous) errors++;
+                        previous = item;
+                        seen++;
+                    }
+                    if (seen < count) errors++;
+                }
+            }
+        });
+    }
+    for (int item : items) {
+        bst.insert(item);
+        inserted.store(inserted.load() + 1);
+    }
+    done.store(true);
+    for (thread& reader : readers) reader.join();
+
+    EXPECT_EQ(errors.load(), 0);
+    ASSERT_EQ(bst.size(), (unsigned)NUM_ITEMS);
+    sort(items.begin(), items.end());
+    EXPECT_EQ(bst.inorder(), items);
+}
+
+TEST(ConcurrentBSTTests, CONCURRENT_WRITERS_TEST) {
+    // assert that inserts from several threads are serialized
+    ConcurrentBST<int> bst;
+    vector<thread> writers;
+    for (int w = 0; w < 4; w++) {
+        writers.emplace_back([&bst, w] {
+            mt19937 random(w);
+            for (int i = 0; i < 20000; i++) bst.insert(random() % 50000);
+        });
+    }
+    for (thread& writer : writers) writer.join();
+    vector<int> items = bst.inorder();
+    ASSERT_EQ(items.size(), bst.size());
+    EXPECT_TRUE(is_sorted(items.begin(), items.end()));
+    EXPECT_EQ(adjacent_find(items.begin(), items.end()), items.end());
+}
@@ -0,0 +1,75 @@
+#include <algorithm>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "BST.hpp"
+#include "FrozenBST.hpp"
+#include "util.hpp"
+
+using namespace std;
+using namespace testing;
+
+TEST(FrozenBSTTests, EMPTY_TEST) {
+    BST<int> bst;
+    FrozenBST<int> frozen(bst);
+    ASSERT_TRUE(frozen.empty());
+    ASSERT_EQ(frozen.begin(), frozen.end());
+    ASSERT_EQ(frozen.find(3), frozen.end());
+    ASSERT_EQ(frozen.lower_bound(3), frozen.end());
+}
+
+TEST(FrozenBSTTests, ALL_SIZES_TEST) {
+    // assert that iteration and search work for complete and incomplete
+    // last levels
+    for (int n = 1; n <= 70; n++) {
+        BST<int> bst;
+        for (int i = 0; i < n; i++) bst.insert(2 * i);
+        FrozenBST<int> frozen(bst);
+        ASSERT_EQ(frozen.size(), (size_t)n);
+
+        vector<int> items(frozen.begin(), frozen.end());
+        ASSERT_EQ(items, bst.inorder());
+        for (int i = 0; i < n; i++) {
+            ASSERT_EQ(*frozen.find(2 * i), 2 * i);
+            ASSERT_EQ(frozen.find(2 * i + 1), frozen.end());
+            ASSERT_EQ(*frozen.lower_bound(2 * i - 1), 2 * i);
+        }
+        ASSERT_EQ(frozen.lower_bound(2 * n), frozen.end());
+    }
+}
+
+TEST(FrozenBSTTests, ITERATE_FROM_FIND_TEST) {
+    // assert that iterating from a found item follows the BST order
+    BST<int> bst;
+    vector<int> input{3, 4, 1, 100, -33};
+    insertIntoBST(input, bst);
+    FrozenBST<int> frozen(bst);
+    auto it = frozen.find(1);
+    EXPECT_EQ(*it++, 1);
+    EXPECT_EQ(*it, 3);
+    EXPECT_EQ(*++it, 4);
+    EXPECT_EQ(*++it, 100);
+    EXPECT_EQ(++it, frozen.end());
+}
+
+TEST(FrozenBSTTests, ACTORS_TEST) {
+    // assert that every actor name is found and others are not
+    vector<string> names;
+    loadVectorFromFile("actors.txt", names);
+    BST<string> bst;
+    bst.build(names.begin(), names.end());
+    FrozenBST<string> frozen(bst);
+    ASSERT_EQ(frozen.size(), bst.size());
+    for (const string& name : names) {
+        ASSERT_EQ(*frozen.find(name), name);
+    }
+    vector<string> queries;
+    loadVectorFromFile("queryActors.txt", queries);
+    for (const string& query : queries) {
+        EXPECT_EQ(frozen.find(query) == frozen.end(),
+                  bst.find(query) == bst.end());
+    }
+}
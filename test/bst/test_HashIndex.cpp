@@ -0,0 +1,122 @@
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "AVL.hpp"
+#include "BST.hpp"
+#include "HashIndex.hpp"
+#include "SplayBST.hpp"
+#include "util.hpp"
+
+using namespace std;
+using namespace testing;
+
+TEST(HashIndexTests, INSERT_FIND_ERASE_TEST) {
+    // assert that nodes are found until erased, through growing and
+    // through erases that move other items back in their runs
+    vector<BSTNode<int>*> nodes;
+    for (int i = 0; i < 5000; i++) nodes.push_back(new BSTNode<int>(i * 7));
+    HashIndex<int> index;
+    for (BSTNode<int>* node : nodes) index.insert(node);
+    ASSERT_EQ(index.size(), nodes.size());
+    for (int i = 0; i < 5000; i++) {
+        ASSERT_EQ(index.find(SearchKey<int>(i * 7), keyHash(i * 7)), nodes[i]);
+        ASSERT_EQ(index.find(SearchKey<int>(i * 7 + 1), keyHash(i * 7 + 1)),
+                  nullptr);
+    }
+    for (int i = 0; i < 5000; i += 3) index.erase(nodes[i]);
+    for (int i = 0; i < 5000; i++) {
+        BSTNode<int>* expected = i % 3 == 0 ? nullptr : nodes[i];
+        ASSERT_EQ(index.find(SearchKey<int>(i * 7), keyHash(i * 7)), expected);
+    }
+    EXPECT_EQ(index.size(), 3333);
+    EXPECT_GE(index.bytes(), 3333 * 9);
+    index.clear();
+    EXPECT_EQ(index.size(), 0);
+    EXPECT_EQ(index.find(SearchKey<int>(7), keyHash(7)), nullptr);
+    for (BSTNode<int>* node : nodes) delete node;
+}
+
+TEST(HashIndexTests, BST_FIND_TEST) {
+    // assert that find through the index gives the same iterators as the
+    // tree, through inserts, erases, build and the set operations
+    mt19937 random(37);
+    BST<int> bst;
+    AVL<int> avl;
+    BST<int> plain;
+    bst.useHashIndex(true);
+    avl.useHashIndex(true);
+    set<int> expected;
+    for (int i = 0; i < 30000; i++) {
+        int item = random() % 5000;
+        if (random() % 3) {
+            bst.insert(item);
+            avl.insert(item);
+            plain.insert(item);
+            expected.insert(item);
+        } else {
+            bst.erase(item);
+            avl.erase(item);
+            plain.erase(item);
+            expected.erase(item);
+        }
+    }
+    for (int i = -1; i <= 5000; i++) {
+        auto it = bst.find(i);
+        ASSERT_EQ(it != bst.end(), expected.count(i) > 0);
+        if (it != bst.end()) {
+            ASSERT_EQ(*it, i);
+            // the iterator walks the tree like any other
+            auto next = it;
+            ++next;
+            auto expectedNext = expected.upper_bound(i);
+            ASSERT_EQ(next == bst.end(), expectedNext == expected.end());
+        }
+        ASSERT_EQ(avl.find(i) != avl.end(), expected.count(i) > 0);
+    }
+
+    BST<int> other;
+    vector<int> items{-5, 100, 6000, 7000};
+    other.build(items.begin(), items.end());
+    bst.setUnion(other);
+    expected.insert(items.begin(), items.end());
+    BST<int> greater;
+    greater.useHashIndex(true);
+    avl.build(expected.begin(), expected.end());
+    avl.split(3000, greater);
+    for (int i = -10; i <= 7000; i++) {
+        bool found = expected.count(i) > 0;
+        ASSERT_EQ(bst.find(i) != bst.end(), found);
+        ASSERT_EQ(avl.find(i) != avl.end(), found && i < 3000);
+        ASSERT_EQ(greater.find(i) != greater.end(), found && i > 3000);
+    }
+    bst.clear();
+    EXPECT_EQ(bst.find(100), bst.end());
+    bst.insert(100);
+    EXPECT_EQ(*bst.find(100), 100);
+    bst.useHashIndex(false);
+    EXPECT_EQ(*bst.find(100), 100);
+}
+
+TEST(HashIndexTests, STRING_FIND_TEST) {
+    // assert that names and char buffers are found through the index, in
+    // a BST and in a splay tree
+    vector<string> names;
+    loadVectorFromFile("actors.txt", names);
+    BST<string> bst;
+    SplayBST<string> splay;
+    bst.useHashIndex(true);
+    splay.useHashIndex(true);
+    insertIntoBST(names, bst);
+    insertIntoBST(names, splay);
+    for (const string& name : names) {
+        ASSERT_EQ(*bst.find(name), name);
+        ASSERT_EQ(*bst.find(name.data(), name.size()), name);
+        ASSERT_EQ(*splay.find(name), name);
+        ASSERT_EQ(*splay.find(name.c_str()), name);
+        ASSERT_EQ(bst.find(name + " Jr."), bst.end());
+    }
+    EXPECT_EQ(splay.find("Not An Actor"), splay.end());
+}
@@ -0,0 +1,64 @@
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "BST.hpp"
+#include "BSTNode.hpp"
+#include "KeyPrefix.hpp"
+#include "util.hpp"
+
+using namespace std;
+using namespace testing;
+
+/** Return -1, 0 or 1 as a is before, equal to or after b */
+int sign(int order) { return (order > 0) - (order < 0); }
+
+TEST(KeyPrefixTests, STRING_COMPARE_TEST) {
+    // assert that the prefix compare orders strings like operator<
+    vector<string> strings{"",         "a",          "ab",
+                           "abc",      "abcdefg",    "abcdefgh",
+                           "abcdefgi", "abcdefghij", "abcdefghijk",
+                           "b",        string(1, '\0'), string("ab\0c", 4),
+                           "\xff",     "\x7f",       "Zeta-Jones, Catherine",
+                           "Zeta-Jones, Catherin"};
+    mt19937 random(5);
+    for (int i = 0; i < 500; i++) {
+        string s;
+        int len = random() % 12;
+        for (int j = 0; j < len; j++) s += (char)("ab\0\xff"[random() % 4]);
+        strings.push_back(s);
+    }
+    for (const string& a : strings) {
+        for (const string& b : strings) {
+            BSTNode<string> node(b);
+            int expected = a < b ? -1 : (b < a ? 1 : 0);
+            ASSERT_EQ(sign(SearchKey<string>(a).compare(b, node)), expected)
+                << "\"" << a << "\" vs \"" << b << "\"";
+        }
+    }
+}
+
+TEST(KeyPrefixTests, GENERIC_COMPARE_TEST) {
+    // assert that other types compare with operator<
+    BSTNode<int> node(5);
+    EXPECT_LT(SearchKey<int>(4).compare(5, node), 0);
+    EXPECT_EQ(SearchKey<int>(5).compare(5, node), 0);
+    EXPECT_GT(SearchKey<int>(6).compare(5, node), 0);
+}
+
+TEST(KeyPrefixTests, CHAR_POINTER_FIND_TEST) {
+    // assert that character buffers find the same names as strings
+    vector<string> names;
+    loadVectorFromFile("actors.txt", names);
+    BST<string> bst;
+    insertIntoBST(names, bst);
+    for (const string& name : names) {
+        ASSERT_EQ(*bst.find(name.c_str()), name);
+        ASSERT_EQ(bst.find(name.c_str(), name.size()), bst.find(name));
+        // a shorter piece of the name is a different key
+        ASSERT_EQ(bst.find(name.c_str(), name.size() - 1),
+                  bst.find(name.substr(0, name.size() - 1)));
+    }
+    EXPECT_EQ(bst.find("Not An Actor"), bst.end());
+}
@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "SplayBST.hpp"
+#include "util.hpp"
+
+using namespace std;
+using namespace testing;
+
+/** Expose the root of a splay tree to check its shape */
+template <typename Data>
+class InspectableSplayBST : public SplayBST<Data> {
+  public:
+    explicit InspectableSplayBST(unsigned int splayPeriod = 1)
+        : SplayBST<Data>(splayPeriod) {}
+
+    BSTNode<Data>* getRoot() const { return this->root; }
+};
+
+/** Check the parent links and cached heights and sizes of the subtree at n.
+ *  Return its height.
+ */
+template <typename Data>
+int checkLinks(BSTNode<Data>* n, BSTNode<Data>* parent) {
+    if (n == nullptr) return -1;
+    EXPECT_EQ(n->parent, parent);
+    int height = max(checkLinks(n->left, n), checkLinks(n->right, n)) + 1;
+    EXPECT_EQ(n->height, height);
+    EXPECT_EQ(n->size, (n->left ? n->left->size : 0) +
+                           (n->right ? n->right->size : 0) + 1);
+    return height;
+}
+
+TEST(SplayBSTTests, EMPTY_TREE_TEST) {
+    SplayBST<int> splay;
+    ASSERT_TRUE(splay.empty());
+    ASSERT_EQ(splay.height(), -1);
+    ASSERT_EQ(splay.find(1), splay.end());
+}
+
+TEST(SplayBSTTests, FIND_SPLAYS_TO_ROOT_TEST) {
+    // assert that inserted and found items move to the root, and that
+    // every splay case keeps the order and the cached fields
+    InspectableSplayBST<int> splay;
+    vector<int> input{50, 20, 80, 10, 30, 70, 90, 25, 35, 5, 95, 75};
+    for (int item : input) {
+        ASSERT_TRUE(splay.insert(item));
+        ASSERT_EQ(splay.getRoot()->data, item);
+    }
+    ASSERT_FALSE(splay.insert(30));
+    sort(input.begin(), input.end());
+    for (int item : {5, 95, 35, 25, 75, 50, 50, 10, 90}) {
+        ASSERT_EQ(*splay.find(item), item);
+        ASSERT_EQ(splay.getRoot()->data, item);
+        EXPECT_EQ(splay.inorder(), input);
+        EXPECT_EQ(checkLinks<int>(splay.getRoot(), nullptr), splay.height());
+    }
+    // a miss does not move anything
+    EXPECT_EQ(splay.find(40), splay.end());
+    EXPECT_EQ(splay.getRoot()->data, 90);
+}
+
+TEST(SplayBSTTests, CONST_FIND_TEST) {
+    // assert that find through a const tree or a BST reference only reads
+    InspectableSplayBST<int> splay;
+    for (int i = 0; i < 100; i++) splay.insert(i);
+    const SplayBST<int>& readOnly = splay;
+    BST<int>& base = splay;
+    EXPECT_EQ(*readOnly.find(3), 3);
+    EXPECT_EQ(*base.find(7), 7);
+    EXPECT_EQ(splay.getRoot()->data, 99);
+    EXPECT_EQ(splay.height(), 99);
+}
+
+TEST(SplayBSTTests, SORTED_INSERT_THEN_FIND_TEST) {
+    // assert that finding the deepest item of a path halves its depth
+    InspectableSplayBST<int> splay;
+    for (int i = 0; i < 1024; i++) splay.insert(i);
+    ASSERT_EQ(splay.height(), 1023);
+    splay.find(0);
+    EXPECT_EQ(splay.getRoot()->data, 0);
+    EXPECT_LE(splay.height(), 513);
+    EXPECT_EQ(checkLinks<int>(splay.getRoot(), nullptr), splay.height());
+}
+
+TEST(SplayBSTTests, RANDOM_OPERATIONS_TEST) {
+    // assert that random inserts, finds and erases keep the tree equal to
+    // a set, with rank and select still working
+    mt19937 random(29);
+    InspectableSplayBST<int> splay;
+    set<int> expected;
+    for (int i = 0; i < 20000; i++) {
+        int item = random() % 3000;
+        switch (random() % 3) {
+            case 0:
+                EXPECT_EQ(splay.insert(item), expected.insert(item).second);
+                break;
+            case 1:
+                EXPECT_EQ(splay.find(item) != splay.end(),
+                          expected.count(item) > 0);
+                break;
+            default:
+                EXPECT_EQ(splay.erase(item), expected.erase(item) > 0);
+        }
+    }
+    vector<int> sorted(expected.begin(), expected.end());
+    EXPECT_EQ(splay.inorder(), sorted);
+    EXPECT_EQ(checkLinks<int>(splay.getRoot(), nullptr), splay.height());
+    for (unsigned int i = 0; i < sorted.size(); i += 17) {
+        EXPECT_EQ(splay.rank(sorted[i]), i);
+        EXPECT_EQ(*splay.select(i), sorted[i]);
+    }
+}
+
+TEST(SplayBSTTests, ACTORS_TEST) {
+    // assert that names and char buffers are found and splayed
+    vector<string> names;
+    loadVectorFromFile("actors.txt", names);
+    InspectableSplayBST<string> splay;
+    insertIntoBST(names, splay);
+    for (const string& name : names) {
+        ASSERT_EQ(*splay.find(name), name);
+        ASSERT_EQ(*splay.find(name.c_str()), name);
+        ASSERT_EQ(splay.getRoot()->data, name);
+    }
+    EXPECT_EQ(splay.find("Not An Actor"), splay.end());
+    splay.useFilter(0.01);
+    EXPECT_EQ(*splay.find(names[0]), names[0]);
+    EXPECT_EQ(splay.find("Not An Actor"), splay.end());
+}
+
+TEST(SplayBSTTests, SPLAY_PERIOD_TEST) {
+    // assert that with a period of 3 only every third hit splays
+    InspectableSplayBST<int> splay(3);
+    for (int i = 0; i < 10; i++) splay.insert(i);
+    ASSERT_EQ(splay.getRoot()->data, 9);
+    splay.find(0);
+    splay.find(1);
+    splay.find(100);
+    EXPECT_EQ(splay.getRoot()->data, 9);
+    splay.find(2);
+    EXPECT_EQ(splay.getRoot()->data, 2);
+    splay.find(3);
+    splay.find(4);
+    EXPECT_EQ(splay.getRoot()->data, 2);
+    splay.find(5);
+    EXPECT_EQ(splay.getRoot()->data, 5);
+    EXPECT_EQ(checkLinks<int>(splay.getRoot(), nullptr), splay.height());
+}
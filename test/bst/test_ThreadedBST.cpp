@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "ThreadedBST.hpp"
+#include "util.hpp"
+
+using namespace std;
+using namespace testing;
+
+TEST(ThreadedBSTTests, EMPTY_TREE_TEST) {
+    ThreadedBST<int> tree;
+    ASSERT_TRUE(tree.empty());
+    ASSERT_EQ(tree.height(), -1);
+    ASSERT_EQ(tree.begin(), tree.end());
+    ASSERT_EQ(tree.find(1), tree.end());
+    ASSERT_EQ(--tree.end(), tree.end());
+}
+
+TEST(ThreadedBSTTests, INSERT_ITERATE_TEST) {
+    // assert that random inserts iterate in order both ways
+    mt19937 random(31);
+    ThreadedBST<int> tree;
+    set<int> expected;
+    for (int i = 0; i < 5000; i++) {
+        int item = random() % 10000;
+        ASSERT_EQ(tree.insert(item), expected.insert(item).second);
+    }
+    ASSERT_EQ(tree.size(), expected.size());
+    EXPECT_EQ(tree.inorder(), vector<int>(expected.begin(), expected.end()));
+    vector<int> backwards;
+    for (auto it = tree.end(); it != tree.begin();) backwards.push_back(*--it);
+    EXPECT_TRUE(equal(backwards.begin(), backwards.end(), expected.rbegin()));
+    for (int i = -1; i <= 10000; i += 7) {
+        EXPECT_EQ(tree.find(i) != tree.end(), expected.count(i) > 0);
+        auto lower = tree.lower_bound(i);
+        auto expectedLower = expected.lower_bound(i);
+        if (expectedLower == expected.end()) {
+            EXPECT_EQ(lower, tree.end());
+        } else {
+            EXPECT_EQ(*lower, *expectedLower);
+        }
+        auto upper = tree.upper_bound(i);
+        auto expectedUpper = expected.upper_bound(i);
+        if (expectedUpper == expected.end()) {
+            EXPECT_EQ(upper, tree.end());
+        } else {
+            EXPECT_EQ(*upper, *expectedUpper);
+        }
+    }
+}
+
+TEST(ThreadedBSTTests, SORTED_INSERT_HEIGHT_TEST) {
+    // assert that the height follows inserts like in BST
+    ThreadedBST<int> tree;
+    for (int i = 0; i < 100; i++) {
+        tree.insert(i);
+        ASSERT_EQ(tree.height(), i);
+    }
+    EXPECT_EQ(*--tree.end(), 99);
+    EXPECT_EQ(*tree.begin(), 0);
+}
+
+TEST(ThreadedBSTTests, BUILD_TEST) {
+    // assert that build gives a balanced tree that takes more inserts
+    ThreadedBST<int> tree;
+    tree.insert(5000);
+    vector<int> input;
+    for (int i = 0; i < 1023; i++) input.push_back(i * 2);
+    input.push_back(10);
+    shuffle(input.begin(), input.end(), mt19937(2));
+    tree.build(input.begin(), input.end());
+    ASSERT_EQ(tree.size(), 1023);
+    ASSERT_EQ(tree.height(), 9);
+    EXPECT_EQ(tree.find(5000), tree.end());
+    ASSERT_TRUE(tree.insert(7));
+    ASSERT_FALSE(tree.insert(8));
+    EXPECT_EQ(tree.height(), 10);
+    auto it = tree.find(6);
+    EXPECT_EQ(*++it, 7);
+    EXPECT_EQ(*++it, 8);
+    EXPECT_EQ(*--it, 7);
+    EXPECT_EQ(*it++, 7);
+    EXPECT_EQ(*it--, 8);
+    EXPECT_EQ(*it, 7);
+    vector<int> items = tree.inorder();
+    EXPECT_TRUE(is_sorted(items.begin(), items.end()));
+    EXPECT_EQ(items.size(), 1024);
+    tree.build(input.end(), input.end());
+    EXPECT_TRUE(tree.empty());
+}
+
+TEST(ThreadedBSTTests, ACTORS_TEST) {
+    // assert that the names are found as strings and char buffers
+    vector<string> names;
+    loadVectorFromFile("actors.txt", names);
+    ThreadedBST<string> tree;
+    tree.build(names.begin(), names.end());
+    set<string> expected(names.begin(), names.end());
+    EXPECT_EQ(tree.inorder(), vector<string>(expected.begin(), expected.end()));
+    for (const string& name : names) {
+        ASSERT_EQ(*tree.find(name), name);
+        ASSERT_EQ(*tree.find(name.c_str()), name);
+    }
+    EXPECT_EQ(tree.find("Not An Actor"), tree.end());
+    EXPECT_EQ(*max_element(tree.begin(), tree.end()), *expected.rbegin());
+}
@@ -0,0 +1,71 @@
+/**
+ * This program converts a point file between the text format (one point
+ * per line, features separated by whitespace) and the binary format
+ * described in PointFile.hpp. The direction is picked from the format of
+ * the input file.
+ * Optional flags when writing a binary file:
+ *   -f32: store the coordinates as float32 instead of float64
+ *   -ids: store the line number of every point as its id
+ *
+ * Usage: ./convertPoints [-f32] [-ids] <input filename> <output filename>
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "PointFile.hpp"
+#include "PointReader.hpp"
+#include "Timer.hpp"
+
+using namespace std;
+
+int main(int argc, char* argv[]) {
+    PointDType dtype = FLOAT64;
+    bool withIds = false;
+    vector<string> files;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "-f32") {
+            dtype = FLOAT32;
+        } else if (arg == "-ids") {
+            withIds = true;
+        } else {
+            files.push_back(arg);
+        }
+    }
+    if (files.size() != 2) {
+        cout << "Invalid arguments.\n"
+             << "Usage: ./convertPoints [-f32] [-ids] <input filename> "
+             << "<output filename>" << endl;
+        return -1;
+    }
+
+    Timer t;
+    PointSet points;
+    bool toText = isBinaryPointFile(files[0].c_str());
+    t.begin_timer();
+    if (!loadPoints(files[0].c_str(), points)) {
+        cout << "Could not read " << files[0] << endl;
+        return -1;
+    }
+    long long readTime = t.end_timer();
+    if (withIds && !toText) {
+        points.ids.resize(points.size());
+        for (size_t i = 0; i < points.ids.size(); i++) points.ids[i] = i;
+    }
+
+    t.begin_timer();
+    bool ok = toText ? writeTextPoints(files[1].c_str(), points)
+                     : writeBinaryPoints(files[1].c_str(), points, dtype);
+    long long writeTime = t.end_timer();
+    if (!ok) {
+        cout << "Could not write " << files[1] << endl;
+        return -1;
+    }
+    cout << "Converted " << points.size() << " points of " << points.numDim
+         << " dimensions to the " << (toText ? "text" : "binary") << " format"
+         << endl;
+    cout << "Read time: " << readTime << " nanoseconds" << endl;
+    cout << "Write time: " << writeTime << " nanoseconds" << endl;
+    return 0;
+}
@@ -0,0 +1,68 @@
+/**
+ * This program builds a disk-resident KD tree index (see DiskKDT.hpp) from
+ * a point file that need not fit in memory, and answers nearest neighbor
+ * queries from such an index, printing one neighbor per query point like
+ * main2 does.
+ *
+ * Usage: ./diskIndex build <point filename> <index filename> [memory MB]
+ *        ./diskIndex query <index filename> <query filename>
+ */
+
+#include <stdlib.h>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "DiskKDT.hpp"
+#include "Point.hpp"
+#include "PointFile.hpp"
+#include "Timer.hpp"
+
+using namespace std;
+
+int main(int argc, char* argv[]) {
+    string mode = argc > 1 ? argv[1] : "";
+    if (!((mode == "build" && (argc == 4 || argc == 5)) ||
+          (mode == "query" && argc == 4))) {
+        cout << "Invalid arguments.\n"
+             << "Usage: ./diskIndex build <point filename> <index filename> "
+             << "[memory MB]\n"
+             << "       ./diskIndex query <index filename> <query filename>"
+             << endl;
+        return -1;
+    }
+
+    Timer t;
+    if (mode == "build") {
+        size_t memoryMB = argc == 5 ? strtoul(argv[4], nullptr, 10) : 256;
+        t.begin_timer();
+        if (!DiskKDT::buildIndex(argv[2], argv[3], memoryMB << 20)) {
+            cout << "Could not build the index " << argv[3] << endl;
+            return -1;
+        }
+        long long buildTime = t.end_timer();
+        DiskKDT index;
+        index.open(argv[3]);
+        cout << "Indexed " << index.size() << " points of "
+             << index.dimension() << " dimensions in " << index.numBuckets()
+             << " buckets" << endl;
+        cout << "Build time: " << buildTime << " nanoseconds" << endl;
+        return 0;
+    }
+
+    DiskKDT index;
+    if (!index.open(argv[2])) {
+        cout << "Could not open the index " << argv[2] << endl;
+        return -1;
+    }
+    PointSet queries;
+    if (!loadPoints(argv[3], queries) ||
+        (queries.size() > 0 && queries.numDim != index.dimension())) {
+        cout << "Could not read the queries " << argv[3] << endl;
+        return -1;
+    }
+    for (Point& query : queries.toPoints()) {
+        vector<Point> neighbor = index.findKNearestNeighbors(query, 1);
+        if (!neighbor.empty()) cout << neighbor[0] << endl;
+    }
+    return 0;
+}
@@ -1,6 +1,10 @@
 /**
  * Test efficiency of KD tree compared to brute force implementation
  * of nearest neightbor searching and range searching
+ *
+ * Usage: ./efficiencyTest [build data filename] [query data filename]
+ * Without files, random build and query points are used. The files may be
+ * in the text or the binary point format (see PointFile.hpp).
  */
 
 #include <stdlib.h>
@@ -10,6 +14,7 @@
 #include "KDT.hpp"
 #include "NaiveSearch.hpp"
 #include "Point.hpp"
+#include "PointFile.hpp"
 #include "Timer.hpp"
 
 /** Return a random number between min and max. Note that rand() returns
@@ -39,6 +44,25 @@ vector<Point> randomPoints(unsigned int numPoints, unsigned int numDim,
     return result;
 }
 
+/** Returns a vector of points gathered around numClusters random centers.
+ *  Each point is at most spread away from its center in every dimension
+ */
+vector<Point> clusteredPoints(unsigned int numPoints, unsigned int numDim,
+                              unsigned int numClusters, double min, double max,
+                              double spread) {
+    vector<vector<double>> centers;
+    for (unsigned int i = 0; i < numClusters; i++) {
+        centers.push_back(randNums(numDim, min, max));
+    }
+    vector<Point> result;
+    for (unsigned int i = 0; i < numPoints; i++) {
+        vector<double> features = centers[rand() % numClusters];
+        for (double& f : features) f += randNum(-spread, spread);
+        result.push_back(Point(features));
+    }
+    return result;
+}
+
 /** Returns a random valid range with number of given dimensions
  *  The length of range at each dimension is given by length
  */
@@ -53,34 +77,65 @@ vector<pair<double, double>> rangeRange(unsigned int numDim, int length,
 }
 
 /** Test the efficiency of kd tree by comparing the runtime to naive search */
-int main() {
+int main(int argc, char* argv[]) {
     const int NUM_DATA = 5000000;  // number of random Build data
     const int NUM_TEST = 10;       // number of tests
     const int NUM_DIM = 3;         // number of dimension of random data
     const double MIN_VAL = 0;      // lower bound of random data features
     const double MAX_VAL = 100;    // upper bound of random data features
     const double RANGE_LEN = 3;    // length of random range (EC)
+    const int NUM_CLUSTER_DATA = 1000000;  // number of clustered Build data
+    const int NUM_CLUSTER_TEST = 1000;     // number of clustered tests
+    const int NUM_CLUSTERS = 20;           // number of clusters
+    const double SPREAD = 1;  // max distance of a point to its cluster center
 
     KDT kdtree;
     NaiveSearch naiveSearch;
+    Timer t;
+    long long sumTime = 0;
+
+    vector<Point> buildData;
+    vector<Point> testData;
+    unsigned int numDim = NUM_DIM;
+    if (argc > 1) {
+        cout << endl << "Reading build points from " << argv[1] << "..." << endl;
+        t.begin_timer();
+        if (!loadPoints(argv[1], buildData)) {
+            cout << "Could not read " << argv[1] << endl;
+            return -1;
+        }
+        sumTime = t.end_timer();
+        if (buildData.empty()) return -1;
+        numDim = buildData[0].numDim;
+        cout << "Time taken: " << sumTime << " nanoseconds" << endl;
+    }
+    if (argc > 2) {
+        if (!loadPoints(argv[2], testData)) {
+            cout << "Could not read " << argv[2] << endl;
+            return -1;
+        }
+        if (testData.empty() || testData[0].numDim != numDim) return -1;
+    }
+    if (buildData.empty()) {
+        cout << endl << "Generating random points for building dataset..."
+             << endl;
+        buildData = randomPoints(NUM_DATA, numDim, MIN_VAL, MAX_VAL);
+    }
+    if (testData.empty()) {
+        testData = randomPoints(NUM_TEST, numDim, MIN_VAL, MAX_VAL);
+    }
 
-    cout << endl << "Build points size: " << NUM_DATA << endl;
-    cout << "Number of dimension: " << NUM_DIM << endl;
+    cout << endl << "Build points size: " << buildData.size() << endl;
+    cout << "Number of dimension: " << numDim << endl;
     cout << "Range of feature value: [" << MIN_VAL << ", " << MAX_VAL << "]"
          << endl;
-    cout << "Generating random points for building dataset..." << endl;
-
-    vector<Point> buildData = randomPoints(NUM_DATA, NUM_DIM, MIN_VAL, MAX_VAL);
-    vector<Point> testData = randomPoints(NUM_TEST, NUM_DIM, MIN_VAL, MAX_VAL);
 
     kdtree.build(buildData);
     naiveSearch.build(buildData);
 
-    Timer t;
-    long long sumTime = 0;
-
     cout << "\nTest 1: nearest neighbor search" << endl << endl;
-    cout << "\tQuery points size: " << NUM_TEST << ";" << endl << endl;
+    cout << "\tQuery points size: " << testData.size() << ";" << endl
+         << endl;
 
     cout << "\tTiming KD tree..." << endl;
 
@@ -105,7 +160,7 @@ int main() {
          << endl;
     vector<vector<pair<double, double>>> ranges;
     for (int i = 0; i < NUM_TEST; i++) {
-        ranges.push_back(rangeRange(NUM_DIM, RANGE_LEN, MIN_VAL, MAX_VAL));
+        ranges.push_back(rangeRange(numDim, RANGE_LEN, MIN_VAL, MAX_VAL));
     }
 
     cout << "\tTiming KD tree..." << endl;
@@ -124,5 +179,38 @@ int main() {
     sumTime = t.end_timer();
     cout << "\tTime taken: " << sumTime << " nanoseconds\n" << endl;
 
+    cout << "Test 3: nearest neighbor search on clustered data" << endl
+         << endl;
+    cout << "\tBuild points size: " << NUM_CLUSTER_DATA
+         << "; Number of clusters: " << NUM_CLUSTERS
+         << "; Query points size: " << NUM_CLUSTER_TEST << ";" << endl
+         << endl;
+    vector<Point> clusterData = clusteredPoints(
+        NUM_CLUSTER_DATA, NUM_DIM, NUM_CLUSTERS, MIN_VAL, MAX_VAL, SPREAD);
+    vector<Point> clusterTest =
+        randomPoints(NUM_CLUSTER_TEST, NUM_DIM, MIN_VAL, MAX_VAL);
+
+    for (bool boxPruning : {false, true}) {
+        KDT clusterTree(boxPruning);
+        clusterTree.build(clusterData);
+        if (boxPruning) {
+            cout << "\tTiming KD tree with bounding box pruning..." << endl;
+        } else {
+            cout << "\tTiming KD tree with splitting plane pruning..."
+                 << endl;
+        }
+        unsigned long long nodesVisited = 0;
+        t.begin_timer();
+        for (Point& p : clusterTest) {
+            clusterTree.findNearestNeighbor(p, &nodesVisited);
+        }
+        sumTime = t.end_timer();
+        cout << "\tTime taken: " << sumTime << " nanoseconds" << endl;
+        cout << "\tNodes visited: " << nodesVisited << endl;
+        cout << "\tBounding box memory: " << clusterTree.boundingBoxBytes()
+             << " bytes\n"
+             << endl;
+    }
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,115 @@
+/**
+ * This program writes a synthetic point file (see PointGenerator.hpp) of
+ * one of the distributions uniform, clustered, duplicates, line, grid or
+ * outliers, in the text format or, with -binary, in the binary format of
+ * PointFile.hpp.
+ * Optional flags:
+ *   -dim D:    number of dimensions (default 2)
+ *   -seed S:   seed of the random numbers (default 42), the same seed
+ *              gives the same file
+ *   -binary:   write the binary format
+ *   -f32:      with -binary, store the coordinates as float32
+ * and, to tune the hard cases (defaults in PointWorkload):
+ *   -clusters N:      clustered, number of clusters (default 8)
+ *   -spread S:        clustered, standard deviation of a cluster as a
+ *                     fraction of the range (default 0.002)
+ *   -duplicates R:    duplicates, fraction of the points that repeat
+ *                     another point, in [0, 1] (default 0.9)
+ *   -outliers R:      outliers, fraction of the points that are outliers,
+ *                     in [0, 1] (default 0.01)
+ *   -outlierScale S:  outliers, how many times the range they may lie from
+ *                     the middle (default 1000)
+ *
+ * Usage: ./generatePoints [-dim D] [-seed S] [-binary] [-f32]
+ *        [-clusters N] [-spread S] [-duplicates R] [-outliers R]
+ *        [-outlierScale S] <distribution> <count> <output filename>
+ */
+
+#include <stdlib.h>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "PointFile.hpp"
+#include "PointGenerator.hpp"
+#include "Timer.hpp"
+
+using namespace std;
+
+int main(int argc, char* argv[]) {
+    unsigned int numDim = 2;
+    uint64_t seed = 42;
+    bool binary = false;
+    PointDType dtype = FLOAT64;
+    // tuning of the distributions, the defaults of PointWorkload
+    PointWorkload tuning(UNIFORM, 0, numDim);
+    vector<string> args;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "-dim" && i + 1 < argc) {
+            numDim = strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "-seed" && i + 1 < argc) {
+            seed = strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "-binary") {
+            binary = true;
+        } else if (arg == "-f32") {
+            dtype = FLOAT32;
+        } else if (arg == "-clusters" && i + 1 < argc) {
+            tuning.numClusters = strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "-spread" && i + 1 < argc) {
+            tuning.spread = strtod(argv[++i], nullptr);
+        } else if (arg == "-duplicates" && i + 1 < argc) {
+            tuning.duplicateRate = strtod(argv[++i], nullptr);
+        } else if (arg == "-outliers" && i + 1 < argc) {
+            tuning.outlierRate = strtod(argv[++i], nullptr);
+        } else if (arg == "-outlierScale" && i + 1 < argc) {
+            tuning.outlierScale = strtod(argv[++i], nullptr);
+        } else {
+            args.push_back(arg);
+        }
+    }
+    PointDistribution distribution = UNIFORM;
+    if (args.size() != 3 || numDim == 0 ||
+        !parseDistribution(args[0], distribution) ||
+        tuning.numClusters == 0 || !(tuning.spread >= 0) ||
+        !(tuning.duplicateRate >= 0 && tuning.duplicateRate <= 1) ||
+        !(tuning.outlierRate >= 0 && tuning.outlierRate <= 1) ||
+        !(tuning.outlierScale >= 0)) {
+        cout << "Invalid arguments.\n"
+             << "Usage: ./generatePoints [-dim D] [-seed S] [-binary] [-f32] "
+             << "[-clusters N] [-spread S] [-duplicates R] [-outliers R] "
+             << "[-outlierScale S] <distribution> <count> "
+             << "<output filename>\n"
+             << "Distributions:";
+        for (PointDistribution d : POINT_DISTRIBUTIONS) {
+            cout << " " << distributionName(d);
+        }
+        cout << endl;
+        return -1;
+    }
+
+    Timer t;
+    PointWorkload workload(distribution, strtoull(args[1].c_str(), nullptr, 10),
+                           numDim, seed);
+    workload.numClusters = tuning.numClusters;
+    workload.spread = tuning.spread;
+    workload.duplicateRate = tuning.duplicateRate;
+    workload.outlierRate = tuning.outlierRate;
+    workload.outlierScale = tuning.outlierScale;
+    t.begin_timer();
+    PointSet points = generatePoints(workload);
+    long long generateTime = t.end_timer();
+
+    t.begin_timer();
+    bool ok = binary ? writeBinaryPoints(args[2].c_str(), points, dtype)
+                     : writeTextPoints(args[2].c_str(), points);
+    long long writeTime = t.end_timer();
+    if (!ok) {
+        cout << "Could not write " << args[2] << endl;
+        return -1;
+    }
+    cout << "Wrote " << points.size() << " " << args[0] << " points of "
+         << numDim << " dimensions to " << args[2] << endl;
+    cout << "Generate time: " << generateTime << " nanoseconds" << endl;
+    cout << "Write time: " << writeTime << " nanoseconds" << endl;
+    return 0;
+}
@@ -1,17 +1,27 @@
 /**
- * This program takes in two files: build data file and query data file.
+ * This program takes in two files: build data file and query data file,
+ * each in the text or the binary point format (see PointFile.hpp).
  * For each query data, this program outputs its nearest neighbor in the
  * build data. The nearest neighbor searching is achieved using KD tree.
+ * With the optional flag "-s" the query points are streamed instead of
+ * being read all at once: they are answered in blocks on all cores and
+ * memory use does not depend on the number of queries. The query file
+ * may then be "-" to read the query points from standard input.
+ *
+ * Usage: ./main2 [-s] <build data filename> <query data filename>
  */
 
+#include <fcntl.h>
+#include <unistd.h>
 #include <algorithm>
 #include <fstream>
 #include <iostream>
-#include <sstream>
 #include <string>
 #include <vector>
 #include "KDT.hpp"
 #include "Point.hpp"
+#include "PointFile.hpp"
+#include "QueryStream.hpp"
 
 using namespace std;
 
@@ -37,51 +47,56 @@ bool fileValid(const char* fileName) {
     return true;
 }
 
-/**
- *  Read all lines from the file and convert them to a vector
- *  of data points
+/** Build the KD tree from buildFile, then stream the answers to the
+ *  queries in queryFile ("-" for standard input) to standard output
  */
-vector<Point> readPoints(const char* fileName) {
-    vector<Point> result;
-    string line;
-    unsigned int numDim = 0;
-    double data = 0;
-
-    ifstream in;
-    in.open(fileName, ios::binary);
-
-    // count number of dimensions
-    getline(in, line);
-    stringstream lineStream(line);
-    while (lineStream >> data) numDim++;
+int streamQueries(const char* buildFile, const char* queryFile) {
+    int queryFd = 0;
+    if (string(queryFile) != "-") {
+        if (!fileValid(queryFile)) return -1;
+        queryFd = open(queryFile, O_RDONLY);
+        if (queryFd < 0) {
+            cout << "Could not open " << queryFile << endl;
+            return -1;
+        }
+    }
 
-    // Resets the stream to beginning of file
-    in.seekg(0, ios_base::beg);
+    KDT tree;
+    vector<Point> buildPoints;
+    if (!loadPoints(buildFile, buildPoints)) {
+        cout << "Could not read " << buildFile << endl;
+        return -1;
+    }
+    tree.build(buildPoints);
+    buildPoints.clear();
+    buildPoints.shrink_to_fit();
 
-    // read the data and convert them to data points
-    while (!in.eof()) {
-        vector<double> features;
-        for (unsigned int i = 0; i < numDim; i++) {
-            in >> data;
-            if (!in.fail()) {
-                features.push_back(data);
-            }
-        }
-        if (!in.fail()) {
-            result.push_back(Point(features));
-        }
+    cout << "Size of KD tree: " << tree.size() << endl;
+    cout << "Height of KD tree: " << tree.height() << endl;
+    cout << "Nearest neighbor of each query point: " << endl;
+    bool failed = false;
+    streamNearestNeighbors(tree, queryFd, stdout, 0, 4096, &failed);
+    if (queryFd != 0) close(queryFd);
+    if (failed) {
+        cout << "Invalid query data in " << queryFile
+             << ". Please try again." << endl;
+        return -1;
     }
-    in.close();
-    return result;
+    return 0;
 }
 
 int main(int argc, char* argv[]) {
     const int NUM_ARG = 3;
+    const int NUM_ARG_FLAG = 4;
 
     // check for Arguments
+    if (argc == NUM_ARG_FLAG && string(argv[1]) == "-s") {
+        if (!fileValid(argv[2])) return -1;
+        return streamQueries(argv[2], argv[3]);
+    }
     if (argc != NUM_ARG) {
         cout << "Invalid number of arguments.\n"
-             << "Usage: ./main <build data filename> <query data filename>"
+             << "Usage: ./main [-s] <build data filename> <query data filename>"
              << endl;
         return -1;
     }
@@ -90,8 +105,16 @@ int main(int argc, char* argv[]) {
     if (!fileValid(argv[1]) || !fileValid(argv[2])) return -1;
 
     KDT tree;
-    vector<Point> buildPoints = readPoints(argv[1]);
-    vector<Point> queryPoints = readPoints(argv[2]);
+    vector<Point> buildPoints;
+    vector<Point> queryPoints;
+    if (!loadPoints(argv[1], buildPoints)) {
+        cout << "Could not read " << argv[1] << endl;
+        return -1;
+    }
+    if (!loadPoints(argv[2], queryPoints)) {
+        cout << "Could not read " << argv[2] << endl;
+        return -1;
+    }
 
     tree.build(buildPoints);
 
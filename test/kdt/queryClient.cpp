@@ -0,0 +1,158 @@
+/**
+ * Load generator for the KD tree query server. Every connection sends the
+ * query points of a query data file to the server in a loop, keeping a
+ * window of requests in flight, and the program reports throughput and
+ * p50/p99 latency over all requests.
+ *
+ * Usage: ./queryClient <address> <query data filename> [nn|knn|range]
+ *                      [number of connections] [requests per connection]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Point.hpp"
+#include "PointFile.hpp"
+#include "QueryProtocol.hpp"
+#include "Timer.hpp"
+
+using namespace std;
+
+const unsigned int WINDOW = 64;   // requests in flight per connection
+const unsigned int K = 10;        // number of neighbors of a knn request
+const double RANGE_LEN = 3;       // side length of a range request
+
+/** Build the request with the given id for query point p */
+QueryRequest makeRequest(uint32_t id, QueryType type, const Point& p) {
+    QueryRequest request;
+    request.header = {};
+    request.header.id = id;
+    request.header.type = type;
+    request.header.k = K;
+    request.header.numDim = p.numDim;
+    if (type == RANGE_QUERY) {
+        for (double f : p.features) {
+            request.values.push_back(f - RANGE_LEN / 2);
+            request.values.push_back(f + RANGE_LEN / 2);
+        }
+    } else {
+        request.values = p.features;
+    }
+    return request;
+}
+
+/** Send numRequests requests over one connection and record the latency
+ *  of each in nanoseconds. Return false if the connection failed.
+ */
+bool runConnection(const string& address, QueryType type,
+                   const vector<Point>& queries, unsigned int numRequests,
+                   vector<long long>& latencies) {
+    int fd = openConnection(address);
+    if (fd < 0) return false;
+    SocketReader in(fd);
+    QueryResponse response;
+    vector<char> buf;
+    vector<chrono::high_resolution_clock::time_point> sendTime(numRequests);
+    unsigned int sent = 0;
+    unsigned int received = 0;
+    bool ok = true;
+    while (ok && received < numRequests) {
+        // top up the window, sending all new requests with one write
+        buf.clear();
+        while (sent < numRequests && sent - received < WINDOW) {
+            appendRequest(buf, makeRequest(sent, type,
+                                           queries[sent % queries.size()]));
+            sendTime[sent] = chrono::high_resolution_clock::now();
+            sent++;
+        }
+        if (!buf.empty()) ok = writeFully(fd, buf.data(), buf.size());
+        if (ok) ok = readResponse(in, response);
+        if (ok && response.header.id < numRequests) {
+            latencies.push_back(
+                chrono::duration_cast<chrono::nanoseconds>(
+                    chrono::high_resolution_clock::now() -
+                    sendTime[response.header.id])
+                    .count());
+            ok = response.header.status == QUERY_OK;
+            received++;
+        }
+    }
+    close(fd);
+    return ok;
+}
+
+int main(int argc, char* argv[]) {
+    const int MIN_ARG = 3;
+    const int MAX_ARG = 6;
+
+    // check for Arguments
+    if (argc < MIN_ARG || argc > MAX_ARG) {
+        cout << "Invalid number of arguments.\n"
+             << "Usage: ./queryClient <address> <query data filename> "
+             << "[nn|knn|range] [number of connections] "
+             << "[requests per connection]" << endl;
+        return -1;
+    }
+    string address = argv[1];
+    QueryType type = NN_QUERY;
+    if (argc > 3) {
+        string name = argv[3];
+        if (name == "knn") {
+            type = KNN_QUERY;
+        } else if (name == "range") {
+            type = RANGE_QUERY;
+        } else if (name != "nn") {
+            cout << "Invalid query type " << name << endl;
+            return -1;
+        }
+    }
+    unsigned int numConnections = argc > 4 ? atoi(argv[4]) : 4;
+    unsigned int numRequests = argc > 5 ? atoi(argv[5]) : 100000;
+
+    vector<Point> queries;
+    if (!loadPoints(argv[2], queries)) {
+        cout << "Could not read " << argv[2] << endl;
+        return -1;
+    }
+    if (queries.empty() || numConnections == 0 || numRequests == 0) {
+        cout << "Nothing to send." << endl;
+        return -1;
+    }
+
+    vector<vector<long long>> latencies(numConnections);
+    vector<char> ok(numConnections);
+    vector<thread> threads;
+    Timer t;
+    t.begin_timer();
+    for (unsigned int i = 0; i < numConnections; i++) {
+        threads.emplace_back([&, i] {
+            ok[i] = runConnection(address, type, queries, numRequests,
+                                  latencies[i]);
+        });
+    }
+    for (thread& th : threads) th.join();
+    long long elapsed = t.end_timer();
+
+    vector<long long> all;
+    for (unsigned int i = 0; i < numConnections; i++) {
+        if (!ok[i]) {
+            cout << "Connection " << i << " failed." << endl;
+            return -1;
+        }
+        all.insert(all.end(), latencies[i].begin(), latencies[i].end());
+    }
+    sort(all.begin(), all.end());
+
+    cout << "Requests: " << all.size() << " over " << numConnections
+         << " connections" << endl;
+    cout << "Time taken: " << elapsed << " nanoseconds" << endl;
+    cout << "Throughput: " << (long long)(all.size() * 1e9 / elapsed)
+         << " requests/second" << endl;
+    cout << "Latency p50: " << all[all.size() / 2] << " nanoseconds" << endl;
+    cout << "Latency p99: " << all[all.size() * 99 / 100] << " nanoseconds"
+         << endl;
+    return 0;
+}
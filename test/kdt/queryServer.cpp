@@ -0,0 +1,98 @@
+/**
+ * This program builds a KD tree from a build data file once and then serves
+ * nearest neighbor, k nearest neighbor and range queries on it over a local
+ * socket until it is interrupted. See QueryProtocol.hpp for the protocol and
+ * queryClient.cpp for a client.
+ *
+ * Usage: ./queryServer <build data filename> <address> [number of workers]
+ * where address is "unix:<socket path>" or "tcp:<port>"
+ */
+
+#include <signal.h>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "KDT.hpp"
+#include "Point.hpp"
+#include "PointFile.hpp"
+#include "QueryServer.hpp"
+
+using namespace std;
+
+/** Check if a given data file is valid */
+bool fileValid(const char* fileName) {
+    ifstream in;
+    in.open(fileName, ios::binary);
+
+    // Check if input file was actually opened
+    if (!in.is_open()) {
+        cout << "Invalid input file. No file was opened. Please try again.\n";
+        return false;
+    }
+
+    // Check for empty file
+    in.seekg(0, ios_base::end);
+    unsigned int len = in.tellg();
+    if (len == 0) {
+        cout << "The file is empty. \n";
+        return false;
+    }
+    in.close();
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    const int MIN_ARG = 3;
+    const int MAX_ARG = 4;
+    const unsigned int MAX_BATCH = 64;      // requests answered together
+    const unsigned int BATCH_DELAY_US = 50;  // wait for a batch to fill up
+
+    // check for Arguments
+    if (argc < MIN_ARG || argc > MAX_ARG) {
+        cout << "Invalid number of arguments.\n"
+             << "Usage: ./queryServer <build data filename> <address> "
+             << "[number of workers]" << endl;
+        return -1;
+    }
+    unsigned int numWorkers = thread::hardware_concurrency();
+    if (argc == MAX_ARG) numWorkers = atoi(argv[3]);
+    if (numWorkers == 0) numWorkers = 1;
+
+    // check for valid file
+    if (!fileValid(argv[1])) return -1;
+
+    KDT tree(true);
+    vector<Point> buildPoints;
+    if (!loadPoints(argv[1], buildPoints)) {
+        cout << "Could not read " << argv[1] << endl;
+        return -1;
+    }
+    tree.build(buildPoints);
+    buildPoints.clear();
+    buildPoints.shrink_to_fit();
+
+    // Block the stop signals in every thread, main waits for them below
+    sigset_t stopSignals;
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stopSignals, nullptr);
+
+    QueryServer server(tree, numWorkers, MAX_BATCH, BATCH_DELAY_US);
+    if (!server.start(argv[2])) {
+        cout << "Could not listen on " << argv[2] << endl;
+        return -1;
+    }
+    cout << "Size of KD tree: " << tree.size() << endl;
+    cout << "Serving on " << argv[2] << " with " << numWorkers
+         << " workers" << endl;
+
+    int signal = 0;
+    sigwait(&stopSignals, &signal);
+    server.stop();
+    cout << "Requests served: " << server.requestsServed() << endl;
+    cout << "Batches served: " << server.batchesServed() << endl;
+    return 0;
+}
@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <vector>
+
+#include "BruteForce.hpp"
+#include "NaiveSearch.hpp"
+#include "Point.hpp"
+#include "PointGenerator.hpp"
+#include "util.hpp"
+
+using namespace std;
+using namespace testing;
+
+/** Return the k smallest squared distances from query to points, sorted */
+static vector<double> sortedDistances(vector<Point> points, Point& query,
+                                      unsigned int k) {
+    vector<double> dist;
+    for (Point& point : points) {
+        point.setDistToQuery(query);
+        dist.push_back(point.distToQuery);
+    }
+    sort(dist.begin(), dist.end());
+    dist.resize(min<size_t>(k, dist.size()));
+    return dist;
+}
+
+/** Return the distToQuery of every point */
+static vector<double> distancesOf(const vector<Point>& points) {
+    vector<double> dist;
+    for (const Point& point : points) dist.push_back(point.distToQuery);
+    return dist;
+}
+
+TEST(BruteForceTests, KNN_MATCHES_SORT) {
+    // assert that single and batch searches, on one and on several
+    // threads, find the k nearest distances of every distribution
+    for (PointDistribution distribution : POINT_DISTRIBUTIONS) {
+        vector<Point> points =
+            generatePoints(PointWorkload(distribution, 3000, 3)).toPoints();
+        vector<Point> queries =
+            generatePoints(PointWorkload(UNIFORM, 50, 3, 9)).toPoints();
+        BruteForce scan;
+        scan.build(points);
+        ASSERT_EQ(scan.size(), 3000);
+        ASSERT_EQ(scan.dimension(), 3);
+        vector<vector<Point>> single = scan.findKNearestNeighbors(queries, 7, 1);
+        vector<vector<Point>> many = scan.findKNearestNeighbors(queries, 7, 4);
+        for (size_t i = 0; i < queries.size(); i++) {
+            vector<double> expected = sortedDistances(points, queries[i], 7);
+            EXPECT_EQ(distancesOf(scan.findKNearestNeighbors(queries[i], 7)),
+                      expected)
+                << distributionName(distribution);
+            EXPECT_EQ(distancesOf(single[i]), expected);
+            EXPECT_EQ(distancesOf(many[i]), expected);
+        }
+    }
+}
+
+TEST(BruteForceTests, NN_MATCHES_NAIVE) {
+    // assert that the nearest neighbor is the one of NaiveSearch
+    vector<Point> points =
+        generatePoints(PointWorkload(CLUSTERED, 2000, 5)).toPoints();
+    NaiveSearch naive;
+    naive.build(points);
+    PointSet pointSet = generatePoints(PointWorkload(CLUSTERED, 2000, 5));
+    BruteForce scan;
+    scan.build(pointSet);
+    for (Point& query :
+         generatePoints(PointWorkload(UNIFORM, 100, 5, 3)).toPoints()) {
+        vector<Point> nearest = scan.findKNearestNeighbors(query, 1);
+        ASSERT_EQ(nearest.size(), 1);
+        EXPECT_EQ(nearest[0], *naive.findNearestNeighbor(query));
+    }
+}
+
+TEST(BruteForceTests, RANGE_MATCHES_NAIVE) {
+    // assert that range searches find the points NaiveSearch finds
+    vector<Point> points =
+        generatePoints(PointWorkload(UNIFORM, 5000, 2)).toPoints();
+    NaiveSearch naive;
+    naive.build(points);
+    BruteForce scan;
+    scan.build(points);
+    vector<vector<pair<double, double>>> regions = {
+        {{-10, 10}, {-10, 10}},
+        {{-100, 100}, {0, 5}},
+        {{50, 40}, {-100, 100}},
+        {{-200, 200}, {-200, 200}}};
+    for (vector<pair<double, double>>& region : regions) {
+        vector<Point> expected = naive.rangeSearch(region);
+        vector<Point> found = scan.rangeSearch(region);
+        // both keep the order of the points
+        EXPECT_EQ(found, expected);
+    }
+    EXPECT_EQ(scan.rangeSearch(regions.back()).size(), 5000);
+}
+
+TEST(BruteForceTests, EDGE_CASES) {
+    // assert that points keep their order, and that empty searches, a
+    // query of other dimensions and a large k give what they can
+    vector<Point> points = {Point({1.0, 2.0}), Point({3.0, 4.0}),
+                            Point({5.0, 6.0})};
+    BruteForce scan;
+    EXPECT_TRUE(scan.findKNearestNeighbors(points[0], 1).empty());
+    EXPECT_TRUE(scan.rangeSearch({{0, 1}, {0, 1}}).empty());
+    scan.build(points);
+    for (size_t i = 0; i < points.size(); i++) {
+        EXPECT_EQ(scan.pointAt(i), points[i]);
+    }
+    EXPECT_TRUE(scan.findKNearestNeighbors(Point({1.0}), 1).empty());
+    EXPECT_TRUE(scan.findKNearestNeighbors(points[0], 0).empty());
+    vector<Point> all = scan.findKNearestNeighbors(Point({5.0, 5.0}), 10);
+    ASSERT_EQ(all.size(), 3);
+    EXPECT_EQ(all[0].distToQuery, 1);
+    EXPECT_EQ(all[2].distToQuery, 25);
+    EXPECT_TRUE(scan.findKNearestNeighbors(vector<Point>(), 1).empty());
+}
@@ -0,0 +1,188 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "DiskKDT.hpp"
+#include "KDT.hpp"
+#include "NaiveSearch.hpp"
+#include "Point.hpp"
+#include "PointFile.hpp"
+#include "PointGenerator.hpp"
+#include "util.hpp"
+
+using namespace std;
+using namespace testing;
+
+class DiskKDTFixture : public ::testing::Test {
+  protected:
+    vector<Point> build;
+    vector<Point> queries;
+    KDT kdt;
+    DiskKDT index;
+    string indexFile;
+
+  public:
+    DiskKDTFixture() {
+        build = readPoints("largeBuild.txt");
+        vector<Point> copy = build;
+        kdt.build(copy);
+        vector<Point> all = readPoints("largeQuery.txt");
+        queries.assign(all.begin(), all.begin() + 2000);
+        indexFile = "test_DiskKDT." + to_string(getpid()) + ".index";
+        // a budget of 1 KB gives buckets of at most 64 points
+        EXPECT_TRUE(DiskKDT::buildIndex(resolvePath("largeBuild.txt").c_str(),
+                                        indexFile.c_str(), 1024, 256));
+        EXPECT_TRUE(index.open(indexFile.c_str()));
+    }
+    ~DiskKDTFixture() { unlink(indexFile.c_str()); }
+};
+
+TEST_F(DiskKDTFixture, TEST_INDEX_SHAPE) {
+    // Assert that the index holds every point in many buckets
+    EXPECT_EQ(index.size(), build.size());
+    EXPECT_EQ(index.dimension(), kdt.dimension());
+    EXPECT_GE(index.numBuckets(), 16);
+    EXPECT_LE(index.largestBucket(), 64);
+    // the bucket files are removed
+    EXPECT_NE(access((indexFile + ".bucket.0").c_str(), F_OK), 0);
+}
+
+TEST_F(DiskKDTFixture, TEST_NEAREST_MATCHES_KDT) {
+    // Assert that the index finds the same neighbor distances as the KDT
+    for (Point& query : queries) {
+        vector<Point> expected = kdt.findKNearestNeighbors(query, 5);
+        vector<Point> found = index.findKNearestNeighbors(query, 5);
+        ASSERT_EQ(found.size(), expected.size());
+        for (unsigned int i = 0; i < found.size(); i++) {
+            EXPECT_EQ(found[i].distToQuery, expected[i].distToQuery);
+        }
+    }
+}
+
+TEST_F(DiskKDTFixture, TEST_NEAREST_VISITS_FEW_BUCKETS) {
+    // Assert that a search descends the top instead of visiting every
+    // bucket
+    unsigned long long visited = 0;
+    for (Point& query : queries) {
+        index.findKNearestNeighbors(query, 1, &visited);
+    }
+    EXPECT_LT(visited, queries.size() * index.numBuckets() / 4);
+}
+
+TEST_F(DiskKDTFixture, TEST_RANGE_MATCHES_KDT) {
+    // Assert that range searches return the same points as the KDT
+    for (unsigned int i = 0; i < 200; i++) {
+        const Point& center = queries[i];
+        vector<pair<double, double>> region;
+        for (double value : center.features) {
+            region.push_back(make_pair(value - 5, value + 5));
+        }
+        vector<Point> expected = kdt.rangeSearch(region);
+        vector<Point> found = index.rangeSearch(region);
+        auto byFeatures = [](const Point& a, const Point& b) {
+            return a.features < b.features;
+        };
+        sort(expected.begin(), expected.end(), byFeatures);
+        sort(found.begin(), found.end(), byFeatures);
+        ASSERT_EQ(found.size(), expected.size());
+        for (unsigned int j = 0; j < found.size(); j++) {
+            EXPECT_EQ(found[j].features, expected[j].features);
+        }
+    }
+}
+
+TEST(DiskKDTTests, TEST_OPEN_REJECTS_POINT_FILE) {
+    // Assert that a file that is not an index is refused
+    DiskKDT index;
+    EXPECT_FALSE(index.open(resolvePath("largeBuild.txt").c_str()));
+    EXPECT_FALSE(index.open("no such file"));
+    EXPECT_TRUE(index.findKNearestNeighbors(Point({1.0, 2.0}), 1).empty());
+}
+
+TEST_F(DiskKDTFixture, TEST_OPEN_CHECKS_TOP) {
+    // Assert that the index is written little-endian and that a top whose
+    // root points back at itself is refused
+    FILE* file = fopen(indexFile.c_str(), "r+b");
+    ASSERT_NE(file, nullptr);
+    unsigned char version[4];
+    ASSERT_EQ(fseek(file, 8, SEEK_SET), 0);
+    ASSERT_EQ(fread(version, 1, 4, file), 4u);
+    EXPECT_EQ(version[0], DISK_INDEX_VERSION);
+    EXPECT_EQ(version[1] | version[2] | version[3], 0);
+    // next of the root, after the header and the points
+    long root = sizeof(DiskIndexHeader) +
+                index.size() * index.dimension() * sizeof(double);
+    unsigned char zero[8] = {};
+    ASSERT_EQ(fseek(file, root + 16, SEEK_SET), 0);
+    ASSERT_EQ(fwrite(zero, 1, 8, file), 8u);
+    fclose(file);
+    DiskKDT corrupt;
+    EXPECT_FALSE(corrupt.open(indexFile.c_str()));
+}
+
+/** Build an index of workload with a budget of 64 buckets of its points,
+ *  and assert that every bucket fits the budget and that the index finds
+ *  the same neighbors as a KDT
+ */
+void checkBudgetKept(const PointWorkload& workload) {
+    PointSet points = generatePoints(workload);
+    string pointFile = "test_DiskKDT." + to_string(getpid()) + ".points";
+    string indexFile = pointFile + ".index";
+    ASSERT_TRUE(writeBinaryPoints(pointFile.c_str(), points));
+    size_t budget = points.size() / 64 * workload.numDim * sizeof(double);
+    EXPECT_TRUE(DiskKDT::buildIndex(pointFile.c_str(), indexFile.c_str(),
+                                    budget, 1 << 12));
+    DiskKDT index;
+    ASSERT_TRUE(index.open(indexFile.c_str()));
+    EXPECT_EQ(index.size(), points.size());
+    EXPECT_GE(index.numBuckets(), 64);
+    EXPECT_LE(index.largestBucket() * workload.numDim * sizeof(double),
+              budget);
+    vector<Point> all = points.toPoints();
+    KDT kdt;
+    kdt.build(all);
+    for (unsigned int i = 0; i < 200; i++) {
+        const Point& query = all[i * 997 % all.size()];
+        vector<Point> expected = kdt.findKNearestNeighbors(query, 3);
+        vector<Point> found = index.findKNearestNeighbors(query, 3);
+        ASSERT_EQ(found.size(), expected.size());
+        for (unsigned int j = 0; j < found.size(); j++) {
+            EXPECT_EQ(found[j].distToQuery, expected[j].distToQuery);
+        }
+    }
+    unlink(pointFile.c_str());
+    unlink(indexFile.c_str());
+}
+
+TEST(DiskKDTTests, TEST_LINE_KEEPS_BUDGET) {
+    // Assert that points equal in all but one dimension are split only on
+    // that one
+    checkBudgetKept(PointWorkload(LINE, 200000, 3));
+}
+
+TEST(DiskKDTTests, TEST_DUPLICATES_KEEP_BUDGET) {
+    // Assert that runs of equal points too large for a bucket are split
+    PointWorkload workload(DUPLICATES, 100000, 3);
+    workload.duplicateRate = 0.999;
+    checkBudgetKept(workload);
+    workload.duplicateRate = 1;
+    checkBudgetKept(workload);
+}
+
+TEST(DiskKDTTests, TEST_MALFORMED_INPUT_FAILS) {
+    // Assert that a point file with a value that is not a number is not
+    // indexed up to that value
+    string pointFile = "test_DiskKDT." + to_string(getpid()) + ".txt";
+    string indexFile = pointFile + ".index";
+    FILE* out = fopen(pointFile.c_str(), "w");
+    ASSERT_NE(out, nullptr);
+    fputs("1 2\n3 4\n5 x\n7 8\n", out);
+    fclose(out);
+    EXPECT_FALSE(DiskKDT::buildIndex(pointFile.c_str(), indexFile.c_str()));
+    DiskKDT index;
+    EXPECT_FALSE(index.open(indexFile.c_str()));
+    unlink(pointFile.c_str());
+    unlink(indexFile.c_str());
+}
@@ -8,6 +8,7 @@
 #include "KDT.hpp"
 #include "NaiveSearch.hpp"
 #include "Point.hpp"
+#include "PointGenerator.hpp"
 #include "util.hpp"
 
 using namespace std;
@@ -59,4 +60,165 @@ TEST_F(SmallKDTFixture, TEST_NEAREST_POINT) {
     Point queryPoint({5.81, 3.21});
     Point* closestPoint = naiveSearch.findNearestNeighbor(queryPoint);
     ASSERT_EQ(*kdt.findNearestNeighbor(queryPoint), *closestPoint);
-}
\ No newline at end of file
+}
+TEST_F(SmallKDTFixture, TEST_BOUNDING_BOX) {
+    // Assert that the bounding box covers exactly the built points
+    vector<pair<double, double>> box = kdt.getBoundingBox();
+    ASSERT_EQ(box.size(), 2);
+    EXPECT_DOUBLE_EQ(box[0].first, 1.0);
+    EXPECT_DOUBLE_EQ(box[0].second, 5.7);
+    EXPECT_DOUBLE_EQ(box[1].first, 1.0);
+    EXPECT_DOUBLE_EQ(box[1].second, 3.2);
+}
+
+/**
+ * Builds the same clustered data set into a plain KDT and a KDT with
+ * bounding box pruning, and compares both against naive search.
+ */
+class ClusteredKDTFixture : public ::testing::Test {
+  protected:
+    vector<Point> vec;
+    vector<Point> queries;
+    KDT kdt;
+    KDT boxKdt;
+    NaiveSearch naiveSearch;
+
+  public:
+    ClusteredKDTFixture() : boxKdt(true) {
+        srand(42);
+        for (int c = 0; c < 10; c++) {
+            double cx = rand() % 1000;
+            double cy = rand() % 1000;
+            double cz = rand() % 1000;
+            for (int i = 0; i < 200; i++) {
+                vec.emplace_back(Point({cx + (rand() % 100) / 100.0,
+                                        cy + (rand() % 100) / 100.0,
+                                        cz + (rand() % 100) / 100.0}));
+            }
+        }
+        for (int i = 0; i < 100; i++) {
+            queries.emplace_back(Point(
+                {(double)(rand() % 1000), (double)(rand() % 1000),
+                 (double)(rand() % 1000)}));
+        }
+        kdt.build(vec);
+        boxKdt.build(vec);
+        naiveSearch.build(vec);
+    }
+};
+
+TEST_F(ClusteredKDTFixture, TEST_BOX_NEAREST_POINT) {
+    // Assert that box pruning finds the same nearest neighbors
+    for (Point& query : queries) {
+        Point* closestPoint = naiveSearch.findNearestNeighbor(query);
+        ASSERT_EQ(*boxKdt.findNearestNeighbor(query), *closestPoint);
+        ASSERT_EQ(*kdt.findNearestNeighbor(query), *closestPoint);
+    }
+}
+
+TEST_F(ClusteredKDTFixture, TEST_BOX_VISITS_FEWER_NODES) {
+    // Expect box pruning to visit fewer nodes than plane pruning
+    unsigned long long planeVisits = 0;
+    unsigned long long boxVisits = 0;
+    for (Point& query : queries) {
+        kdt.findNearestNeighbor(query, &planeVisits);
+        boxKdt.findNearestNeighbor(query, &boxVisits);
+    }
+    EXPECT_LT(boxVisits, planeVisits);
+    EXPECT_EQ(kdt.boundingBoxBytes(), 0);
+    EXPECT_EQ(boxKdt.boundingBoxBytes(),
+              vec.size() * 3 * sizeof(pair<double, double>));
+}
+
+TEST_F(SmallKDTFixture, TEST_K_NEAREST_POINTS) {
+    // Assert that the neighbors come nearest first with their distances
+    Point queryPoint({4.0, 2.0});
+    vector<Point> neighbors = kdt.findKNearestNeighbors(queryPoint, 3);
+    ASSERT_EQ(neighbors.size(), 3);
+    EXPECT_EQ(neighbors[0], Point({4.4, 2.2}));
+    EXPECT_EQ(neighbors[1], Point({3.2, 1.0}));
+    EXPECT_EQ(neighbors[2], Point({5.7, 3.2}));
+    EXPECT_NEAR(neighbors[0].distToQuery, 0.2, 1e-9);
+    // Asking for more neighbors than points returns every point
+    EXPECT_EQ(kdt.findKNearestNeighbors(queryPoint, 10).size(), 5);
+}
+
+TEST_F(SmallKDTFixture, TEST_RANGE_SEARCH) {
+    // Assert that exactly the points inside the region are found
+    vector<pair<double, double>> region{{1.5, 4.5}, {1.0, 2.5}};
+    vector<Point> found = kdt.rangeSearch(region);
+    ASSERT_EQ(found.size(), 3);
+    for (const Point& p :
+         {Point({3.2, 1.0}), Point({1.8, 1.9}), Point({4.4, 2.2})}) {
+        EXPECT_NE(find(found.begin(), found.end(), p), found.end());
+    }
+}
+
+TEST_F(ClusteredKDTFixture, TEST_K_NEAREST_MATCHES_NAIVE) {
+    // Assert that the k nearest neighbors match a full sort by distance
+    for (Point& query : queries) {
+        vector<Point> all = vec;
+        for (Point& p : all) p.setDistToQuery(query);
+        sort(all.begin(), all.end(), [](const Point& a, const Point& b) {
+            return a.distToQuery < b.distToQuery;
+        });
+        vector<Point> neighbors = boxKdt.findKNearestNeighbors(query, 5);
+        ASSERT_EQ(neighbors.size(), 5);
+        for (unsigned int i = 0; i < neighbors.size(); i++) {
+            EXPECT_DOUBLE_EQ(neighbors[i].distToQuery, all[i].distToQuery);
+        }
+    }
+}
+
+TEST_F(ClusteredKDTFixture, TEST_RANGE_MATCHES_NAIVE) {
+    // Assert that range search finds as many points as naive search
+    for (Point& query : queries) {
+        vector<pair<double, double>> region;
+        for (double f : query.features) region.emplace_back(f - 150, f + 150);
+        EXPECT_EQ(kdt.rangeSearch(region).size(),
+                  naiveSearch.rangeSearch(region).size());
+    }
+}
+
+TEST(KDTWorkloadTests, TEST_EVERY_DISTRIBUTION_MATCHES_NAIVE) {
+    // Assert that nearest neighbors, k nearest neighbors and range search
+    // match naive search on every generated distribution, with and
+    // without box pruning
+    for (PointDistribution distribution : POINT_DISTRIBUTIONS) {
+        SCOPED_TRACE(distributionName(distribution));
+        vector<Point> vec =
+            generatePoints(PointWorkload(distribution, 2000, 3)).toPoints();
+        vector<Point> queries =
+            generatePoints(PointWorkload(distribution, 50, 3, 7)).toPoints();
+        KDT kdt;
+        KDT boxKdt(true);
+        NaiveSearch naiveSearch;
+        kdt.build(vec);
+        boxKdt.build(vec);
+        naiveSearch.build(vec);
+        ASSERT_EQ(kdt.size(), 2000);
+        for (Point& query : queries) {
+            double nearest =
+                naiveSearch.findNearestNeighbor(query)->distToQuery;
+            Point found = *kdt.findNearestNeighbor(query);
+            found.setDistToQuery(query);
+            ASSERT_DOUBLE_EQ(found.distToQuery, nearest);
+
+            vector<Point> all = vec;
+            for (Point& p : all) p.setDistToQuery(query);
+            sort(all.begin(), all.end(), [](const Point& a, const Point& b) {
+                return a.distToQuery < b.distToQuery;
+            });
+            vector<Point> neighbors = boxKdt.findKNearestNeighbors(query, 10);
+            ASSERT_EQ(neighbors.size(), 10);
+            for (unsigned int i = 0; i < neighbors.size(); i++) {
+                ASSERT_DOUBLE_EQ(neighbors[i].distToQuery, all[i].distToQuery);
+            }
+
+            vector<pair<double, double>> region;
+            for (double f : query.features) region.emplace_back(f - 5, f + 5);
+            ASSERT_EQ(kdt.rangeSearch(region).size(),
+                      naiveSearch.rangeSearch(region).size());
+        }
+    }
+}
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "PointFile.hpp"
+#include "PointReader.hpp"
+#include "util.hpp"
+
+using namespace std;
+using namespace testing;
+
+/**
+ * A small point set with ids, and a temporary file name to write it to.
+ */
+class PointFileFixture : public ::testing::Test {
+  protected:
+    PointSet points;
+    string name;
+
+  public:
+    PointFileFixture() {
+        points.numDim = 3;
+        points.coords = {1.5, -2.25, 3, 1e-300, 0.1, -7e10, 4, 5, 6};
+        points.ids = {10, 20, 30};
+        name = "/tmp/point_file_test_" + to_string(getpid()) + ".bin";
+    }
+
+    ~PointFileFixture() { remove(name.c_str()); }
+};
+
+TEST_F(PointFileFixture, TEST_FLOAT64_ROUND_TRIP) {
+    // Assert that float64 files read back exactly, with their ids
+    ASSERT_TRUE(writeBinaryPoints(name.c_str(), points));
+    EXPECT_TRUE(isBinaryPointFile(name.c_str()));
+    PointSet loaded;
+    ASSERT_TRUE(loadPoints(name.c_str(), loaded));
+    EXPECT_EQ(loaded.numDim, 3);
+    EXPECT_EQ(loaded.coords, points.coords);
+    EXPECT_EQ(loaded.ids, points.ids);
+}
+
+TEST_F(PointFileFixture, TEST_FLOAT32_ROUND_TRIP) {
+    // Assert that float32 files read back rounded to float, without ids
+    points.ids.clear();
+    ASSERT_TRUE(writeBinaryPoints(name.c_str(), points, FLOAT32));
+    PointSet loaded;
+    ASSERT_TRUE(readBinaryPoints(name.c_str(), loaded));
+    ASSERT_EQ(loaded.size(), 3);
+    EXPECT_TRUE(loaded.ids.empty());
+    for (size_t i = 0; i < points.coords.size(); i++) {
+        EXPECT_EQ(loaded.coords[i], (double)(float)points.coords[i]);
+    }
+    ifstream in(name, ios::binary | ios::ate);
+    EXPECT_EQ(in.tellg(), sizeof(PointFileHeader) + 9 * sizeof(float));
+}
+
+TEST_F(PointFileFixture, TEST_TRUNCATED_FILE) {
+    // Assert that a file shorter than its header promises is rejected
+    ASSERT_TRUE(writeBinaryPoints(name.c_str(), points));
+    ASSERT_EQ(truncate(name.c_str(), sizeof(PointFileHeader) + 16), 0);
+    PointSet loaded;
+    EXPECT_FALSE(readBinaryPoints(name.c_str(), loaded));
+    EXPECT_EQ(loaded.size(), 0);
+    vector<Point> loadedPoints;
+    EXPECT_FALSE(loadPoints(name.c_str(), loadedPoints));
+    EXPECT_TRUE(loadedPoints.empty());
+}
+
+TEST_F(PointFileFixture, TEST_TEXT_FILE_DETECTED) {
+    // Assert that text files are still loaded through the text parser
+    ofstream(name) << "1 2\n3 4\n";
+    EXPECT_FALSE(isBinaryPointFile(name.c_str()));
+    PointSet loaded;
+    ASSERT_TRUE(loadPoints(name.c_str(), loaded));
+    EXPECT_EQ(loaded.coords, vector<double>({1, 2, 3, 4}));
+}
+
+TEST_F(PointFileFixture, TEST_DATA_FILE_ROUND_TRIP) {
+    // Assert that a converted data file gives the same points
+    PointSet text;
+    ASSERT_TRUE(loadPoints(resolvePath("largeBuild.txt").c_str(), text));
+    ASSERT_TRUE(writeBinaryPoints(name.c_str(), text));
+    vector<Point> binary = readPoints(name.c_str());
+    ASSERT_EQ(binary.size(), 1000);
+    EXPECT_EQ(binary, text.toPoints());
+}
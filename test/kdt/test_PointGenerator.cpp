@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <cstdio>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "PointFile.hpp"
+#include "PointGenerator.hpp"
+#include "util.hpp"
+
+using namespace std;
+using namespace testing;
+
+TEST(PointGeneratorTests, SEED_TEST) {
+    // assert that every distribution gives count points of numDim values,
+    // the same ones for the same seed and others for another seed
+    for (PointDistribution distribution : POINT_DISTRIBUTIONS) {
+        PointWorkload workload(distribution, 1000, 3, 7);
+        PointSet points = generatePoints(workload);
+        ASSERT_EQ(points.numDim, 3) << distributionName(distribution);
+        ASSERT_EQ(points.size(), 1000) << distributionName(distribution);
+        EXPECT_EQ(generatePoints(workload).coords, points.coords);
+        workload.seed = 8;
+        if (distribution != GRID) {
+            EXPECT_NE(generatePoints(workload).coords, points.coords)
+                << distributionName(distribution);
+        }
+    }
+    EXPECT_EQ(generatePoints(PointWorkload(UNIFORM, 0, 3)).size(), 0);
+}
+
+TEST(PointGeneratorTests, NAME_TEST) {
+    // assert that the names parse back to their distributions
+    for (PointDistribution distribution : POINT_DISTRIBUTIONS) {
+        PointDistribution parsed = UNIFORM;
+        ASSERT_TRUE(parseDistribution(distributionName(distribution), parsed));
+        EXPECT_EQ(parsed, distribution);
+    }
+    PointDistribution parsed = GRID;
+    EXPECT_FALSE(parseDistribution("gaussian", parsed));
+    EXPECT_EQ(parsed, GRID);
+}
+
+TEST(PointGeneratorTests, SHAPE_TEST) {
+    // assert that every distribution has the shape it promises
+    PointWorkload workload(UNIFORM, 10000, 2);
+    PointSet uniform = generatePoints(workload);
+    for (double x : uniform.coords) {
+        ASSERT_GE(x, workload.min);
+        ASSERT_LT(x, workload.max);
+    }
+
+    workload.distribution = DUPLICATES;
+    PointSet duplicates = generatePoints(workload);
+    set<pair<double, double>> distinct;
+    for (size_t i = 0; i < duplicates.size(); i++) {
+        distinct.insert({duplicates.valueAt(i, 0), duplicates.valueAt(i, 1)});
+    }
+    EXPECT_EQ(distinct.size(), 1000);
+
+    workload.distribution = LINE;
+    PointSet line = generatePoints(workload);
+    for (size_t i = 0; i < line.size(); i++) {
+        ASSERT_EQ(line.valueAt(i, 1), line.valueAt(0, 1));
+    }
+    EXPECT_NE(line.valueAt(0, 0), line.valueAt(1, 0));
+
+    workload.distribution = GRID;
+    PointSet grid = generatePoints(workload);
+    // a 100 x 100 grid with a step of 2, filled row by row
+    EXPECT_EQ(grid.valueAt(0, 0), -100);
+    EXPECT_EQ(grid.valueAt(1, 1), -98);
+    EXPECT_EQ(grid.valueAt(100, 0), -98);
+    EXPECT_EQ(grid.valueAt(9999, 1), 98);
+
+    workload.distribution = CLUSTERED;
+    PointSet clustered = generatePoints(workload);
+    set<pair<long, long>> cells;
+    for (size_t i = 0; i < clustered.size(); i++) {
+        cells.insert({lround(clustered.valueAt(i, 0) / 10),
+                      lround(clustered.valueAt(i, 1) / 10)});
+    }
+    // 8 clusters of deviation 0.4 fill a few of the 400 cells of 10 x 10
+    EXPECT_LE(cells.size(), 32);
+
+    workload.distribution = OUTLIERS;
+    PointSet outliers = generatePoints(workload);
+    size_t outside = 0;
+    for (size_t i = 0; i < outliers.size(); i++) {
+        outside += abs(outliers.valueAt(i, 0)) > 100 ||
+                   abs(outliers.valueAt(i, 1)) > 100;
+    }
+    EXPECT_GT(outside, 50);
+    EXPECT_LT(outside, 150);
+}
+
+TEST(PointGeneratorTests, WRITE_TEST) {
+    // assert that generated points read back the same in both formats
+    string name = "/tmp/point_generator_test_" + to_string(getpid());
+    PointSet points = generatePoints(PointWorkload(CLUSTERED, 500, 4));
+    ASSERT_TRUE(writeTextPoints((name + ".txt").c_str(), points));
+    ASSERT_TRUE(writeBinaryPoints((name + ".bin").c_str(), points));
+    for (string file : {name + ".txt", name + ".bin"}) {
+        PointSet loaded;
+        ASSERT_TRUE(loadPoints(file.c_str(), loaded)) << file;
+        EXPECT_EQ(loaded.numDim, 4);
+        EXPECT_EQ(loaded.coords, points.coords) << file;
+        remove(file.c_str());
+    }
+}
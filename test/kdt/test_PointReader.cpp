@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Point.hpp"
+#include "PointReader.hpp"
+#include "util.hpp"
+
+using namespace std;
+using namespace testing;
+
+/** Write content to a temporary file and return its name */
+string writeTempFile(const string& content) {
+    string name = "/tmp/point_reader_test_" + to_string(getpid()) + ".txt";
+    ofstream out(name, ios::binary);
+    out << content;
+    return name;
+}
+
+TEST(PointReaderTests, TEST_PARSE_DOUBLE) {
+    // Assert that numbers parse like strtod and stop at the right place
+    for (string s : {"0", "-29.5012715299", "89.7906692941", "+1e3", "2.5E-4",
+                     "0.000000000000000000000000123", "123456789012345678901",
+                     "-0.1", "7."}) {
+        double value = 0;
+        const char* end = parseDouble(s.data(), s.data() + s.size(), value);
+        EXPECT_EQ(end, s.data() + s.size()) << s;
+        EXPECT_EQ(value, strtod(s.c_str(), nullptr)) << s;
+    }
+    string bad = "abc";
+    double value = 0;
+    EXPECT_EQ(parseDouble(bad.data(), bad.data() + bad.size(), value),
+              bad.data());
+}
+
+TEST(PointReaderTests, TEST_LOAD_SMALL_FILE) {
+    // Assert that CRLF lines, extra spaces and a missing final newline work
+    string name = writeTempFile("1 2 3\r\n  4.5\t-6 7e1\r\n8 9 10");
+    PointSet points;
+    ASSERT_TRUE(loadPointSet(name.c_str(), points));
+    remove(name.c_str());
+    ASSERT_EQ(points.numDim, 3);
+    ASSERT_EQ(points.size(), 3);
+    EXPECT_DOUBLE_EQ(points.valueAt(1, 0), 4.5);
+    EXPECT_DOUBLE_EQ(points.valueAt(1, 1), -6);
+    EXPECT_DOUBLE_EQ(points.valueAt(1, 2), 70);
+    EXPECT_DOUBLE_EQ(points.valueAt(2, 2), 10);
+}
+
+TEST(PointReaderTests, TEST_STOP_AT_BAD_VALUE) {
+    // Assert that reading stops at a bad value and drops incomplete points
+    string name = writeTempFile("1 2\n3 4\n5 x\n7 8\n");
+    PointSet points;
+    ASSERT_TRUE(loadPointSet(name.c_str(), points));
+    remove(name.c_str());
+    EXPECT_EQ(points.size(), 2);
+}
+
+TEST(PointReaderTests, TEST_EMPTY_FILE) {
+    // Assert that an empty file gives an empty set, like reading it with >>
+    string name = writeTempFile("");
+    PointSet points;
+    points.numDim = 2;
+    points.coords.assign(4, 1.0);
+    ASSERT_TRUE(loadPointSet(name.c_str(), points));
+    remove(name.c_str());
+    EXPECT_EQ(points.numDim, 0);
+    EXPECT_EQ(points.size(), 0);
+}
+
+TEST(PointReaderTests, TEST_MISSING_FILE) {
+    // Assert that a file that does not exist is reported
+    PointSet points;
+    EXPECT_FALSE(loadPointSet("/nonexistent/points.txt", points));
+}
+
+TEST(PointReaderTests, TEST_PARALLEL_MATCHES_STREAM) {
+    // Assert that a file parsed in many chunks matches reading it with >>
+    stringstream content;
+    content.precision(17);
+    srand(7);
+    for (int i = 0; i < 200000; i++) {
+        content << (rand() - RAND_MAX / 2) / 1000.0 << " "
+                << rand() / (double)RAND_MAX << "\n";
+    }
+    string name = writeTempFile(content.str());
+    PointSet points;
+    ASSERT_TRUE(loadPointSet(name.c_str(), points, 8));
+    remove(name.c_str());
+
+    ASSERT_EQ(points.numDim, 2);
+    ASSERT_EQ(points.size(), 200000);
+    double value = 0;
+    for (size_t i = 0; content >> value; i++) {
+        ASSERT_EQ(points.coords[i], value) << i;
+    }
+}
+
+TEST(PointReaderTests, TEST_DATA_FILE) {
+    // Assert that the query data file loads completely
+    vector<Point> points = readPoints("largeQuery.txt");
+    ASSERT_EQ(points.size(), 250000);
+    EXPECT_EQ(points[0], Point({-99.8, -99.8}));
+    EXPECT_EQ(points[2], Point({-99.8, -99}));
+}
@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "KDT.hpp"
+#include "Point.hpp"
+#include "QueryProtocol.hpp"
+#include "QueryServer.hpp"
+
+using namespace std;
+using namespace testing;
+
+/**
+ * Serves a small KD tree on a unix socket and connects one client to it.
+ */
+class QueryServerFixture : public ::testing::Test {
+  protected:
+    vector<Point> vec;
+    KDT kdt;
+    QueryServer server;
+    string address;
+    int fd;
+
+  public:
+    QueryServerFixture() : server(kdt, 2, 8, 50), fd(-1) {
+        vec.emplace_back(Point({1.0, 3.2}));
+        vec.emplace_back(Point({3.2, 1.0}));
+        vec.emplace_back(Point({5.7, 3.2}));
+        vec.emplace_back(Point({1.8, 1.9}));
+        vec.emplace_back(Point({4.4, 2.2}));
+        kdt.build(vec);
+        address = "unix:/tmp/kdt_test_" + to_string(getpid()) + ".sock";
+    }
+
+    void SetUp() {
+        ASSERT_TRUE(server.start(address));
+        fd = openConnection(address);
+        ASSERT_GE(fd, 0);
+    }
+
+    void TearDown() {
+        if (fd >= 0) close(fd);
+        server.stop();
+        unlink(address.c_str() + 5);
+    }
+
+    QueryRequest request(uint32_t id, QueryType type, uint32_t k,
+                         vector<double> values) {
+        QueryRequest req;
+        req.header = {};
+        req.header.id = id;
+        req.header.type = type;
+        req.header.k = k;
+        req.header.numDim = type == RANGE_QUERY ? values.size() / 2
+                                                : values.size();
+        req.values = values;
+        return req;
+    }
+};
+
+TEST_F(QueryServerFixture, TEST_PIPELINED_QUERIES) {
+    // Assert that pipelined requests are all answered like the tree would
+    vector<char> buf;
+    appendRequest(buf, request(0, NN_QUERY, 0, {5.81, 3.21}));
+    appendRequest(buf, request(1, KNN_QUERY, 3, {4.0, 2.0}));
+    appendRequest(buf, request(2, RANGE_QUERY, 0, {1.5, 4.5, 1.0, 2.5}));
+    ASSERT_TRUE(writeFully(fd, buf.data(), buf.size()));
+
+    SocketReader in(fd);
+    vector<QueryResponse> responses(3);
+    for (int i = 0; i < 3; i++) {
+        QueryResponse response;
+        ASSERT_TRUE(readResponse(in, response));
+        ASSERT_LT(response.header.id, 3);
+        EXPECT_EQ(response.header.status, QUERY_OK);
+        responses[response.header.id] = response;
+    }
+
+    ASSERT_EQ(responses[0].header.numPoints, 1);
+    EXPECT_DOUBLE_EQ(responses[0].values[1], 5.7);
+    EXPECT_DOUBLE_EQ(responses[0].values[2], 3.2);
+
+    ASSERT_EQ(responses[1].header.numPoints, 3);
+    vector<Point> knn = kdt.findKNearestNeighbors(Point({4.0, 2.0}), 3);
+    for (unsigned int i = 0; i < 3; i++) {
+        EXPECT_DOUBLE_EQ(responses[1].values[3 * i], knn[i].distToQuery);
+        EXPECT_DOUBLE_EQ(responses[1].values[3 * i + 1], knn[i].features[0]);
+    }
+
+    EXPECT_EQ(responses[2].header.numPoints, 3);
+}
+
+TEST_F(QueryServerFixture, TEST_BAD_REQUEST) {
+    // Assert that a query of the wrong dimension is rejected
+    vector<char> buf;
+    appendRequest(buf, request(7, NN_QUERY, 0, {1.0, 2.0, 3.0}));
+    ASSERT_TRUE(writeFully(fd, buf.data(), buf.size()));
+
+    SocketReader in(fd);
+    QueryResponse response;
+    ASSERT_TRUE(readResponse(in, response));
+    EXPECT_EQ(response.header.id, 7);
+    EXPECT_EQ(response.header.status, QUERY_BAD_REQUEST);
+    EXPECT_EQ(response.header.numPoints, 0);
+}
+
+TEST_F(QueryServerFixture, TEST_MANY_REQUESTS_ARE_BATCHED) {
+    // Assert that every request is answered and some share a batch
+    const uint32_t NUM_REQUESTS = 1000;
+    vector<char> buf;
+    for (uint32_t i = 0; i < NUM_REQUESTS; i++) {
+        appendRequest(buf, request(i, NN_QUERY, 0, {i % 7 * 1.0, 2.0}));
+    }
+    ASSERT_TRUE(writeFully(fd, buf.data(), buf.size()));
+
+    SocketReader in(fd);
+    vector<bool> seen(NUM_REQUESTS);
+    for (uint32_t i = 0; i < NUM_REQUESTS; i++) {
+        QueryResponse response;
+        ASSERT_TRUE(readResponse(in, response));
+        ASSERT_LT(response.header.id, NUM_REQUESTS);
+        EXPECT_FALSE(seen[response.header.id]);
+        seen[response.header.id] = true;
+    }
+    EXPECT_EQ(server.requestsServed(), NUM_REQUESTS);
+    EXPECT_LT(server.batchesServed(), NUM_REQUESTS);
+}
+
+TEST(QueryServerTests, TEST_LISTENER_KEEPS_REGULAR_FILE) {
+    // Assert that a unix address naming a regular file fails to listen
+    // and leaves the file alone, while a stale socket is replaced
+    string path = "/tmp/kdt_test_file_" + to_string(getpid());
+    ofstream(path) << "data";
+    EXPECT_LT(openListener("unix:" + path), 0);
+    EXPECT_EQ(access(path.c_str(), F_OK), 0);
+    unlink(path.c_str());
+
+    int fd = openListener("unix:" + path);
+    ASSERT_GE(fd, 0);
+    close(fd);
+    fd = openListener("unix:" + path);
+    EXPECT_GE(fd, 0);
+    if (fd >= 0) close(fd);
+    unlink(path.c_str());
+}
@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "KDT.hpp"
+#include "NaiveSearch.hpp"
+#include "Point.hpp"
+#include "QueryStream.hpp"
+#include "util.hpp"
+
+using namespace std;
+using namespace testing;
+
+/** Return a pipe whose read end yields content */
+int pipeFrom(const string& content) {
+    int fds[2];
+    if (pipe(fds) != 0) return -1;
+    // small contents fit in the pipe buffer, no writer thread is needed
+    if (write(fds[1], content.data(), content.size()) !=
+        (ssize_t)content.size()) {
+        return -1;
+    }
+    close(fds[1]);
+    return fds[0];
+}
+
+TEST(QueryStreamTests, TEST_FORMAT_MATCHES_OPERATOR) {
+    // Assert that formatted points look like operator<< prints them
+    Point p({-99.8, 0.0000004, 123456789.123456789, 1e20});
+    vector<char> out(maxFormattedLength(p.numDim));
+    size_t len = formatPoint(out.data(), p.features, p.numDim);
+    stringstream expected;
+    expected << p << "\n";
+    EXPECT_EQ(string(out.data(), len), expected.str());
+}
+
+TEST(QueryStreamTests, TEST_READER_SMALL_BUFFER) {
+    // Assert that values split across buffer refills are read whole
+    int fd = pipeFrom("1.25 -2.5\r\n  3e2\t4\n5.000001 6\n7");
+    ASSERT_GE(fd, 0);
+    QueryReader reader(fd, 2, 4);
+    vector<double> out(4);
+    ASSERT_EQ(reader.readPoints(out.data(), 2), 2);
+    EXPECT_EQ(out, vector<double>({1.25, -2.5, 300, 4}));
+    ASSERT_EQ(reader.readPoints(out.data(), 2), 1);
+    EXPECT_EQ(out[0], 5.000001);
+    EXPECT_EQ(out[1], 6);
+    // the incomplete last point is dropped
+    EXPECT_EQ(reader.readPoints(out.data(), 2), 0);
+    close(fd);
+}
+
+TEST(QueryStreamTests, TEST_STREAM_MATCHES_NAIVE) {
+    // Assert that streamed answers come in input order and are correct
+    vector<Point> build = readPoints("largeBuild.txt");
+    KDT kdt;
+    kdt.build(build);
+    NaiveSearch naiveSearch;
+    naiveSearch.build(build);
+
+    stringstream queries;
+    stringstream expected;
+    for (int i = 0; i < 2000; i++) {
+        Point query({(i % 41) * 5.0 - 100, (i / 41) * 4.0 - 100});
+        queries << query.features[0] << " " << query.features[1] << "\n";
+        expected << *naiveSearch.findNearestNeighbor(query) << "\n";
+    }
+    int fd = pipeFrom(queries.str());
+    ASSERT_GE(fd, 0);
+    string name = "/tmp/query_stream_test_" + to_string(getpid()) + ".txt";
+    FILE* out = fopen(name.c_str(), "w");
+    // small blocks so that several threads answer blocks out of order
+    EXPECT_EQ(streamNearestNeighbors(kdt, fd, out, 4, 7), 2000);
+    fclose(out);
+    close(fd);
+
+    ifstream in(name);
+    stringstream actual;
+    actual << in.rdbuf();
+    remove(name.c_str());
+    EXPECT_EQ(actual.str(), expected.str());
+}
+
+TEST(QueryStreamTests, TEST_STREAM_REPORTS_BAD_INPUT) {
+    // Assert that the queries before a bad value are answered and the
+    // failure is reported, and that a clean stream does not fail
+    vector<Point> build = readPoints("largeBuild.txt");
+    KDT kdt;
+    kdt.build(build);
+    FILE* out = fopen("/dev/null", "w");
+    ASSERT_NE(out, nullptr);
+    bool failed = false;
+    int fd = pipeFrom("1 2\n3 4\n5 x\n6 7\n");
+    ASSERT_GE(fd, 0);
+    EXPECT_EQ(streamNearestNeighbors(kdt, fd, out, 2, 1, &failed), 2);
+    EXPECT_TRUE(failed);
+    close(fd);
+
+    fd = pipeFrom("1 2\n3 4\n");
+    ASSERT_GE(fd, 0);
+    EXPECT_EQ(streamNearestNeighbors(kdt, fd, out, 2, 1, &failed), 2);
+    EXPECT_FALSE(failed);
+    close(fd);
+
+    // a binary header that promises more points than follow
+    PointSet points;
+    points.numDim = 2;
+    points.coords = {1, 2, 3, 4, 5, 6};
+    string name = "/tmp/query_stream_short_" + to_string(getpid()) + ".bin";
+    ASSERT_TRUE(writeBinaryPoints(name.c_str(), points));
+    ASSERT_EQ(truncate(name.c_str(), sizeof(PointFileHeader) +
+                                         3 * sizeof(double)), 0);
+    fd = open(name.c_str(), O_RDONLY);
+    ASSERT_GE(fd, 0);
+    EXPECT_EQ(streamNearestNeighbors(kdt, fd, out, 2, 1, &failed), 1);
+    EXPECT_TRUE(failed);
+    close(fd);
+    remove(name.c_str());
+    fclose(out);
+}
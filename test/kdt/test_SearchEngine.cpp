@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "BruteForce.hpp"
+#include "Point.hpp"
+#include "PointGenerator.hpp"
+#include "SearchEngine.hpp"
+#include "util.hpp"
+
+using namespace std;
+using namespace testing;
+
+TEST(SearchEngineTests, CHOOSE_TEST) {
+    // assert that few queries and many dimensions stay on the scan, and
+    // that many low dimensional queries over many points use the tree
+    SearchEngine engine;
+    engine.build(generatePoints(PointWorkload(UNIFORM, 100000, 2)).toPoints());
+    EXPECT_EQ(engine.choose(1, 10), SearchEngine::BRUTE_FORCE);
+    EXPECT_EQ(engine.choose(10000, 10), SearchEngine::KD_TREE);
+
+    engine.build(generatePoints(PointWorkload(UNIFORM, 2000, 32)).toPoints());
+    EXPECT_EQ(engine.choose(1, 10), SearchEngine::BRUTE_FORCE);
+    EXPECT_EQ(engine.choose(100000, 10), SearchEngine::BRUTE_FORCE);
+}
+
+TEST(SearchEngineTests, LAZY_TREE_TEST) {
+    // assert that the tree is built by the first batch that needs it, and
+    // that both methods find the same distances
+    vector<Point> points =
+        generatePoints(PointWorkload(CLUSTERED, 20000, 2)).toPoints();
+    vector<Point> queries =
+        generatePoints(PointWorkload(UNIFORM, 2000, 2, 5)).toPoints();
+    SearchEngine engine;
+    engine.build(points);
+    ASSERT_EQ(engine.size(), 20000);
+    EXPECT_FALSE(engine.hasTree());
+
+    vector<Point> few(queries.begin(), queries.begin() + 2);
+    vector<vector<Point>> scanned = engine.findKNearestNeighbors(few, 5);
+    EXPECT_EQ(engine.lastMethod(), SearchEngine::BRUTE_FORCE);
+    EXPECT_FALSE(engine.hasTree());
+
+    vector<vector<Point>> found = engine.findKNearestNeighbors(queries, 5, 4);
+    EXPECT_EQ(engine.lastMethod(), SearchEngine::KD_TREE);
+    EXPECT_TRUE(engine.hasTree());
+
+    BruteForce scan;
+    scan.build(points);
+    vector<vector<Point>> expected = scan.findKNearestNeighbors(queries, 5);
+    ASSERT_EQ(found.size(), expected.size());
+    for (size_t i = 0; i < queries.size(); i++) {
+        ASSERT_EQ(found[i].size(), 5);
+        for (size_t j = 0; j < 5; j++) {
+            EXPECT_EQ(found[i][j].distToQuery, expected[i][j].distToQuery);
+        }
+    }
+    for (size_t i = 0; i < few.size(); i++) {
+        EXPECT_EQ(scanned[i], expected[i]);
+    }
+
+    // a new build drops the tree
+    engine.build(points);
+    EXPECT_FALSE(engine.hasTree());
+}
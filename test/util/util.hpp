@@ -8,6 +8,7 @@
 #include <vector>
 #include "BST.hpp"
 #include "KDT.hpp"
+#include "PointFile.hpp"
 
 /**
  * Read one data from file stream to vector
@@ -89,39 +90,22 @@ void insertIntoBST(vector<T>& vec, BST<T>& bst) {
 }
 
 /**
- *  Read all lines from the file and convert them to a vector
- *  of data points
+ * Return the path under which filename can be opened, trying the same
+ * directories as checkValidFile()
  */
-vector<Point> readPoints(const char* fileName) {
-    vector<Point> result;
-    string line;
-    unsigned int numDim = 0;
-    double data = 0;
-
-    ifstream in(fileName);
-    checkValidFile(in, fileName);
-
-    // count number of dimensions
-    getline(in, line);
-    stringstream lineStream(line);
-    while (lineStream >> data) numDim++;
-
-    // Resets the stream to beginning of file
-    in.seekg(0, ios_base::beg);
-
-    // read the data and convert them to data points
-    while (!in.eof()) {
-        vector<double> features;
-        for (unsigned int i = 0; i < numDim; i++) {
-            in >> data;
-            if (!in.fail()) {
-                features.push_back(data);
-            }
-        }
-        if (!in.fail()) {
-            result.push_back(Point(features));
-        }
+string resolvePath(string filename) {
+    for (string prefix : {"", "data/", "../data/"}) {
+        if (ifstream(prefix + filename).is_open()) return prefix + filename;
     }
-    in.close();
-    return result;
-}
\ No newline at end of file
+    return filename;
+}
+
+/**
+ *  Read all points from a text or binary point file and convert them
+ *  to a vector of data points
+ */
+vector<Point> readPoints(const char* fileName) {
+    vector<Point> points;
+    EXPECT_TRUE(loadPoints(resolvePath(fileName).c_str(), points));
+    return points;
+}